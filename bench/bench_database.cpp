@@ -0,0 +1,73 @@
+// bench_database.cpp
+// Start-up cost of the scan database: open() (string table and tail check)
+// and load_file() (every host record decoded and upserted) for files of
+// range(0) hosts with three open ports each, written in batches of 256.
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+
+#include "../src/database.hpp"
+
+namespace {
+
+DeviceInfo make_device(uint32_t i) {
+    IpAddress ip;
+    ip.family = 4;
+    ip.bytes[0] = 10;
+    ip.bytes[1] = static_cast<uint8_t>(i >> 16);
+    ip.bytes[2] = static_cast<uint8_t>(i >> 8);
+    ip.bytes[3] = static_cast<uint8_t>(i);
+    MacAddress mac;
+    mac.set = true;
+    mac.bytes = {0x02, 0, 0, static_cast<uint8_t>(i >> 16), static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i)};
+    std::vector<Port> ports = {Port(22, Protocol::Tcp, PortState::Open, "ssh"),
+                               Port(80, Protocol::Tcp, PortState::Open, "http"),
+                               Port(443, Protocol::Tcp, PortState::Open, "https")};
+    DeviceInfo device(ip, mac, i % 3 ? "Vendor A" : "Vendor B", "host-" + std::to_string(i), std::move(ports), "Linux");
+    device.lastScanned = 1700000000 + i;
+    return device;
+}
+
+// Database of `hosts` hosts in /16 networks, written once per size
+std::string database_file(uint32_t hosts) {
+    const auto path = std::filesystem::temp_directory_path() / ("nmapvis_bench_" + std::to_string(hosts) + ".nvdb");
+    if (std::filesystem::exists(path)) return path.string();
+    ScanDatabase database;
+    database.open(path.string());
+    std::vector<DeviceInfo> batch;
+    for (uint32_t i = 0; i < hosts; i++) {
+        batch.push_back(make_device(i));
+        if (batch.size() == 256 || i + 1 == hosts) {
+            database.append("10." + std::to_string(i >> 16) + ".0.0/16", batch);
+            batch.clear();
+        }
+    }
+    return path.string();
+}
+
+} // namespace
+
+static void BM_Open(benchmark::State& state) {
+    const std::string path = database_file(static_cast<uint32_t>(state.range(0)));
+    for (auto _ : state) {
+        ScanDatabase database;
+        database.open(path);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(std::filesystem::file_size(path)));
+}
+BENCHMARK(BM_Open)->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+static void BM_Load(benchmark::State& state) {
+    const std::string path = database_file(static_cast<uint32_t>(state.range(0)));
+    size_t hosts = 0;
+    for (auto _ : state) {
+        NetworkStore store;
+        hosts += ScanDatabase::load_file(path, store);
+        benchmark::DoNotOptimize(store.snapshot()->device_count());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(std::filesystem::file_size(path)));
+    state.counters["hosts/s"] = benchmark::Counter(static_cast<double>(hosts), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Load)->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
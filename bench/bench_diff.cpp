@@ -0,0 +1,56 @@
+// bench_diff.cpp
+// Diff of two 100k-host snapshots of one network: a rescan that replaced
+// every record (no shared pointers) with 1% of hosts added, removed or with
+// changed ports, and the copy-on-write case where only those 1% are new
+// records.
+#include <benchmark/benchmark.h>
+
+#include "../src/diff.hpp"
+
+namespace {
+
+std::shared_ptr<const DeviceInfo> make_device(uint32_t i, bool changed) {
+    IpAddress ip;
+    ip.family = 4;
+    ip.bytes[0] = 10;
+    ip.bytes[1] = static_cast<uint8_t>(i >> 16);
+    ip.bytes[2] = static_cast<uint8_t>(i >> 8);
+    ip.bytes[3] = static_cast<uint8_t>(i);
+    std::vector<Port> ports{Port(22, Protocol::Tcp, PortState::Open, "ssh"),
+                            Port(443, Protocol::Tcp, changed ? PortState::Closed : PortState::Open, "https")};
+    if (changed) ports.emplace_back(8080, Protocol::Tcp, PortState::Open, "http-proxy");
+    return std::make_shared<const DeviceInfo>(ip, MacAddress(), "Vendor", "Unknown", std::move(ports), "Linux");
+}
+
+struct Pair {
+    NetworkData before, after;
+};
+
+Pair make_pair(size_t hosts, bool share_unchanged) {
+    std::vector<std::shared_ptr<const DeviceInfo>> before, after;
+    for (uint32_t i = 0; i < hosts; i++) {
+        auto device = make_device(i, false);
+        before.push_back(device);
+        if (i % 300 == 0) continue;                               // removed
+        const bool changed = i % 300 == 1;
+        after.push_back(share_unchanged && !changed ? device : make_device(i, changed));
+    }
+    for (uint32_t i = 0; i < hosts / 300; i++) after.push_back(make_device(static_cast<uint32_t>(hosts) + i, false));  // added
+    return Pair{make_network("10.0.0.0/8", before), make_network("10.0.0.0/8", after)};
+}
+
+} // namespace
+
+static void BM_Diff(benchmark::State& state) {
+    const Pair pair = make_pair(static_cast<size_t>(state.range(0)), state.range(1) != 0);
+    NetworkDiff diff;
+    for (auto _ : state) {
+        diff = diff_networks(&pair.before, &pair.after);
+        benchmark::DoNotOptimize(diff.hosts.data());
+    }
+    state.counters["changes"] = static_cast<double>(diff.hosts.size());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Diff)->Args({100000, 0})->Args({100000, 1})->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
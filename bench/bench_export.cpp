@@ -0,0 +1,52 @@
+// bench_export.cpp
+// Exporting 100k generated hosts in each format, single-threaded and on every
+// core. Output goes to /dev/null so the numbers are formatting, not disk.
+#include <benchmark/benchmark.h>
+
+#include <thread>
+
+#include "../src/utils.hpp"
+#include "../src/export.hpp"
+#include "xml_generator.hpp"
+
+namespace {
+
+constexpr size_t kHosts = 100000;
+
+std::shared_ptr<const StoreSnapshot> corpus() {
+    static std::shared_ptr<const StoreSnapshot> snapshot = [] {
+        NetworkStore store;
+        std::vector<DeviceInfo> devices = parse_nmap_xml(xml_generator::generate(10u << 24, kHosts, 1));
+        std::unordered_map<std::string, std::vector<DeviceInfo>> by_network;
+        for (auto& device : devices) {
+            const std::string cidr = "10." + std::to_string(device.ipAddress.bytes[1]) + ".0.0/16";
+            by_network[cidr].push_back(std::move(device));
+        }
+        for (auto& [cidr, hosts] : by_network) store.upsert(cidr, std::move(hosts));
+        return store.snapshot();
+    }();
+    return snapshot;
+}
+
+} // namespace
+
+// range(0): ExportFormat, range(1): jobs (0 = one per core)
+static void BM_Export(benchmark::State& state) {
+    auto snapshot = corpus();
+    const auto format = static_cast<ExportFormat>(state.range(0));
+    const size_t jobs = static_cast<size_t>(state.range(1));
+    state.SetLabel(std::string(to_string(format)) + (jobs == 1 ? ", 1 thread" : ", all cores"));
+
+    std::FILE* sink = std::fopen("/dev/null", "wb");
+    ExportStats stats;
+    for (auto _ : state) {
+        stats = export_snapshot(*snapshot, format, sink, jobs);
+        benchmark::DoNotOptimize(stats.bytes);
+    }
+    std::fclose(sink);
+    state.counters["hosts/s"] = benchmark::Counter(static_cast<double>(stats.hosts), benchmark::Counter::kIsIterationInvariantRate);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * stats.bytes));
+}
+BENCHMARK(BM_Export)->ArgsProduct({{0, 1, 2, 3}, {1, 0}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,48 @@
+// bench_force_layout.cpp
+// Iterations per second of the Barnes-Hut force layout, plus the one-shot
+// radial and hierarchical layouts, for 4 networks of /24 groups.
+#include <benchmark/benchmark.h>
+
+#include "../src/layout_engine.hpp"
+
+namespace {
+
+std::vector<LayoutNetwork> make_networks(size_t devices) {
+    std::vector<LayoutNetwork> networks(4);
+    for (auto& network : networks) {
+        const size_t count = devices / networks.size();
+        network.group_count = static_cast<uint32_t>((count + 255) / 256);
+        for (size_t i = 0; i < count; i++) network.group_of.push_back(static_cast<uint32_t>(i / 256));
+    }
+    return networks;
+}
+
+} // namespace
+
+static void BM_ForceIteration(benchmark::State& state) {
+    auto networks = make_networks(static_cast<size_t>(state.range(0)));
+    auto layouts = layout_static(LayoutKind::Ring, networks);
+    ForceLayout force;
+    force.init(layouts);
+    for (auto _ : state) {
+        force.step();
+    }
+    state.counters["iterations/s"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+    state.counters["bodies"] = static_cast<double>(force.size());
+}
+BENCHMARK(BM_ForceIteration)->Arg(1000)->Arg(10000)->Arg(50000)->Unit(benchmark::kMillisecond);
+
+static void BM_StaticLayout(benchmark::State& state) {
+    auto networks = make_networks(static_cast<size_t>(state.range(0)));
+    const auto kind = static_cast<LayoutKind>(state.range(1));
+    for (auto _ : state) {
+        auto layouts = layout_static(kind, networks);
+        benchmark::DoNotOptimize(layouts.data());
+    }
+}
+BENCHMARK(BM_StaticLayout)
+    ->Args({50000, static_cast<int>(LayoutKind::RadialSubnet)})
+    ->Args({50000, static_cast<int>(LayoutKind::Hierarchical)})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
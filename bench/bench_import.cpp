@@ -0,0 +1,39 @@
+// bench_import.cpp
+// End-to-end import of a generated corpus (64 files x 2000 hosts, about
+// 120 MB) with 1..8 parser threads, reported as MB/s and hosts/s.
+#include <benchmark/benchmark.h>
+
+#include "../src/utils.hpp"
+#include "xml_generator.hpp"
+
+namespace {
+
+const std::vector<std::string>& corpus() {
+    static const std::vector<std::string> paths = xml_generator::write_corpus(
+        std::filesystem::temp_directory_path() / "nmapvis_import_corpus", 64, 2000);
+    return paths;
+}
+
+} // namespace
+
+static void BM_Import(benchmark::State& state) {
+    const auto& paths = corpus();
+    ImportStats stats;
+    uint64_t bytes = 0;
+    size_t hosts = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        nmapVisualizerGlobals::store.clear();
+        state.ResumeTiming();
+
+        stats = import_nmap_files(paths, static_cast<size_t>(state.range(0)));
+        bytes += stats.bytes;
+        hosts += stats.hosts;
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    state.counters["hosts/s"] = benchmark::Counter(static_cast<double>(hosts), benchmark::Counter::kIsRate);
+    state.counters["failed"] = static_cast<double>(stats.failed);
+}
+BENCHMARK(BM_Import)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
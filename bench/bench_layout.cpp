@@ -0,0 +1,96 @@
+// bench_layout.cpp
+// CPU side of a MapArea frame at 10k devices, without Cairo: the old
+// draw_map (copy every network/device by value, recompute cos/sin, format
+// labels) against the cached path (grid cull, read SoA positions and cached
+// labels), plus the cost of a resize.
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <memory>
+
+#include "../src/globals.hpp"
+#include "../src/layout.hpp"
+#include "../src/spatial.hpp"
+
+namespace {
+
+constexpr double kWidth = 1600, kHeight = 1000;
+
+std::vector<std::shared_ptr<const DeviceInfo>> make_devices(size_t count) {
+    std::vector<std::shared_ptr<const DeviceInfo>> devices;
+    devices.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        std::string ip = "10.0." + std::to_string(i / 256) + "." + std::to_string(i % 256);
+        devices.push_back(std::make_shared<const DeviceInfo>(ip, "Unknown", "Unknown", "Unknown", std::vector<Port>{}, "Unknown"));
+    }
+    return devices;
+}
+
+} // namespace
+
+static void BM_FrameRecompute(benchmark::State& state) {
+    struct Device { std::shared_ptr<const DeviceInfo> info; double x, y; };
+    struct Network { std::string cidr; std::vector<Device> devices; double center_x, center_y; };
+
+    std::vector<Network> networks(1);
+    for (auto& info : make_devices(static_cast<size_t>(state.range(0)))) networks[0].devices.push_back(Device{info, 0, 0});
+
+    for (auto _ : state) {
+        double sink = 0;
+        for (Network network : networks) {
+            std::vector<Device> devices = network.devices;
+            int num = devices.size();
+            for (int i = 0; i < num; i++) {
+                double angle = i * (2 * M_PI / num);
+                devices[i].x = kWidth / 2.0 + (kWidth / 3.0) * cos(angle);
+                devices[i].y = kHeight / 2.0 + (kHeight / 3.0) * sin(angle);
+            }
+            for (const Device& d : devices) {
+                const std::string label = d.info->ipAddress.to_string();
+                sink += d.x + d.y + label.size();
+            }
+        }
+        benchmark::DoNotOptimize(sink);
+    }
+}
+BENCHMARK(BM_FrameRecompute)->Arg(10000);
+
+static void BM_FrameCached(benchmark::State& state) {
+    auto devices = make_devices(static_cast<size_t>(state.range(0)));
+    std::vector<std::string> labels;
+    for (const auto& d : devices) labels.push_back(d->ipAddress.to_string());
+
+    RingLayout layout;
+    layout.compute_ring(devices.size());
+    layout.scale(kWidth, kHeight);
+
+    SpatialGrid grid;
+    grid.clear(80);
+    for (uint32_t i = 0; i < layout.size(); i++) grid.insert(i, layout.x[i], layout.y[i]);
+    grid.build();
+
+    std::vector<uint32_t> visible;
+    for (auto _ : state) {
+        double sink = 0;
+        visible.clear();
+        grid.query_rect(-80, -80, kWidth + 80, kHeight + 80, [&visible](uint32_t id, double, double) { visible.push_back(id); });
+        for (uint32_t id : visible) sink += layout.x[id] + layout.y[id] + labels[id].size();
+        benchmark::DoNotOptimize(sink);
+    }
+}
+BENCHMARK(BM_FrameCached)->Arg(10000);
+
+static void BM_Resize(benchmark::State& state) {
+    RingLayout layout;
+    layout.compute_ring(static_cast<size_t>(state.range(0)));
+    layout.scale(kWidth, kHeight);
+    double width = kWidth;
+    for (auto _ : state) {
+        width = width == kWidth ? kWidth - 1 : kWidth;
+        layout.scale(width, kHeight);
+        benchmark::DoNotOptimize(layout.x.data());
+    }
+}
+BENCHMARK(BM_Resize)->Arg(10000);
+
+BENCHMARK_MAIN();
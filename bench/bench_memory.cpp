@@ -0,0 +1,118 @@
+// bench_memory.cpp
+// Heap bytes and allocations per host for the compact DeviceInfo/Port layout
+// versus the previous all-std::string layout (reproduced below as Legacy*).
+// Hosts look like a typical service scan: 24 ports, repeated vendor/OS values.
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "../src/globals.hpp"
+
+// GCC flags the replaced operator pair below as mismatched (false positive)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static std::atomic<size_t> g_alloc_count{0};
+static std::atomic<size_t> g_alloc_bytes{0};
+
+void* operator new(size_t size) {
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+struct LegacyPort {
+    int portNumber;
+    std::string protocol;
+    std::string state;
+    std::string service;
+};
+
+struct LegacyDeviceInfo {
+    std::string ipAddress;
+    std::string macAddress;
+    std::string vendor;
+    std::string deviceType;
+    std::vector<LegacyPort> ports;
+    std::string operatingSystem;
+};
+
+constexpr int kPortsPerHost = 24;
+const char* kServices[] = {"ssh (OpenSSH 9.6p1 Ubuntu 3ubuntu13)", "http (nginx 1.24.0)", "https (Apache httpd 2.4.58)",
+                           "microsoft-ds (Samba smbd 4.6.2)", "domain (ISC BIND 9.18.24)", "mysql (MySQL 8.0.36)"};
+const char* kVendors[] = {"Cisco Systems", "Hewlett Packard Enterprise", "Dell Technologies", "Raspberry Pi Trading"};
+const char* kOses[] = {"Linux 5.0 - 5.14", "Microsoft Windows Server 2019", "Cisco IOS 15.X"};
+
+std::string ip_for(size_t i) {
+    return "10." + std::to_string((i >> 16) & 0xFF) + "." + std::to_string((i >> 8) & 0xFF) + "." + std::to_string(i & 0xFF);
+}
+
+std::string mac_for(size_t i) {
+    char buffer[18];
+    std::snprintf(buffer, sizeof(buffer), "02:00:00:%02X:%02X:%02X",
+                  unsigned((i >> 16) & 0xFF), unsigned((i >> 8) & 0xFF), unsigned(i & 0xFF));
+    return buffer;
+}
+
+template <typename Build>
+void measure(benchmark::State& state, Build build) {
+    const size_t hosts = static_cast<size_t>(state.range(0));
+    size_t bytes = 0, allocs = 0;
+    for (auto _ : state) {
+        size_t count_before = g_alloc_count.load();
+        size_t bytes_before = g_alloc_bytes.load();
+        auto devices = build(hosts);
+        allocs = g_alloc_count.load() - count_before;
+        bytes = g_alloc_bytes.load() - bytes_before;
+        benchmark::DoNotOptimize(devices.data());
+    }
+    state.counters["bytes/host"] = static_cast<double>(bytes) / hosts;
+    state.counters["allocs/host"] = static_cast<double>(allocs) / hosts;
+}
+
+} // namespace
+
+static void BM_LegacyLayout(benchmark::State& state) {
+    measure(state, [](size_t hosts) {
+        std::vector<LegacyDeviceInfo> devices;
+        devices.reserve(hosts);
+        for (size_t i = 0; i < hosts; i++) {
+            std::vector<LegacyPort> ports;
+            for (int p = 0; p < kPortsPerHost; p++) {
+                ports.push_back(LegacyPort{1000 + p, "tcp", "open", kServices[(i + p) % 6]});
+            }
+            devices.push_back(LegacyDeviceInfo{ip_for(i), mac_for(i), kVendors[i % 4], "Unknown", std::move(ports), kOses[i % 3]});
+        }
+        return devices;
+    });
+}
+BENCHMARK(BM_LegacyLayout)->Arg(10000)->Arg(65536)->Unit(benchmark::kMillisecond)->Iterations(1);
+
+static void BM_CompactLayout(benchmark::State& state) {
+    measure(state, [](size_t hosts) {
+        std::vector<DeviceInfo> devices;
+        devices.reserve(hosts);
+        for (size_t i = 0; i < hosts; i++) {
+            std::vector<Port> ports;
+            ports.reserve(kPortsPerHost);
+            for (int p = 0; p < kPortsPerHost; p++) {
+                ports.emplace_back(1000 + p, Protocol::Tcp, PortState::Open, InternedString(kServices[(i + p) % 6]));
+            }
+            devices.emplace_back(IpAddress::parse(ip_for(i)), MacAddress::parse(mac_for(i)),
+                                 kVendors[i % 4], "Unknown", std::move(ports), kOses[i % 3]);
+        }
+        return devices;
+    });
+}
+BENCHMARK(BM_CompactLayout)->Arg(10000)->Arg(65536)->Unit(benchmark::kMillisecond)->Iterations(1);
+
+BENCHMARK_MAIN();
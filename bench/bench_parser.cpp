@@ -0,0 +1,150 @@
+// bench_parser.cpp
+// nmap XML parser throughput on generated documents, from memory
+// (parse_nmap_xml) and from a pipe-like FILE* (parse_nmap_xml_stream), with
+// heap allocations per host (operator new plus libxml2's allocator) and the
+// peak RSS reached while parsing.
+// Args: hosts, ports per host, detail (0 = ports only, 1 = -sV, 2 = -sV -O).
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+
+#include "../src/utils.hpp"
+#include "xml_generator.hpp"
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+// GCC flags the replaced operator pair below as mismatched (false positive)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static std::atomic<size_t> g_alloc_count{0};
+
+void* operator new(size_t size) {
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+// libxml2 allocates through these once registered with xmlMemSetup
+void* xml_malloc(size_t size) {
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size);
+}
+
+void* xml_realloc(void* p, size_t size) {
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    return std::realloc(p, size);
+}
+
+char* xml_strdup(const char* s) {
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    return strdup(s);
+}
+
+// Peak resident set size; Linux lets the high-water mark be reset per benchmark
+#if defined(__linux__)
+void reset_peak_rss() {
+    std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+double peak_rss_mb() {
+    std::ifstream status("/proc/self/status");
+    for (std::string line; std::getline(status, line);) {
+        if (line.rfind("VmHWM:", 0) == 0) return std::strtod(line.c_str() + 6, nullptr) / 1024.0;
+    }
+    struct rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;
+}
+#else
+void reset_peak_rss() {}
+double peak_rss_mb() { return 0.0; }
+#endif
+
+xml_generator::Options options_for(const benchmark::State& state) {
+    xml_generator::Options options;
+    options.min_ports = options.max_ports = static_cast<size_t>(state.range(1));
+    options.service_detail = state.range(2) >= 1;
+    options.os_detail = state.range(2) >= 2;
+    return options;
+}
+
+template <typename Parse>
+void measure(benchmark::State& state, const std::string& xml, Parse parse) {
+    const size_t hosts = static_cast<size_t>(state.range(0));
+    size_t allocs = 0, parsed = 0;
+    reset_peak_rss();
+    for (auto _ : state) {
+        const size_t before = g_alloc_count.load(std::memory_order_relaxed);
+        parsed = parse();
+        allocs = g_alloc_count.load(std::memory_order_relaxed) - before;
+    }
+    if (parsed != hosts) state.SkipWithError("parser lost hosts");
+    state.SetBytesProcessed(static_cast<int64_t>(xml.size() * state.iterations()));
+    state.counters["hosts/s"] = benchmark::Counter(static_cast<double>(hosts * state.iterations()), benchmark::Counter::kIsRate);
+    state.counters["allocs/host"] = static_cast<double>(allocs) / hosts;
+    state.counters["peak_rss_MB"] = peak_rss_mb();
+}
+
+} // namespace
+
+static void BM_ParseMemory(benchmark::State& state) {
+    const std::string xml = xml_generator::generate(10u << 24, static_cast<size_t>(state.range(0)), 1, options_for(state));
+    measure(state, xml, [&xml]() {
+        auto devices = parse_nmap_xml(xml);
+        benchmark::DoNotOptimize(devices.data());
+        return devices.size();
+    });
+}
+
+// Same document through the streaming reader nmap output goes through
+static void BM_ParseStream(benchmark::State& state) {
+    const std::string xml = xml_generator::generate(10u << 24, static_cast<size_t>(state.range(0)), 1, options_for(state));
+    std::FILE* file = std::tmpfile();
+    std::fwrite(xml.data(), 1, xml.size(), file);
+    measure(state, xml, [file]() {
+        std::rewind(file);
+        size_t count = 0;
+        parse_nmap_xml_stream(file, [&count](DeviceInfo&& device) {
+            benchmark::DoNotOptimize(device.ports.data());
+            count++;
+        });
+        return count;
+    });
+    std::fclose(file);
+}
+
+static void ParserArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"hosts", "ports", "detail"});
+    for (int64_t hosts : {1000, 20000}) {
+        for (int64_t detail : {0, 2}) b->Args({hosts, 4, detail});
+    }
+    b->Args({20000, 32, 2});
+    b->Unit(benchmark::kMillisecond);
+}
+BENCHMARK(BM_ParseMemory)->Apply(ParserArgs);
+BENCHMARK(BM_ParseStream)->Apply(ParserArgs);
+
+int main(int argc, char** argv) {
+    // Must precede any other libxml2 call
+    xmlMemSetup(std::free, xml_malloc, xml_realloc, xml_strdup);
+    xmlInitParser();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    xmlCleanupParser();
+    return 0;
+}
@@ -0,0 +1,75 @@
+// bench_query.cpp
+// Filter bar queries over 100k generated hosts spread across /16 networks:
+// building the columnar index from a store snapshot, and evaluating queries
+// that hit the port/service indexes, the interned-string columns or neither.
+#include <benchmark/benchmark.h>
+
+#include "../src/utils.hpp"
+#include "../src/query.hpp"
+#include "xml_generator.hpp"
+
+namespace {
+
+constexpr size_t kHosts = 100000;
+
+std::shared_ptr<const StoreSnapshot> corpus() {
+    static std::shared_ptr<const StoreSnapshot> snapshot = [] {
+        NetworkStore store;
+        std::vector<DeviceInfo> devices = parse_nmap_xml(xml_generator::generate(10u << 24, kHosts, 1));
+        std::unordered_map<std::string, std::vector<DeviceInfo>> by_network;
+        for (auto& device : devices) {
+            const std::string cidr = "10." + std::to_string(device.ipAddress.bytes[1]) + ".0.0/16";
+            by_network[cidr].push_back(std::move(device));
+        }
+        for (auto& [cidr, hosts] : by_network) store.upsert(cidr, std::move(hosts));
+        return store.snapshot();
+    }();
+    return snapshot;
+}
+
+const HostIndex& index() {
+    static HostIndex built = [] {
+        HostIndex index;
+        index.build(corpus());
+        return index;
+    }();
+    return built;
+}
+
+const char* const kQueries[] = {
+    "port:22",
+    "port:22 state:open os:~Linux vendor:Cisco net:10.1.0.0/16",
+    "service:http -port:443",
+    "os:~windows",
+    "vendor:dell host:~host-1",
+    "samba",
+};
+
+} // namespace
+
+static void BM_BuildIndex(benchmark::State& state) {
+    auto snapshot = corpus();
+    for (auto _ : state) {
+        HostIndex index;
+        index.build(snapshot);
+        benchmark::DoNotOptimize(index.size());
+    }
+    state.counters["hosts"] = static_cast<double>(snapshot->device_count());
+}
+BENCHMARK(BM_BuildIndex)->Unit(benchmark::kMillisecond);
+
+static void BM_Query(benchmark::State& state) {
+    const HostIndex& hosts = index();
+    const char* text = kQueries[state.range(0)];
+    state.SetLabel(text);
+    QueryResult result;
+    for (auto _ : state) {
+        Query query = Query::parse(text);
+        result = hosts.evaluate(query);
+        benchmark::DoNotOptimize(result.hosts.data());
+    }
+    state.counters["matches"] = static_cast<double>(result.hosts.size());
+}
+BENCHMARK(BM_Query)->DenseRange(0, std::size(kQueries) - 1)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,30 @@
+// bench_shard.cpp
+// Wall-clock of one /20 scan through ParallelScanner as the shard size shrinks
+// (1, 2, 4, ... 16 shards), using fake_nmap so the numbers only reflect the
+// scheduling and parsing side. The pool is fixed at 8 workers because fake_nmap,
+// like nmap itself, mostly waits rather than burns CPU.
+#include <benchmark/benchmark.h>
+
+#include "../src/utils.hpp"
+
+static void BM_ShardedScan(benchmark::State& state) {
+    const int shard_prefix = static_cast<int>(state.range(0));
+    ParallelScanner scanner(8);
+    scanner.set_nmap_path(FAKE_NMAP_PATH);
+    scanner.set_shard_prefix(shard_prefix);
+
+    size_t hosts = 0;
+    for (auto _ : state) {
+        auto ids = scanner.add_sharded_scan("10.20.0.0/20");
+        scanner.wait_all();
+        scanner.drain_events([&hosts](ScanEvent&& event) {
+            if (event.kind == ScanEvent::Kind::Host) hosts++;
+        });
+        state.counters["shards"] = static_cast<double>(ids.size());
+    }
+    state.counters["workers"] = static_cast<double>(scanner.worker_count());
+    state.counters["hosts/s"] = benchmark::Counter(static_cast<double>(hosts), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_ShardedScan)->DenseRange(20, 24)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
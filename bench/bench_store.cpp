@@ -0,0 +1,70 @@
+// bench_store.cpp
+// Streaming a scan into one /16: hosts arrive in batches of range(1) and each
+// batch is upserted (and published) on its own, as the scan paths do. The
+// time per host should stay flat as the network grows; with a full copy of
+// the network per batch it grows with the network size.
+#include <benchmark/benchmark.h>
+
+#include "../src/store.hpp"
+
+namespace {
+
+DeviceInfo make_device(uint32_t i) {
+    IpAddress ip;
+    ip.family = 4;
+    ip.bytes[0] = 10;
+    ip.bytes[1] = 20;
+    ip.bytes[2] = static_cast<uint8_t>(i >> 8);
+    ip.bytes[3] = static_cast<uint8_t>(i);
+    MacAddress mac;
+    mac.set = true;
+    mac.bytes = {0x02, 0, 0, 0, static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i)};
+    return DeviceInfo(ip, mac, "Vendor", "", {Port(22, Protocol::Tcp, PortState::Open, "ssh")}, "Linux");
+}
+
+} // namespace
+
+// range(0): hosts streamed, range(1): hosts per batch
+static void BM_StreamUpsert(benchmark::State& state) {
+    const uint32_t hosts = static_cast<uint32_t>(state.range(0));
+    const uint32_t batch = static_cast<uint32_t>(state.range(1));
+    for (auto _ : state) {
+        state.PauseTiming();
+        NetworkStore store;
+        std::vector<std::vector<DeviceInfo>> batches;
+        for (uint32_t i = 0; i < hosts; i += batch) {
+            batches.emplace_back();
+            for (uint32_t j = i; j < std::min(hosts, i + batch); j++) batches.back().push_back(make_device(j));
+        }
+        state.ResumeTiming();
+
+        for (auto& devices : batches) store.upsert("10.20.0.0/16", std::move(devices));
+        benchmark::DoNotOptimize(store.snapshot()->device_count());
+    }
+    state.counters["ns/host"] = benchmark::Counter(static_cast<double>(hosts), benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+    state.SetItemsProcessed(state.iterations() * hosts);
+}
+BENCHMARK(BM_StreamUpsert)
+    ->ArgsProduct({{16384, 32768, 65536}, {16, 256}})
+    ->Unit(benchmark::kMillisecond);
+
+// Rescan of a full /16: every host replaced in batches, the network already at size
+static void BM_RescanUpsert(benchmark::State& state) {
+    const uint32_t hosts = 65536;
+    const uint32_t batch = static_cast<uint32_t>(state.range(0));
+    NetworkStore store;
+    std::vector<DeviceInfo> initial;
+    for (uint32_t i = 0; i < hosts; i++) initial.push_back(make_device(i));
+    store.upsert("10.20.0.0/16", std::move(initial));
+    for (auto _ : state) {
+        for (uint32_t i = 0; i < hosts; i += batch) {
+            std::vector<DeviceInfo> devices;
+            for (uint32_t j = i; j < std::min(hosts, i + batch); j++) devices.push_back(make_device(j));
+            store.upsert("10.20.0.0/16", std::move(devices));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * hosts);
+}
+BENCHMARK(BM_RescanUpsert)->Arg(16)->Arg(256)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,51 @@
+// fake_nmap.cpp
+// Stand-in for nmap used by the benchmarks: accepts "[-oX -] <target>" and
+// writes synthetic nmap XML for every address of an IPv4 CIDR to stdout.
+// Each probed address costs FAKE_NMAP_HOST_US microseconds (default 200) so
+// wall-clock behaves like a single-threaded scanner; every 4th address is up.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: fake_nmap [-oX -] <a.b.c.d/nn>\n");
+        return 1;
+    }
+
+    unsigned int a, b, c, d;
+    int prefix = 32;
+    if (std::sscanf(argv[argc - 1], "%u.%u.%u.%u/%d", &a, &b, &c, &d, &prefix) < 4 || prefix < 0 || prefix > 32) {
+        std::fprintf(stderr, "fake_nmap: unsupported target %s\n", argv[argc - 1]);
+        return 1;
+    }
+
+    const char* delay_env = std::getenv("FAKE_NMAP_HOST_US");
+    const long host_us = delay_env ? std::atol(delay_env) : 200;
+
+    uint32_t mask = prefix == 0 ? 0 : 0xFFFFFFFFu << (32 - prefix);
+    uint32_t base = ((a << 24) | (b << 16) | (c << 8) | d) & mask;
+    uint64_t count = uint64_t{1} << (32 - prefix);
+
+    std::printf("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<!DOCTYPE nmaprun>\n");
+    std::printf("<nmaprun scanner=\"nmap\" args=\"fake_nmap %s\" version=\"7.94\" xmloutputversion=\"1.05\">\n", argv[argc - 1]);
+    for (uint64_t i = 0; i < count; i++) {
+        if (host_us > 0) std::this_thread::sleep_for(std::chrono::microseconds(host_us));
+
+        uint32_t ip = static_cast<uint32_t>(base + i);
+        if (ip % 4 != 1) continue;
+
+        std::printf("<host><status state=\"up\" reason=\"arp-response\"/>\n");
+        std::printf("<address addr=\"%u.%u.%u.%u\" addrtype=\"ipv4\"/>\n", ip >> 24, (ip >> 16) & 0xFF, (ip >> 8) & 0xFF, ip & 0xFF);
+        std::printf("<address addr=\"02:00:%02X:%02X:%02X:%02X\" addrtype=\"mac\" vendor=\"Fake Vendor\"/>\n",
+                    ip >> 24, (ip >> 16) & 0xFF, (ip >> 8) & 0xFF, ip & 0xFF);
+        std::printf("<ports><port protocol=\"tcp\" portid=\"22\"><state state=\"open\"/><service name=\"ssh\" product=\"OpenSSH\" version=\"9.6\"/></port>\n");
+        std::printf("<port protocol=\"tcp\" portid=\"80\"><state state=\"open\"/><service name=\"http\"/></port></ports>\n");
+        std::printf("</host>\n");
+        std::fflush(stdout);
+    }
+    std::printf("<runstats><finished/></runstats>\n</nmaprun>\n");
+    return 0;
+}
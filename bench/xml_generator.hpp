@@ -0,0 +1,127 @@
+// xml_generator.hpp
+// Deterministic synthetic nmap -oX output for the benchmarks: every host has
+// an IPv4 and MAC address, a hostname and open ports; by default 1-6 ports with
+// service details and an OS match, roughly the shape of a "-sV -O" scan.
+#ifndef XML_GENERATOR_HPP
+#define XML_GENERATOR_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace xml_generator {
+
+struct Service { int port; const char* protocol; const char* name; const char* product; };
+
+constexpr Service kServices[] = {
+    {22, "tcp", "ssh", "OpenSSH"},       {80, "tcp", "http", "nginx"},
+    {443, "tcp", "https", "nginx"},      {53, "udp", "domain", "dnsmasq"},
+    {139, "tcp", "netbios-ssn", "Samba"}, {445, "tcp", "microsoft-ds", "Samba"},
+    {3389, "tcp", "ms-wbt-server", "Microsoft Terminal Services"},
+    {8080, "tcp", "http-proxy", "Squid"},
+};
+constexpr const char* kVendors[] = {"Dell", "Hewlett Packard", "Cisco Systems", "Raspberry Pi Trading", "Intel Corporate", "Apple"};
+constexpr const char* kOses[] = {"Linux 5.15", "Microsoft Windows 10", "Cisco IOS 15", "FreeBSD 13.2", "Apple macOS 13"};
+
+// Small LCG so corpora are identical across runs and platforms
+class Random {
+    uint64_t state_;
+public:
+    explicit Random(uint64_t seed) : state_(seed * 6364136223846793005ull + 1442695040888963407ull) {}
+    uint32_t next() {
+        state_ = state_ * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<uint32_t>(state_ >> 33);
+    }
+};
+
+// Shape of the generated hosts
+struct Options {
+    size_t min_ports = 1;
+    size_t max_ports = 6;
+    bool service_detail = true;  // <service> with product/version (-sV)
+    bool os_detail = true;       // <os><osmatch> (-O)
+};
+
+// One document with `hosts` hosts starting at first_ip (host byte order)
+inline std::string generate(uint32_t first_ip, size_t hosts, uint64_t seed, const Options &options) {
+    Random random(seed);
+    std::string xml;
+    xml.reserve(hosts * (400 + 180 * options.max_ports) + 512);
+    char line[512];
+
+    xml += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<!DOCTYPE nmaprun>\n";
+    xml += "<nmaprun scanner=\"nmap\" args=\"nmap -sV -O -oX - generated\" start=\"1700000000\" version=\"7.94\" xmloutputversion=\"1.05\">\n";
+    xml += "<scaninfo type=\"syn\" protocol=\"tcp\" numservices=\"1000\" services=\"1-1000\"/>\n";
+    for (size_t h = 0; h < hosts; h++) {
+        const uint32_t ip = first_ip + static_cast<uint32_t>(h);
+        const uint32_t a = ip >> 24, b = (ip >> 16) & 0xFF, c = (ip >> 8) & 0xFF, d = ip & 0xFF;
+        xml += "<host starttime=\"1700000001\" endtime=\"1700000042\"><status state=\"up\" reason=\"arp-response\" reason_ttl=\"0\"/>\n";
+        std::snprintf(line, sizeof(line), "<address addr=\"%u.%u.%u.%u\" addrtype=\"ipv4\"/>\n", a, b, c, d);
+        xml += line;
+        std::snprintf(line, sizeof(line), "<address addr=\"02:%02X:%02X:%02X:%02X:%02X\" addrtype=\"mac\" vendor=\"%s\"/>\n",
+                      a, b, c, d, random.next() & 0xFF, kVendors[random.next() % std::size(kVendors)]);
+        xml += line;
+        std::snprintf(line, sizeof(line), "<hostnames><hostname name=\"host-%u-%u-%u-%u.example.net\" type=\"PTR\"/></hostnames>\n", a, b, c, d);
+        xml += line;
+
+        xml += "<ports><extraports state=\"closed\" count=\"994\"><extrareasons reason=\"reset\" count=\"994\"/></extraports>\n";
+        const size_t spread = options.max_ports > options.min_ports ? options.max_ports - options.min_ports + 1 : 1;
+        const size_t port_count = options.min_ports + random.next() % spread;
+        const size_t first = random.next() % std::size(kServices);
+        for (size_t p = 0; p < port_count; p++) {
+            // Past the service table, ports continue upwards so each stays unique
+            const Service& service = kServices[(first + p) % std::size(kServices)];
+            const int port = service.port + static_cast<int>(p / std::size(kServices)) * 10000 % 55000;
+            if (options.service_detail) {
+                std::snprintf(line, sizeof(line),
+                              "<port protocol=\"%s\" portid=\"%d\"><state state=\"open\" reason=\"syn-ack\" reason_ttl=\"64\"/>"
+                              "<service name=\"%s\" product=\"%s\" version=\"%u.%u\" method=\"probed\" conf=\"10\"/></port>\n",
+                              service.protocol, port, service.name, service.product, random.next() % 10, random.next() % 10);
+            } else {
+                std::snprintf(line, sizeof(line),
+                              "<port protocol=\"%s\" portid=\"%d\"><state state=\"open\" reason=\"syn-ack\" reason_ttl=\"64\"/>"
+                              "<service name=\"%s\" method=\"table\" conf=\"3\"/></port>\n",
+                              service.protocol, port, service.name);
+            }
+            xml += line;
+        }
+        xml += "</ports>\n";
+
+        if (options.os_detail) {
+            std::snprintf(line, sizeof(line), "<os><osmatch name=\"%s\" accuracy=\"%u\" line=\"1\"/></os>\n",
+                          kOses[random.next() % std::size(kOses)], 85 + random.next() % 15);
+            xml += line;
+        }
+        xml += "<times srtt=\"512\" rttvar=\"120\" to=\"100000\"/>\n</host>\n";
+    }
+    std::snprintf(line, sizeof(line), "<runstats><finished time=\"1700000100\" elapsed=\"100\"/><hosts up=\"%zu\" down=\"0\" total=\"%zu\"/></runstats>\n</nmaprun>\n",
+                  hosts, hosts);
+    xml += line;
+    return xml;
+}
+
+inline std::string generate(uint32_t first_ip, size_t hosts, uint64_t seed = 1) {
+    return generate(first_ip, hosts, seed, Options{});
+}
+
+// Write `files` documents of `hosts_per_file` hosts into dir (reused if already present)
+inline std::vector<std::string> write_corpus(const std::filesystem::path &dir, size_t files, size_t hosts_per_file) {
+    std::filesystem::create_directories(dir);
+    std::vector<std::string> paths;
+    for (size_t f = 0; f < files; f++) {
+        std::filesystem::path path = dir / ("scan-" + std::to_string(f) + ".xml");
+        if (!std::filesystem::exists(path)) {
+            const uint32_t first_ip = (10u << 24) + static_cast<uint32_t>(f * hosts_per_file);
+            std::ofstream(path, std::ios::binary) << generate(first_ip, hosts_per_file, f + 1);
+        }
+        paths.push_back(path.string());
+    }
+    return paths;
+}
+
+} // namespace xml_generator
+
+#endif // XML_GENERATOR_HPP
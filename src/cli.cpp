@@ -0,0 +1,404 @@
+// cli.cpp
+// Headless driver for the scan/import/store pipeline: no GTK, no display.
+//
+//   nmapvis_cli [--db PATH | --no-db] scan [options] <target>...
+//   nmapvis_cli [--db PATH | --no-db] import [--jobs N] <file.xml | directory>...
+//   nmapvis_cli [--db PATH] show [cidr]...
+//   nmapvis_cli [--db PATH] export [--format csv|jsonl|graphml|dot] [--jobs N] <file | ->
+//   nmapvis_cli [--db PATH | --no-db] monitor [options] <target>...
+//
+// --trace FILE records the run as Chrome trace JSON (chrome://tracing, ui.perfetto.dev)
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "utils.hpp"
+#include "diff.hpp"
+#include "export.hpp"
+#include "monitor.hpp"
+#include "scan_session.hpp"
+
+namespace {
+
+int usage(const char* program) {
+    std::cerr << "usage: " << program << " [--db PATH | --no-db] [--trace FILE] <command> [options]\n"
+              << "  scan [--profile quick|default|services|thorough] [--workers N] [--shard PREFIX]\n"
+              << "       [--incremental [--ttl SECONDS]] [--nmap PATH] [--quiet] <target>...\n"
+              << "  import [--jobs N] <file.xml | directory>...\n"
+              << "  show [cidr]...\n"
+              << "  export [--format csv|jsonl|graphml|dot] [--jobs N] <file | ->\n"
+              << "  monitor [--interval SECONDS] [--jitter FRACTION] [--workers N] [--parallel N] [--nice N]\n"
+              << "          [--max-rate PPS] [--ttl SECONDS] [--passes N] [--nmap PATH] <target>...\n";
+    return 1;
+}
+
+// Parse the whole of an option value as a number in [min, max]. strtoul and
+// friends would quietly turn "abc" into 0 and "-1" into SIZE_MAX
+template <typename T>
+bool parse_option(const std::string &option, const std::string &text, T min, T max, T &value) {
+    T parsed{};
+    const char* end = text.data() + text.size();
+    auto [stop, ec] = std::from_chars(text.data(), end, parsed);
+    if (text.empty() || ec != std::errc() || stop != end || parsed < min || parsed > max) {
+        std::cerr << "Error: invalid " << option << " value '" << text << "' (expected " << min << " to " << max << ")" << std::endl;
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+// Thread and process counts; 0 (automatic) is the default when the option is absent
+constexpr size_t kMaxThreads = 1024;
+
+// ip  mac  vendor  os  ports, tab separated
+void print_device(const std::string &cidr, const DeviceInfo &device) {
+    std::cout << cidr << '\t' << device.ipAddress.to_string() << '\t' << device.macAddress.to_string() << '\t'
+              << device.vendor.str() << '\t' << device.operatingSystem.str() << '\t';
+    bool first = true;
+    for (const auto& port : device.ports) {
+        if (port.state != PortState::Open) continue;
+        std::cout << (first ? "" : ",") << port.portNumber << '/' << to_string(port.protocol);
+        if (!port.service.empty()) std::cout << '(' << port.service.str() << ')';
+        first = false;
+    }
+    std::cout << '\n';
+}
+
+int run_show(const std::vector<std::string> &cidrs) {
+    auto snapshot = nmapVisualizerGlobals::store.snapshot();
+    for (const auto& network : snapshot->networks) {
+        if (!cidrs.empty() && std::find(cidrs.begin(), cidrs.end(), network->cidr) == cidrs.end()) continue;
+        for (const auto& device : network->devices) print_device(network->cidr, *device);
+    }
+    return 0;
+}
+
+int run_import(const std::vector<std::string> &args) {
+    size_t jobs = 0;
+    std::vector<std::string> inputs;
+    for (size_t i = 0; i < args.size(); i++) {
+        if (args[i] == "--jobs" && i + 1 < args.size()) {
+            if (!parse_option("--jobs", args[++i], size_t{1}, kMaxThreads, jobs)) return 1;
+        } else {
+            inputs.push_back(args[i]);
+        }
+    }
+    std::vector<std::string> files = collect_xml_files(inputs);
+    if (files.empty()) {
+        std::cerr << "Error: no .xml files to import" << std::endl;
+        return 1;
+    }
+
+    ImportStats stats = import_nmap_files(files, jobs);
+    std::cerr << std::fixed << std::setprecision(1)
+              << "Imported " << stats.hosts << " hosts from " << stats.files - stats.failed << "/" << stats.files
+              << " files (" << stats.bytes / 1e6 << " MB) in " << stats.seconds << " s: "
+              << stats.mb_per_second() << " MB/s, " << stats.hosts_per_second() << " hosts/s" << std::endl;
+    return stats.failed == 0 ? 0 : 2;
+}
+
+// Format from --format, else from the file extension
+int run_export(const std::vector<std::string> &args) {
+    std::optional<ExportFormat> format;
+    size_t jobs = 0;
+    std::string path;
+    for (size_t i = 0; i < args.size(); i++) {
+        if (args[i] == "--format" && i + 1 < args.size()) {
+            format = parse_export_format(args[++i]);
+            if (!format) {
+                std::cerr << "Error: unknown export format " << args[i] << std::endl;
+                return 1;
+            }
+        } else if (args[i] == "--jobs" && i + 1 < args.size()) {
+            if (!parse_option("--jobs", args[++i], size_t{1}, kMaxThreads, jobs)) return 1;
+        } else {
+            path = args[i];
+        }
+    }
+    if (path.empty()) {
+        std::cerr << "Error: no export file" << std::endl;
+        return 1;
+    }
+    if (!format) format = path == "-" ? ExportFormat::Csv : export_format_for_path(path).value_or(ExportFormat::Csv);
+
+    try {
+        ExportStats stats = export_snapshot(*nmapVisualizerGlobals::store.snapshot(), *format, path, jobs);
+        std::cerr << std::fixed << std::setprecision(1)
+                  << "Exported " << stats.hosts << " hosts in " << stats.networks << " networks as " << to_string(*format)
+                  << " (" << stats.bytes / 1e6 << " MB) in " << stats.seconds << " s: "
+                  << stats.hosts_per_second() << " hosts/s" << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << "Error exporting: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+volatile std::sig_atomic_t interrupted = 0;
+
+// "+ 10.0.0.7", "- 10.0.0.9", "~ 10.0.0.4 22/tcp open -> closed"
+void print_changes(const MonitorRun &run) {
+    std::cout << run.diff.summary() << '\n';
+    for (const auto& host : run.diff.hosts) {
+        if (host.kind == HostChange::Added) {
+            std::cout << "  + " << host.after->ipAddress.to_string() << '\n';
+        } else if (host.kind == HostChange::Removed) {
+            std::cout << "  - " << host.before->ipAddress.to_string() << '\n';
+        } else {
+            for (const auto& port : host.ports) {
+                std::cout << "  ~ " << host.after->ipAddress.to_string() << ' ' << port.portNumber << '/' << to_string(port.protocol)
+                          << ' ' << (port.before == PortState::Unknown ? "none" : to_string(port.before)) << " -> "
+                          << (port.after == PortState::Unknown ? "none" : to_string(port.after)) << '\n';
+            }
+        }
+    }
+    std::cout << std::flush;
+}
+
+// Rescan the targets until interrupted (or --passes passes each), printing
+// the changes of every pass that found any
+int run_monitor(const std::vector<std::string> &args) {
+    MonitorSettings settings;
+    int64_t interval = 3600;
+    size_t passes = 0;
+    std::string nmap_path;
+    std::vector<std::string> targets;
+    for (size_t i = 0; i < args.size(); i++) {
+        const std::string& arg = args[i];
+        const bool has_value = i + 1 < args.size();
+        if (arg == "--interval" && has_value) {
+            if (!parse_option("--interval", args[++i], int64_t{1}, int64_t{366} * 86400, interval)) return 1;
+        } else if (arg == "--jitter" && has_value) {
+            if (!parse_option("--jitter", args[++i], 0.0, 0.9, settings.jitter)) return 1;
+        } else if (arg == "--workers" && has_value) {
+            if (!parse_option("--workers", args[++i], size_t{1}, kMaxThreads, settings.workers)) return 1;
+        } else if (arg == "--parallel" && has_value) {
+            if (!parse_option("--parallel", args[++i], size_t{1}, kMaxThreads, settings.max_running)) return 1;
+        } else if (arg == "--nice" && has_value) {
+            if (!parse_option("--nice", args[++i], -20, 19, settings.niceness)) return 1;
+        } else if (arg == "--max-rate" && has_value) {
+            if (!parse_option("--max-rate", args[++i], 0, 100000000, settings.profile.max_rate)) return 1;
+        } else if (arg == "--ttl" && has_value) {
+            if (!parse_option("--ttl", args[++i], int64_t{0}, int64_t{3650} * 86400, settings.ttl_seconds)) return 1;
+        } else if (arg == "--passes" && has_value) {
+            if (!parse_option("--passes", args[++i], size_t{0}, size_t{1000000000}, passes)) return 1;
+        } else if (arg == "--nmap" && has_value) {
+            nmap_path = args[++i];
+        } else {
+            targets.push_back(arg);
+        }
+    }
+    if (targets.empty()) {
+        std::cerr << "Error: no monitor targets" << std::endl;
+        return 1;
+    }
+
+    Monitor monitor(settings);
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool notified = false;
+    monitor.set_notify([&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        notified = true;
+        wake.notify_one();
+    });
+    monitor.set_nmap_path(nmap_path);
+    auto now = []() { return static_cast<int64_t>(std::time(nullptr)); };
+    for (const auto& target : targets) monitor.add_target(target, interval, now());
+    std::cerr << "Monitoring " << targets.size() << " targets every " << format_duration(interval) << " with "
+              << settings.workers << " workers, profile " << settings.profile.describe() << std::endl;
+
+    std::signal(SIGINT, [](int) { interrupted = 1; });
+    std::signal(SIGTERM, [](int) { interrupted = 1; });
+    size_t alerts = 0;
+    while (!interrupted && !monitor.empty()) {
+        for (const auto& run : monitor.poll(now())) {
+            std::cerr << "Pass over " << run.target << (run.cancelled ? " cancelled" : " done") << ": " << run.hosts
+                      << " hosts up in " << format_duration(run.finished - run.started) << std::endl;
+            if (run.alert()) {
+                alerts++;
+                print_changes(run);
+            }
+            if (passes > 0) {
+                for (const auto& info : monitor.targets()) {
+                    if (info.target == run.target && info.passes >= passes) monitor.remove_target(run.target);
+                }
+            }
+        }
+
+        // Results wake the loop at once; due passes and signals are noticed within a second
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait_for(lock, std::chrono::seconds(1), [&]() { return notified; });
+        notified = false;
+    }
+    monitor.clear();
+    std::cerr << "Monitor stopped after " << monitor.history().size() << " passes, " << alerts << " with changes" << std::endl;
+    return 0;
+}
+
+int run_scan(const std::vector<std::string> &args) {
+    size_t workers = 0;
+    int shard = -1;
+    bool incremental = false;
+    bool quiet = false;
+    int64_t ttl = 86400;
+    std::string nmap_path;
+    ScanProfile profile;
+    std::vector<std::string> targets;
+    for (size_t i = 0; i < args.size(); i++) {
+        const std::string& arg = args[i];
+        const bool has_value = i + 1 < args.size();
+        if (arg == "--profile" && has_value) {
+            const std::string name = args[++i];
+            const auto& profiles = scan_profiles();
+            if (name == "quick") profile = profiles[0];
+            else if (name == "default") profile = profiles[1];
+            else if (name == "services") profile = profiles[2];
+            else if (name == "thorough") profile = profiles[3];
+            else {
+                std::cerr << "Error: unknown profile " << name << std::endl;
+                return 1;
+            }
+        } else if (arg == "--workers" && has_value) {
+            if (!parse_option("--workers", args[++i], size_t{1}, kMaxThreads, workers)) return 1;
+        } else if (arg == "--shard" && has_value) {
+            if (!parse_option("--shard", args[++i], 0, 32, shard)) return 1;
+        } else if (arg == "--ttl" && has_value) {
+            if (!parse_option("--ttl", args[++i], int64_t{0}, int64_t{3650} * 86400, ttl)) return 1;
+        } else if (arg == "--nmap" && has_value) {
+            nmap_path = args[++i];
+        } else if (arg == "--incremental") {
+            incremental = true;
+        } else if (arg == "--quiet") {
+            quiet = true;
+        } else {
+            targets.push_back(arg);
+        }
+    }
+    if (targets.empty()) {
+        std::cerr << "Error: no scan targets" << std::endl;
+        return 1;
+    }
+
+    ParallelScanner scanner(workers);
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool notified = false;
+    scanner.set_notify([&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        notified = true;
+        wake.notify_one();
+    });
+    scanner.set_nmap_path(nmap_path);
+    scanner.set_profile(profile);
+    if (shard >= 0) scanner.set_shard_prefix(shard);
+    std::cerr << "Scanning with " << scanner.worker_count() << " workers, profile " << profile.describe() << std::endl;
+
+    // Same bookkeeping as the GUI: each target is diffed against its stored
+    // network once all of its tasks are done
+    ScanSession session(scanner);
+    for (const auto& target : targets) session.start(target, incremental, ttl);
+
+    const auto started = std::chrono::steady_clock::now();
+    int status = 0;
+    while (!session.empty()) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait_for(lock, std::chrono::seconds(1), [&]() { return notified; });
+            notified = false;
+        }
+
+        auto finished = session.poll({}, [quiet](const ScanEvent &event) {
+            if (quiet || event.kind != ScanEvent::Kind::Progress) return;
+            std::cerr << std::fixed << std::setprecision(1) << event.target << ": " << event.progress.task << " "
+                      << event.progress.percent << "%, ETA " << format_duration(event.progress.remaining)
+                      << ", " << event.progress.hosts_up << " up" << std::endl;
+        });
+        for (const auto& run : finished) {
+            if (run.cancelled) status = 2;
+            else if (run.baseline) std::cerr << "Changes in " << run.diff.summary() << std::endl;
+        }
+    }
+
+    ScannerStats stats = scanner.stats();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    std::cerr << std::fixed << std::setprecision(1) << "Scanned " << stats.completed << " tasks, " << stats.hosts
+              << " hosts in " << seconds << " s (" << stats.hosts_per_second << " hosts/s)" << std::endl;
+    const trace::Stats& totals = trace::stats();
+    std::cerr << std::fixed << std::setprecision(1) << "Lock contention: " << totals.lock_waits.load() << " waits, "
+              << totals.lock_wait_us.load() / 1000.0 << " ms blocked" << std::endl;
+
+    std::vector<std::string> cidrs(targets.begin(), targets.end());
+    run_show(cidrs);
+    return status;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    std::string db_path = ScanDatabase::default_path();
+    std::string trace_path;
+    bool use_db = true;
+    int i = 1;
+    for (; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--db" && i + 1 < argc) {
+            db_path = argv[++i];
+        } else if (arg == "--no-db") {
+            use_db = false;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else {
+            break;
+        }
+    }
+    if (i >= argc) return usage(argv[0]);
+    const std::string command = argv[i];
+    std::vector<std::string> args(argv + i + 1, argv + argc);
+
+    if (!trace_path.empty()) {
+        trace::recorder().set_thread_name("main");
+        trace::recorder().start();
+    }
+
+    if (use_db) {
+        try {
+            nmapVisualizerGlobals::database.open(db_path);
+            const size_t hosts = nmapVisualizerGlobals::database.load_into(nmapVisualizerGlobals::store);
+            std::cerr << "Loaded " << hosts << " host records from " << db_path << std::endl;
+        } catch (const std::exception &e) {
+            std::cerr << "Error opening scan database: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    xmlInitParser();
+    int status;
+    if (command == "scan") status = run_scan(args);
+    else if (command == "import") status = run_import(args);
+    else if (command == "show") status = run_show(args);
+    else if (command == "export") status = run_export(args);
+    else if (command == "monitor") status = run_monitor(args);
+    else status = usage(argv[0]);
+    xmlCleanupParser();
+
+    if (!trace_path.empty()) {
+        trace::recorder().stop();
+        try {
+            const size_t events = trace::recorder().write_json(trace_path);
+            std::cerr << "Wrote " << events << " trace events to " << trace_path << std::endl;
+        } catch (const std::exception &e) {
+            std::cerr << "Error writing trace: " << e.what() << std::endl;
+            if (status == 0) status = 1;
+        }
+    }
+    return status;
+}
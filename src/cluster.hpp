@@ -0,0 +1,71 @@
+#ifndef CLUSTER_HPP
+#define CLUSTER_HPP
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+#include "globals.hpp"
+
+// What devices are grouped by when a network is drawn zoomed out
+enum class ClusterMode : uint8_t { Subnet, Vendor, Service };
+
+// Grouping key: the /24 (IPv4) or /64 (IPv6), the vendor, or the first open service
+inline std::string cluster_key(const DeviceInfo &device, ClusterMode mode) {
+    switch (mode) {
+        case ClusterMode::Subnet: {
+            if (!device.ipAddress.valid()) return "Unknown";
+            IpAddress prefix = device.ipAddress;
+            if (prefix.family == 4) {
+                prefix.bytes[3] = 0;
+                return prefix.to_string() + "/24";
+            }
+            std::fill(prefix.bytes.begin() + 8, prefix.bytes.end(), 0);
+            return prefix.to_string() + "/64";
+        }
+        case ClusterMode::Vendor:
+            return device.vendor.empty() ? "Unknown" : device.vendor.str();
+        case ClusterMode::Service:
+            for (const auto& port : device.ports) {
+                if (port.state != PortState::Open) continue;
+                if (!port.service.empty()) return port.service.str();
+                return std::to_string(port.portNumber) + "/" + to_string(port.protocol);
+            }
+            return "no open ports";
+    }
+    return "Unknown";
+}
+
+// Devices of one network partitioned into groups, in first-seen order
+class Clustering {
+public:
+    std::vector<std::string> keys;
+    std::vector<uint32_t> counts;
+    std::vector<uint32_t> cluster_of;  // device index -> cluster index
+
+    size_t size() const { return keys.size(); }
+
+    void build(const std::vector<std::shared_ptr<const DeviceInfo>> &devices, ClusterMode mode) {
+        keys.clear();
+        counts.clear();
+        cluster_of.resize(devices.size());
+
+        std::unordered_map<std::string, uint32_t> index;
+        for (size_t i = 0; i < devices.size(); i++) {
+            std::string key = cluster_key(*devices[i], mode);
+            auto it = index.find(key);
+            if (it == index.end()) {
+                it = index.emplace(key, static_cast<uint32_t>(keys.size())).first;
+                keys.push_back(std::move(key));
+                counts.push_back(0);
+            }
+            counts[it->second]++;
+            cluster_of[i] = it->second;
+        }
+    }
+};
+
+#endif // CLUSTER_HPP
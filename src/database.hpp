@@ -0,0 +1,614 @@
+#ifndef DATABASE_HPP
+#define DATABASE_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "globals.hpp"
+#include "store.hpp"
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+SCAN DATABASE FORMAT (version 2, host byte order)
+
+FileHeader                        16 bytes
+{ SegmentHeader, payload }*       payload padded to 8 bytes
+
+Strings segment: count x uint32 length, then the bytes back to back. File
+string ids continue from the previous Strings segment; id 0 is "".
+
+Hosts segment:   uint32 cidr string id, uint32 port count, count x HostRecord,
+then the PortRecords of all hosts in host order.
+
+Version 1 host records lack last_scanned (40 bytes); such files are still
+read and are rewritten as version 2 when opened for writing.
+
+Segments are only ever appended. Loading replays Hosts segments in order as
+upserts, so a rescanned host simply appears again later in the file; compact()
+rewrites the file from a snapshot when that history is no longer wanted. A
+segment cut short by a crash, or whose sizes do not add up, ends the readable
+part of the file and is truncated on the next open. Host records with an
+unknown address family, protocol or port state are skipped.
+
+The file is mapped only to read it without an extra copy: loading still
+decodes every host record and upserts it (bench_database: about 5 us per host
+with three ports on the dev box). load_compacting() compacts once the history
+outweighs the live hosts, so start-up time follows the hosts rather than the
+number of rescans.
+*/
+namespace scandb {
+
+constexpr char kMagic[8] = {'N', 'M', 'V', 'S', 'D', 'B', '\0', '\0'};
+constexpr uint32_t kVersion = 2;
+
+enum SegmentKind : uint32_t { Strings = 1, Hosts = 2 };
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+};
+
+struct SegmentHeader {
+    uint32_t kind;
+    uint32_t count;
+    uint64_t size;  // payload bytes, including padding
+};
+
+struct HostRecord {
+    uint8_t ip[16];
+    uint8_t mac[6];
+    uint8_t family;
+    uint8_t has_mac;
+    uint32_t vendor;
+    uint32_t device_type;
+    uint32_t os;
+    uint32_t port_count;
+    int64_t last_scanned;  // version 2+
+};
+
+constexpr size_t kHostRecordV1Size = 40;
+
+struct PortRecord {
+    uint16_t number;
+    uint8_t protocol;
+    uint8_t state;
+    uint32_t service;
+};
+
+static_assert(sizeof(FileHeader) == 16, "unexpected FileHeader padding");
+static_assert(sizeof(SegmentHeader) == 16, "unexpected SegmentHeader padding");
+static_assert(sizeof(HostRecord) == 48, "unexpected HostRecord padding");
+static_assert(sizeof(PortRecord) == 8, "unexpected PortRecord padding");
+
+inline size_t padded(size_t size) { return (size + 7) & ~size_t{7}; }
+
+// Read-only view of a whole file
+class MappedFile {
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#endif
+
+public:
+    explicit MappedFile(const std::string &path) {
+#if defined(_WIN32) || defined(_WIN64)
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) throw std::runtime_error("cannot open " + path);
+        LARGE_INTEGER size;
+        GetFileSizeEx(file_, &size);
+        size_ = static_cast<size_t>(size.QuadPart);
+        if (size_ == 0) return;
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping_) throw std::runtime_error("cannot map " + path);
+        data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        if (!data_) throw std::runtime_error("cannot map " + path);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::runtime_error("cannot open " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("cannot stat " + path);
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("cannot map " + path);
+            }
+            madvise(mapped, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const uint8_t*>(mapped);
+        }
+        ::close(fd);
+#endif
+    }
+
+    ~MappedFile() {
+#if defined(_WIN32) || defined(_WIN64)
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+#else
+        if (data_) munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+};
+
+template <typename T>
+inline T read_at(const uint8_t* data, size_t offset) {
+    T value;
+    std::memcpy(&value, data + offset, sizeof(T));
+    return value;
+}
+
+inline size_t host_record_size(uint32_t version) {
+    return version >= 2 ? sizeof(HostRecord) : kHostRecordV1Size;
+}
+
+// Read host record h of a Hosts payload; fields missing in older versions stay zero
+inline HostRecord read_host(const uint8_t* records, size_t h, size_t record_size) {
+    HostRecord host{};
+    std::memcpy(&host, records + h * record_size, record_size);
+    return host;
+}
+
+// Enum values and address families a well-formed file can hold
+inline bool valid_family(uint8_t family) {
+    return family == 0 || family == 4 || family == 6;
+}
+
+inline bool valid_port(const PortRecord &port) {
+    return port.protocol <= static_cast<uint8_t>(Protocol::Ip) && port.state <= static_cast<uint8_t>(PortState::ClosedFiltered);
+}
+
+// The string lengths of a Strings segment must fit in its payload
+inline bool strings_fit(const uint8_t* lengths, uint32_t count, uint64_t payload_size) {
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < count; i++) total += read_at<uint32_t>(lengths, size_t{i} * 4);
+    return total <= payload_size - uint64_t{count} * 4;
+}
+
+inline uint32_t file_version(const MappedFile &file) {
+    if (file.size() < sizeof(FileHeader)) throw std::runtime_error("not a scan database (too short)");
+    FileHeader header = read_at<FileHeader>(file.data(), 0);
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) throw std::runtime_error("not a scan database");
+    if (header.version == 0 || header.version > kVersion) throw std::runtime_error("unsupported scan database version " + std::to_string(header.version));
+    return header.version;
+}
+
+// Calls on_strings(first_id, count, lengths, bytes) and on_hosts(header, payload,
+// record_size) for every complete segment; returns the offset just past the last
+// one. A segment whose sizes do not add up ends the walk like a truncated tail
+template <typename OnStrings, typename OnHosts>
+inline size_t walk(const MappedFile &file, OnStrings &&on_strings, OnHosts &&on_hosts) {
+    const uint8_t* data = file.data();
+    const size_t size = file.size();
+    const size_t record_size = host_record_size(file_version(file));
+
+    uint32_t next_string = 1;
+    size_t offset = sizeof(FileHeader);
+    while (offset + sizeof(SegmentHeader) <= size) {
+        SegmentHeader segment = read_at<SegmentHeader>(data, offset);
+        const size_t payload = offset + sizeof(SegmentHeader);
+        if (segment.size > size - payload) break;  // truncated tail
+
+        if (segment.kind == Strings) {
+            if (size_t{segment.count} * 4 > segment.size) break;
+            if (!strings_fit(data + payload, segment.count, segment.size)) break;
+            on_strings(next_string, segment.count, data + payload, data + payload + size_t{segment.count} * 4);
+            next_string += segment.count;
+        } else if (segment.kind == Hosts) {
+            if (8 + size_t{segment.count} * record_size > segment.size) break;
+            on_hosts(segment, data + payload, record_size);
+        }
+        offset = payload + segment.size;
+    }
+    return offset;
+}
+
+} // namespace scandb
+
+// Append-only on-disk copy of the network store
+class ScanDatabase {
+private:
+    std::string path_;
+    std::FILE* file_ = nullptr;
+    std::unordered_map<uint32_t, uint32_t> file_ids_;  // InternedString id -> file string id
+    uint32_t next_file_id_ = 1;
+    mutable std::mutex mutex_;
+
+    // Strings a batch adds to the file's table; they join file_ids_ only once
+    // the batch is written, so a failed write cannot leave ids the file lacks
+    struct NewStrings {
+        std::unordered_map<uint32_t, uint32_t> ids;  // InternedString id -> file string id
+        std::vector<std::string_view> values;        // in file id order
+    };
+
+    // Caller holds mutex_
+    uint32_t string_id(InternedString value, NewStrings &added) const {
+        if (value.empty()) return 0;
+        auto it = file_ids_.find(value.id());
+        if (it != file_ids_.end()) return it->second;
+        const uint32_t id = next_file_id_ + static_cast<uint32_t>(added.values.size());
+        auto [pending, inserted] = added.ids.emplace(value.id(), id);
+        if (inserted) added.values.push_back(value.str());
+        return pending->second;
+    }
+
+    // Caller holds mutex_
+    void write_segment(std::FILE* out, uint32_t kind, uint32_t count, const std::vector<uint8_t> &payload) {
+        std::vector<uint8_t> buffer(sizeof(scandb::SegmentHeader) + scandb::padded(payload.size()), 0);
+        scandb::SegmentHeader header{kind, count, scandb::padded(payload.size())};
+        std::memcpy(buffer.data(), &header, sizeof(header));
+        if (!payload.empty()) std::memcpy(buffer.data() + sizeof(header), payload.data(), payload.size());
+        if (std::fwrite(buffer.data(), 1, buffer.size(), out) != buffer.size()) {
+            throw std::runtime_error("failed writing " + path_);
+        }
+    }
+
+    template <typename T>
+    static void put(std::vector<uint8_t> &out, const T &value) {
+        const size_t at = out.size();
+        out.resize(at + sizeof(T));
+        std::memcpy(out.data() + at, &value, sizeof(T));
+    }
+
+    // Caller holds mutex_; writes a Strings segment (if needed) and a Hosts
+    // segment, and flushes them before the new string ids are committed
+    void write_hosts(std::FILE* out, const std::string &cidr, const std::vector<const DeviceInfo*> &devices) {
+        NewStrings added;
+        std::vector<scandb::HostRecord> hosts;
+        std::vector<scandb::PortRecord> ports;
+        hosts.reserve(devices.size());
+
+        const uint32_t cidr_id = string_id(InternedString(cidr), added);
+        for (const DeviceInfo* device : devices) {
+            scandb::HostRecord host{};
+            std::memcpy(host.ip, device->ipAddress.bytes.data(), sizeof(host.ip));
+            std::memcpy(host.mac, device->macAddress.bytes.data(), sizeof(host.mac));
+            host.family = device->ipAddress.family;
+            host.has_mac = device->macAddress.valid() ? 1 : 0;
+            host.vendor = string_id(device->vendor, added);
+            host.device_type = string_id(device->deviceType, added);
+            host.os = string_id(device->operatingSystem, added);
+            host.port_count = static_cast<uint32_t>(device->ports.size());
+            host.last_scanned = device->lastScanned;
+            for (const Port& port : device->ports) {
+                ports.push_back(scandb::PortRecord{port.portNumber, static_cast<uint8_t>(port.protocol),
+                                                   static_cast<uint8_t>(port.state), string_id(port.service, added)});
+            }
+            hosts.push_back(host);
+        }
+
+        if (!added.values.empty()) {
+            std::vector<uint8_t> payload;
+            for (std::string_view s : added.values) put(payload, static_cast<uint32_t>(s.size()));
+            for (std::string_view s : added.values) payload.insert(payload.end(), s.begin(), s.end());
+            write_segment(out, scandb::Strings, static_cast<uint32_t>(added.values.size()), payload);
+        }
+
+        std::vector<uint8_t> payload;
+        payload.reserve(8 + hosts.size() * sizeof(scandb::HostRecord) + ports.size() * sizeof(scandb::PortRecord));
+        put(payload, cidr_id);
+        put(payload, static_cast<uint32_t>(ports.size()));
+        for (const auto& host : hosts) put(payload, host);
+        for (const auto& port : ports) put(payload, port);
+        write_segment(out, scandb::Hosts, static_cast<uint32_t>(hosts.size()), payload);
+        if (std::fflush(out) != 0) throw std::runtime_error("failed writing " + path_);
+
+        file_ids_.insert(added.ids.begin(), added.ids.end());
+        next_file_id_ += static_cast<uint32_t>(added.values.size());
+    }
+
+    // Caller holds mutex_; drops whatever a failed append left after `size`
+    // bytes, including data still buffered in file_, and reopens for appending
+    void truncate_locked(uintmax_t size) {
+        std::fclose(file_);
+        file_ = nullptr;
+        std::error_code ec;
+        std::filesystem::resize_file(path_, size, ec);
+        if (ec) std::cerr << "Error truncating " << path_ << ": " << ec.message() << std::endl;
+        file_ = std::fopen(path_.c_str(), "ab");
+    }
+
+    // Caller holds mutex_
+    void write_header(std::FILE* out) {
+        scandb::FileHeader header{};
+        std::memcpy(header.magic, scandb::kMagic, sizeof(header.magic));
+        header.version = scandb::kVersion;
+        if (std::fwrite(&header, sizeof(header), 1, out) != 1) throw std::runtime_error("failed writing " + path_);
+    }
+
+    // Caller holds mutex_
+    void close_locked() {
+        if (file_) std::fclose(file_);
+        file_ = nullptr;
+        file_ids_.clear();
+        next_file_id_ = 1;
+    }
+
+    // Caller holds mutex_; replaces the file at path_ with the snapshot's hosts
+    void rewrite_locked(const StoreSnapshot &snapshot) {
+        const std::string path = path_;
+        const std::string temp = path + ".tmp";
+        close_locked();
+        path_ = path;
+
+        std::FILE* out = std::fopen(temp.c_str(), "wb");
+        if (!out) throw std::runtime_error("cannot create " + temp);
+        try {
+            write_header(out);
+            for (const auto& network : snapshot.networks) {
+                std::vector<const DeviceInfo*> devices;
+                devices.reserve(network->devices.size());
+                for (const auto& device : network->devices) devices.push_back(device.get());
+                if (!devices.empty()) write_hosts(out, network->cidr, devices);
+            }
+        } catch (...) {
+            std::fclose(out);
+            std::remove(temp.c_str());
+            file_ids_.clear();
+            next_file_id_ = 1;
+            throw;
+        }
+        std::fclose(out);
+        std::filesystem::rename(temp, path);
+
+        file_ = std::fopen(path.c_str(), "ab");
+        if (!file_) throw std::runtime_error("cannot open " + path + " for writing");
+    }
+
+public:
+    ScanDatabase() = default;
+    ~ScanDatabase() { close(); }
+
+    ScanDatabase(const ScanDatabase&) = delete;
+    ScanDatabase& operator=(const ScanDatabase&) = delete;
+
+    // $XDG_DATA_HOME/nmapVisualizer/scans.nvdb, or %APPDATA%\nmapVisualizer\scans.nvdb on Windows
+    static std::string default_path() {
+        std::filesystem::path base;
+#if defined(_WIN32) || defined(_WIN64)
+        if (const char* appdata = std::getenv("APPDATA")) base = appdata;
+#else
+        if (const char* xdg = std::getenv("XDG_DATA_HOME"); xdg && *xdg) {
+            base = xdg;
+        } else if (const char* home = std::getenv("HOME")) {
+            base = std::filesystem::path(home) / ".local" / "share";
+        }
+#endif
+        if (base.empty()) base = std::filesystem::current_path();
+        return (base / "nmapVisualizer" / "scans.nvdb").string();
+    }
+
+    // Open (creating if needed) for appending; a truncated tail is cut off
+    void open(const std::string &path) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        close_locked();
+        path_ = path;
+
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+        if (!std::filesystem::exists(path) || std::filesystem::file_size(path) == 0) {
+            std::FILE* out = std::fopen(path.c_str(), "wb");
+            if (!out) throw std::runtime_error("cannot create " + path);
+            write_header(out);
+            std::fclose(out);
+        }
+
+        size_t valid_end;
+        bool upgrade = false;
+        {
+            scandb::MappedFile mapped(path);
+            upgrade = scandb::file_version(mapped) < scandb::kVersion;
+            valid_end = scandb::walk(mapped,
+                [this](uint32_t first, uint32_t count, const uint8_t* lengths, const uint8_t* bytes) {
+                    size_t at = 0;
+                    for (uint32_t i = 0; i < count; i++) {
+                        const uint32_t length = scandb::read_at<uint32_t>(lengths, size_t{i} * 4);
+                        InternedString value(std::string_view(reinterpret_cast<const char*>(bytes) + at, length));
+                        file_ids_.emplace(value.id(), first + i);
+                        at += length;
+                    }
+                    next_file_id_ = first + count;
+                },
+                [](const scandb::SegmentHeader&, const uint8_t*, size_t) {});
+            if (valid_end < mapped.size()) {
+                std::cerr << "Warning: dropping " << mapped.size() - valid_end << " bytes of incomplete or corrupt data from " << path << std::endl;
+            }
+        }
+        if (valid_end < std::filesystem::file_size(path)) std::filesystem::resize_file(path, valid_end);
+
+        if (upgrade) {
+            // Older files are rewritten once so new records can be appended
+            NetworkStore contents;
+            load_file(path, contents);
+            rewrite_locked(*contents.snapshot());
+            return;
+        }
+
+        file_ = std::fopen(path.c_str(), "ab");
+        if (!file_) throw std::runtime_error("cannot open " + path + " for writing");
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        close_locked();
+    }
+
+    bool is_open() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return file_ != nullptr;
+    }
+
+    std::string path() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return path_;
+    }
+
+    // Append one batch of scanned hosts; does nothing when no database is open
+    void append(const std::string &cidr, const std::vector<DeviceInfo> &devices) {
+        trace::Scope scope("store", "database append");
+        auto lock = trace::timed_lock(mutex_, "database lock");
+        if (!file_ || devices.empty()) return;
+        std::vector<const DeviceInfo*> pointers;
+        pointers.reserve(devices.size());
+        for (const auto& device : devices) pointers.push_back(&device);
+        // file_ is flushed after every batch, so its size on disk is where this one starts
+        const uintmax_t start = std::filesystem::file_size(path_);
+        try {
+            write_hosts(file_, cidr, pointers);
+        } catch (...) {
+            truncate_locked(start);
+            throw;
+        }
+    }
+
+    // Decode every host record in the file and replay them into the store;
+    // returns the number of host records read
+    size_t load_into(NetworkStore &store) const {
+        trace::Scope scope("store", "database load");
+        return load_file(path(), store);
+    }
+
+    // load_into an empty store, then compact the file when rescans have left
+    // more than twice as many records as live hosts, so the next start-up
+    // replays one segment per network instead of the whole history
+    size_t load_compacting(NetworkStore &store) {
+        trace::Scope scope("store", "database load");
+        auto lock = trace::timed_lock(mutex_, "database lock");
+        if (path_.empty()) throw std::runtime_error("no scan database open");
+        const size_t records = load_file(path_, store);
+        auto snapshot = store.snapshot();
+        if (file_ && records > 2 * snapshot->device_count()) rewrite_locked(*snapshot);
+        return records;
+    }
+
+    static size_t load_file(const std::string &path, NetworkStore &store) {
+        scandb::MappedFile mapped(path);
+
+        std::vector<InternedString> strings(1);
+        std::map<std::string, std::vector<DeviceInfo>> by_cidr;
+        std::vector<std::string> order;  // first-seen network order
+        size_t hosts = 0;
+
+        scandb::walk(mapped,
+            [&strings](uint32_t first, uint32_t count, const uint8_t* lengths, const uint8_t* bytes) {
+                strings.resize(first);
+                size_t at = 0;
+                for (uint32_t i = 0; i < count; i++) {
+                    const uint32_t length = scandb::read_at<uint32_t>(lengths, size_t{i} * 4);
+                    strings.emplace_back(std::string_view(reinterpret_cast<const char*>(bytes) + at, length));
+                    at += length;
+                }
+            },
+            [&](const scandb::SegmentHeader &segment, const uint8_t* payload, size_t record_size) {
+                auto str = [&strings](uint32_t id) { return id < strings.size() ? strings[id] : InternedString(); };
+                const std::string& cidr = str(scandb::read_at<uint32_t>(payload, 0)).str();
+                const uint32_t port_total = scandb::read_at<uint32_t>(payload, 4);
+                const uint8_t* host_data = payload + 8;
+                const uint8_t* port_data = host_data + size_t{segment.count} * record_size;
+                if (8 + size_t{segment.count} * record_size + size_t{port_total} * sizeof(scandb::PortRecord) > segment.size) return;
+
+                auto [it, inserted] = by_cidr.try_emplace(cidr);
+                if (inserted) order.push_back(cidr);
+                std::vector<DeviceInfo>& devices = it->second;
+                devices.reserve(devices.size() + segment.count);
+
+                size_t port_index = 0;
+                for (uint32_t h = 0; h < segment.count; h++) {
+                    auto host = scandb::read_host(host_data, h, record_size);
+                    if (port_index + host.port_count > port_total) break;
+
+                    // Corrupt records are skipped rather than turned into enum values that do not exist
+                    bool valid = scandb::valid_family(host.family);
+                    for (uint32_t p = 0; valid && p < host.port_count; p++) {
+                        valid = scandb::valid_port(scandb::read_at<scandb::PortRecord>(port_data, (port_index + p) * sizeof(scandb::PortRecord)));
+                    }
+                    if (!valid) {
+                        port_index += host.port_count;
+                        continue;
+                    }
+
+                    IpAddress ip;
+                    ip.family = host.family;
+                    std::memcpy(ip.bytes.data(), host.ip, sizeof(host.ip));
+                    MacAddress mac;
+                    mac.set = host.has_mac != 0;
+                    std::memcpy(mac.bytes.data(), host.mac, sizeof(host.mac));
+
+                    std::vector<Port> ports;
+                    ports.reserve(host.port_count);
+                    for (uint32_t p = 0; p < host.port_count; p++, port_index++) {
+                        auto port = scandb::read_at<scandb::PortRecord>(port_data, port_index * sizeof(scandb::PortRecord));
+                        ports.emplace_back(port.number, static_cast<Protocol>(port.protocol),
+                                           static_cast<PortState>(port.state), str(port.service));
+                    }
+                    devices.emplace_back(ip, mac, str(host.vendor), str(host.device_type), std::move(ports), str(host.os));
+                    devices.back().lastScanned = host.last_scanned;
+                    hosts++;
+                }
+            });
+
+        // One upsert per network keeps the load linear in the number of hosts
+        for (const auto& cidr : order) store.upsert(cidr, std::move(by_cidr[cidr]));
+        return hosts;
+    }
+
+    // Rewrite the file with exactly the hosts in the snapshot (one segment per network)
+    void compact(const StoreSnapshot &snapshot) {
+        trace::Scope scope("store", "database compact");
+        auto lock = trace::timed_lock(mutex_, "database lock");
+        if (path_.empty()) throw std::runtime_error("no scan database open");
+        rewrite_locked(snapshot);
+    }
+
+    // Drop every stored host but keep the database open
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (path_.empty()) return;
+        close_locked();
+        std::FILE* out = std::fopen(path_.c_str(), "wb");
+        if (!out) throw std::runtime_error("cannot create " + path_);
+        write_header(out);
+        std::fclose(out);
+        file_ = std::fopen(path_.c_str(), "ab");
+        if (!file_) throw std::runtime_error("cannot open " + path_ + " for writing");
+    }
+};
+
+namespace nmapVisualizerGlobals {
+    extern ScanDatabase database;
+}
+
+#endif // DATABASE_HPP
@@ -0,0 +1,176 @@
+#ifndef DIFF_HPP
+#define DIFF_HPP
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "globals.hpp"
+#include "store.hpp"
+
+enum class HostChange : uint8_t { None, Added, Removed, Changed };
+
+// One port whose state or service differs between the two sides
+struct PortChange {
+    uint16_t portNumber;
+    Protocol protocol;
+    PortState before;   // PortState::Unknown when the port was not listed
+    PortState after;
+    InternedString service_before;
+    InternedString service_after;
+
+    bool opened() const { return after == PortState::Open && before != PortState::Open; }
+    bool closed() const { return before == PortState::Open && after != PortState::Open; }
+};
+
+struct HostDiff {
+    HostChange kind = HostChange::None;
+    std::shared_ptr<const DeviceInfo> before;  // null for Added
+    std::shared_ptr<const DeviceInfo> after;   // null for Removed
+    std::vector<PortChange> ports;
+    bool os_changed = false;
+    bool vendor_changed = false;
+    bool mac_changed = false;
+};
+
+// Changed hosts of one network (unchanged hosts are not listed)
+struct NetworkDiff {
+    std::string cidr;
+    std::vector<HostDiff> hosts;
+    size_t added = 0, removed = 0, changed = 0;
+    size_t ports_opened = 0, ports_closed = 0;
+
+    bool empty() const { return hosts.empty(); }
+
+    std::string summary() const {
+        return cidr + ": " + std::to_string(added) + " new, " + std::to_string(removed) + " gone, "
+             + std::to_string(changed) + " changed (" + std::to_string(ports_opened) + " ports opened, "
+             + std::to_string(ports_closed) + " closed)";
+    }
+};
+
+namespace diff_detail {
+
+inline uint32_t port_key(const Port &port) {
+    return (static_cast<uint32_t>(port.protocol) << 16) | port.portNumber;
+}
+
+// Sort-merge join of two small port lists on (protocol, number)
+inline void diff_ports(const std::vector<Port> &before, const std::vector<Port> &after, std::vector<PortChange> &out) {
+    auto sorted = [](const std::vector<Port> &ports) {
+        std::vector<const Port*> result;
+        result.reserve(ports.size());
+        for (const auto& port : ports) result.push_back(&port);
+        std::sort(result.begin(), result.end(), [](const Port* a, const Port* b) { return port_key(*a) < port_key(*b); });
+        return result;
+    };
+    const auto a = sorted(before), b = sorted(after);
+    size_t i = 0, j = 0;
+    while (i < a.size() || j < b.size()) {
+        const Port* left = i < a.size() ? a[i] : nullptr;
+        const Port* right = j < b.size() ? b[j] : nullptr;
+        if (left && (!right || port_key(*left) < port_key(*right))) {
+            out.push_back(PortChange{left->portNumber, left->protocol, left->state, PortState::Unknown, left->service, {}});
+            i++;
+        } else if (right && (!left || port_key(*right) < port_key(*left))) {
+            out.push_back(PortChange{right->portNumber, right->protocol, PortState::Unknown, right->state, {}, right->service});
+            j++;
+        } else {
+            if (left->state != right->state || left->service != right->service) {
+                out.push_back(PortChange{left->portNumber, left->protocol, left->state, right->state, left->service, right->service});
+            }
+            i++;
+            j++;
+        }
+    }
+}
+
+inline const std::shared_ptr<const DeviceInfo>* find_match(const NetworkData &network, const DeviceInfo &device) {
+    if (device.ipAddress.valid()) {
+        const size_t* index = network.by_ip.find(device.ipAddress);
+        return index ? &network.devices[*index] : nullptr;
+    }
+    if (device.macAddress.valid()) {
+        const size_t* index = network.by_mac.find(device.macAddress);
+        return index ? &network.devices[*index] : nullptr;
+    }
+    return nullptr;
+}
+
+} // namespace diff_detail
+
+// Compare two versions of a network, matching hosts by IP (or MAC for hosts
+// without an IP) through the networks' hash indexes: O(n) overall. Either side
+// may be null (treated as empty). Unchanged hosts shared between snapshots are
+// recognized by pointer and cost a single comparison.
+inline NetworkDiff diff_networks(const NetworkData* before, const NetworkData* after) {
+    NetworkDiff diff;
+    diff.cidr = after ? after->cidr : (before ? before->cidr : std::string());
+    static const NetworkData empty;
+    const NetworkData& old_network = before ? *before : empty;
+    const NetworkData& new_network = after ? *after : empty;
+
+    for (const auto& old_device : old_network.devices) {
+        const auto* match = diff_detail::find_match(new_network, *old_device);
+        if (!match) {
+            HostDiff host;
+            host.kind = HostChange::Removed;
+            host.before = old_device;
+            diff.removed++;
+            diff.hosts.push_back(std::move(host));
+            continue;
+        }
+        const auto& new_device = *match;
+        if (new_device == old_device) continue;
+
+        HostDiff host;
+        diff_detail::diff_ports(old_device->ports, new_device->ports, host.ports);
+        host.os_changed = old_device->operatingSystem != new_device->operatingSystem;
+        host.vendor_changed = old_device->vendor != new_device->vendor;
+        host.mac_changed = old_device->macAddress != new_device->macAddress;
+        if (host.ports.empty() && !host.os_changed && !host.vendor_changed && !host.mac_changed) continue;
+
+        host.kind = HostChange::Changed;
+        host.before = old_device;
+        host.after = new_device;
+        for (const auto& port : host.ports) {
+            if (port.opened()) diff.ports_opened++;
+            if (port.closed()) diff.ports_closed++;
+        }
+        diff.changed++;
+        diff.hosts.push_back(std::move(host));
+    }
+
+    for (const auto& new_device : new_network.devices) {
+        if (diff_detail::find_match(old_network, *new_device)) continue;
+        HostDiff host;
+        host.kind = HostChange::Added;
+        host.after = new_device;
+        diff.added++;
+        diff.hosts.push_back(std::move(host));
+    }
+    return diff;
+}
+
+// Index a plain list of scanned hosts like the store does, so one scan run can
+// be diffed against a stored network
+inline NetworkData make_network(const std::string &cidr, const std::vector<std::shared_ptr<const DeviceInfo>> &devices) {
+    NetworkData network;
+    network.cidr = cidr;
+    persistent::Transaction tx;
+    for (const auto& device : devices) {
+        const size_t index = network.devices.size();
+        if (device->ipAddress.valid()) {
+            if (!network.by_ip.insert(device->ipAddress, index, tx)) continue;
+        } else if (device->macAddress.valid()) {
+            if (!network.by_mac.insert(device->macAddress, index, tx)) continue;
+        }
+        if (device->ipAddress.valid() && device->macAddress.valid()) network.by_mac.insert(device->macAddress, index, tx);
+        network.devices.push_back(device, tx);
+    }
+    return network;
+}
+
+#endif // DIFF_HPP
@@ -0,0 +1,461 @@
+#ifndef EXPORT_HPP
+#define EXPORT_HPP
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "globals.hpp"
+#include "store.hpp"
+#include "trace.hpp"
+
+/*
+Export of a store snapshot as CSV, JSON Lines, GraphML or Graphviz DOT.
+
+Hosts are formatted in fixed-size chunks on a pool of threads and written in
+snapshot order by the calling thread as soon as each chunk is ready. At most
+two chunks per thread are in flight, so memory stays bounded however large the
+inventory is. The tabular formats have one row per host; the graph formats
+have one node per network and per host, with an edge from each network to
+each of its hosts.
+*/
+
+enum class ExportFormat : uint8_t { Csv, JsonLines, GraphML, Dot };
+
+inline const char* to_string(ExportFormat format) {
+    switch (format) {
+        case ExportFormat::Csv:       return "csv";
+        case ExportFormat::JsonLines: return "jsonl";
+        case ExportFormat::GraphML:   return "graphml";
+        case ExportFormat::Dot:       return "dot";
+    }
+    return "";
+}
+
+inline std::optional<ExportFormat> parse_export_format(std::string_view text) {
+    if (text == "csv") return ExportFormat::Csv;
+    if (text == "jsonl" || text == "ndjson") return ExportFormat::JsonLines;
+    if (text == "graphml") return ExportFormat::GraphML;
+    if (text == "dot" || text == "gv") return ExportFormat::Dot;
+    return std::nullopt;
+}
+
+// Format named by the file extension ("hosts.jsonl" -> JsonLines)
+inline std::optional<ExportFormat> export_format_for_path(const std::string &path) {
+    const size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || path.find_first_of("/\\", dot) != std::string::npos) return std::nullopt;
+    std::string extension = path.substr(dot + 1);
+    for (char& c : extension) {
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+    }
+    return parse_export_format(extension);
+}
+
+struct ExportStats {
+    size_t hosts = 0;
+    size_t networks = 0;
+    uint64_t bytes = 0;
+    double seconds = 0.0;
+
+    double hosts_per_second() const { return seconds > 0.0 ? hosts / seconds : 0.0; }
+    double mb_per_second() const { return seconds > 0.0 ? bytes / 1e6 / seconds : 0.0; }
+};
+
+namespace export_detail {
+
+constexpr size_t kChunkHosts = 2048;
+
+struct Row {
+    uint32_t network;  // index into the snapshot's networks, also the graph node id
+    const DeviceInfo* device;
+};
+
+inline void append_number(std::string &out, uint64_t value) {
+    char buffer[24];
+    out.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value).ptr);
+}
+
+// Address columns are formatted into stack buffers; empty when unknown
+inline std::string_view ip_text(const IpAddress &ip, char (&buffer)[INET6_ADDRSTRLEN]) {
+    if (!ip.valid()) return {};
+    if (!inet_ntop(ip.family == 4 ? AF_INET : AF_INET6, ip.bytes.data(), buffer, sizeof(buffer))) return {};
+    return buffer;
+}
+
+inline std::string_view mac_text(const MacAddress &mac, char (&buffer)[18]) {
+    if (!mac.valid()) return {};
+    static constexpr char kHex[] = "0123456789ABCDEF";
+    for (int i = 0; i < 6; i++) {
+        buffer[3 * i] = kHex[mac.bytes[i] >> 4];
+        buffer[3 * i + 1] = kHex[mac.bytes[i] & 0xF];
+        if (i < 5) buffer[3 * i + 2] = ':';
+    }
+    return std::string_view(buffer, 17);
+}
+
+// Quoted only when needed (RFC 4180)
+inline void append_csv(std::string &out, std::string_view text) {
+    if (text.find_first_of(",\"\r\n") == std::string_view::npos) {
+        out += text;
+        return;
+    }
+    out += '"';
+    for (char c : text) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+inline void append_json(std::string &out, std::string_view text) {
+    out += '"';
+    for (char c : text) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                    out += escaped;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+inline void append_xml(std::string &out, std::string_view text) {
+    for (char c : text) {
+        switch (c) {
+            case '&': out += "&amp;"; break;
+            case '<': out += "&lt;"; break;
+            case '>': out += "&gt;"; break;
+            case '"': out += "&quot;"; break;
+            default:
+                // control characters other than tab/newline are not valid XML 1.0
+                if (static_cast<unsigned char>(c) >= 0x20 || c == '\t' || c == '\n') out += c;
+        }
+    }
+}
+
+// Inside a DOT quoted string
+inline void append_dot(std::string &out, std::string_view text) {
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) out += c;
+    }
+}
+
+// "22/tcp(ssh);80/tcp(http)", built in a reused buffer
+inline std::string_view open_ports(const DeviceInfo &device, std::string &result) {
+    result.clear();
+    for (const auto& port : device.ports) {
+        if (port.state != PortState::Open) continue;
+        if (!result.empty()) result += ';';
+        append_number(result, port.portNumber);
+        result += '/';
+        result += to_string(port.protocol);
+        if (!port.service.empty()) {
+            result += '(';
+            result += port.service.str();
+            result += ')';
+        }
+    }
+    return result;
+}
+
+inline void append_graphml_data(std::string &out, const char* key, std::string_view value) {
+    if (value.empty()) return;
+    out += "      <data key=\"";
+    out += key;
+    out += "\">";
+    append_xml(out, value);
+    out += "</data>\n";
+}
+
+inline void format_row(std::string &out, ExportFormat format, const StoreSnapshot &snapshot, const Row &row, size_t host) {
+    const DeviceInfo& device = *row.device;
+    const std::string& cidr = snapshot.networks[row.network]->cidr;
+    char ip_buffer[INET6_ADDRSTRLEN], mac_buffer[18];
+    const std::string_view ip = ip_text(device.ipAddress, ip_buffer);
+    const std::string_view mac = mac_text(device.macAddress, mac_buffer);
+    thread_local std::string ports_buffer;
+    switch (format) {
+        case ExportFormat::Csv:
+            append_csv(out, cidr);
+            out += ',';
+            append_csv(out, ip);
+            out += ',';
+            append_csv(out, mac);
+            out += ',';
+            append_csv(out, device.vendor.str());
+            out += ',';
+            append_csv(out, device.deviceType.str());
+            out += ',';
+            append_csv(out, device.operatingSystem.str());
+            out += ',';
+            append_number(out, static_cast<uint64_t>(std::max<int64_t>(device.lastScanned, 0)));
+            out += ',';
+            append_csv(out, open_ports(device, ports_buffer));
+            out += '\n';
+            break;
+
+        case ExportFormat::JsonLines:
+            out += "{\"network\":";
+            append_json(out, cidr);
+            out += ",\"ip\":";
+            append_json(out, ip);
+            out += ",\"mac\":";
+            append_json(out, mac);
+            out += ",\"vendor\":";
+            append_json(out, device.vendor.str());
+            out += ",\"hostname\":";
+            append_json(out, device.deviceType.str());
+            out += ",\"os\":";
+            append_json(out, device.operatingSystem.str());
+            out += ",\"last_scanned\":";
+            append_number(out, static_cast<uint64_t>(std::max<int64_t>(device.lastScanned, 0)));
+            out += ",\"ports\":[";
+            for (size_t i = 0; i < device.ports.size(); i++) {
+                const Port& port = device.ports[i];
+                out += i ? ",{\"port\":" : "{\"port\":";
+                append_number(out, port.portNumber);
+                out += ",\"protocol\":";
+                append_json(out, to_string(port.protocol));
+                out += ",\"state\":";
+                append_json(out, to_string(port.state));
+                out += ",\"service\":";
+                append_json(out, port.service.str());
+                out += '}';
+            }
+            out += "]}\n";
+            break;
+
+        case ExportFormat::GraphML:
+            out += "    <node id=\"h";
+            append_number(out, host);
+            out += "\">\n      <data key=\"kind\">host</data>\n";
+            append_graphml_data(out, "label", ip);
+            append_graphml_data(out, "mac", mac);
+            append_graphml_data(out, "vendor", device.vendor.str());
+            append_graphml_data(out, "hostname", device.deviceType.str());
+            append_graphml_data(out, "os", device.operatingSystem.str());
+            append_graphml_data(out, "ports", open_ports(device, ports_buffer));
+            out += "    </node>\n    <edge source=\"n";
+            append_number(out, row.network);
+            out += "\" target=\"h";
+            append_number(out, host);
+            out += "\"/>\n";
+            break;
+
+        case ExportFormat::Dot: {
+            out += "  h";
+            append_number(out, host);
+            out += " [label=\"";
+            append_dot(out, ip);
+            if (!device.operatingSystem.empty()) {
+                out += "\\n";
+                append_dot(out, device.operatingSystem.str());
+            }
+            const std::string_view ports = open_ports(device, ports_buffer);
+            if (!ports.empty()) {
+                out += "\", tooltip=\"";
+                append_dot(out, ports);
+            }
+            out += "\"];\n  n";
+            append_number(out, row.network);
+            out += " -- h";
+            append_number(out, host);
+            out += ";\n";
+            break;
+        }
+    }
+}
+
+// Everything before the first host: column names, graph keys, network nodes
+inline std::string header(ExportFormat format, const StoreSnapshot &snapshot) {
+    std::string out;
+    switch (format) {
+        case ExportFormat::Csv:
+            out = "network,ip,mac,vendor,hostname,os,last_scanned,open_ports\n";
+            break;
+        case ExportFormat::JsonLines:
+            break;
+        case ExportFormat::GraphML:
+            out = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                  "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\">\n";
+            for (const char* key : {"kind", "label", "mac", "vendor", "hostname", "os", "ports"}) {
+                out += "  <key id=\"";
+                out += key;
+                out += "\" for=\"node\" attr.name=\"";
+                out += key;
+                out += "\" attr.type=\"string\"/>\n";
+            }
+            out += "  <graph id=\"nmap\" edgedefault=\"undirected\">\n";
+            for (size_t i = 0; i < snapshot.networks.size(); i++) {
+                out += "    <node id=\"n";
+                append_number(out, i);
+                out += "\">\n      <data key=\"kind\">network</data>\n";
+                append_graphml_data(out, "label", snapshot.networks[i]->cidr);
+                out += "    </node>\n";
+            }
+            break;
+        case ExportFormat::Dot:
+            out = "graph nmap {\n  node [shape=ellipse, fontsize=10];\n";
+            for (size_t i = 0; i < snapshot.networks.size(); i++) {
+                out += "  n";
+                append_number(out, i);
+                out += " [shape=box, label=\"";
+                append_dot(out, snapshot.networks[i]->cidr);
+                out += "\"];\n";
+            }
+            break;
+    }
+    return out;
+}
+
+inline const char* footer(ExportFormat format) {
+    switch (format) {
+        case ExportFormat::GraphML: return "  </graph>\n</graphml>\n";
+        case ExportFormat::Dot:     return "}\n";
+        default:                    return "";
+    }
+}
+
+} // namespace export_detail
+
+// Stream the snapshot to an open file on `jobs` formatting threads (0 = one
+// per core). Throws std::runtime_error when a write fails.
+inline ExportStats export_snapshot(const StoreSnapshot &snapshot, ExportFormat format, std::FILE* out, size_t jobs = 0) {
+    using namespace export_detail;
+    trace::Scope scope("export", "export_snapshot");
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<Row> rows;
+    rows.reserve(snapshot.device_count());
+    for (size_t i = 0; i < snapshot.networks.size(); i++) {
+        for (const auto& device : snapshot.networks[i]->devices) rows.push_back(Row{static_cast<uint32_t>(i), device.get()});
+    }
+
+    ExportStats stats;
+    stats.hosts = rows.size();
+    stats.networks = snapshot.networks.size();
+    auto write = [&](const std::string &data) {
+        if (data.empty()) return;
+        if (std::fwrite(data.data(), 1, data.size(), out) != data.size()) throw std::runtime_error("write failed");
+        stats.bytes += data.size();
+    };
+    write(header(format, snapshot));
+
+    const size_t chunks = (rows.size() + kChunkHosts - 1) / kChunkHosts;
+    if (jobs == 0) jobs = std::max(1u, std::thread::hardware_concurrency());
+    jobs = std::max<size_t>(1, std::min(jobs, chunks));
+    const size_t window = 2 * jobs;
+
+    // Chunk c is formatted into slot c % window once chunk c - window is written
+    std::vector<std::string> slots(window);
+    std::vector<bool> ready(window, false);
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_t next = 0, written = 0;
+    bool stop = false;
+
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            changed.wait(lock, [&]() { return stop || next >= chunks || next < written + window; });
+            if (stop || next >= chunks) return;
+            const size_t chunk = next++;
+            std::string buffer = std::move(slots[chunk % window]);
+            lock.unlock();
+
+            trace::Scope format_scope("export", "format chunk");
+            buffer.clear();
+            const size_t end = std::min(rows.size(), (chunk + 1) * kChunkHosts);
+            for (size_t host = chunk * kChunkHosts; host < end; host++) format_row(buffer, format, snapshot, rows[host], host);
+
+            lock.lock();
+            slots[chunk % window] = std::move(buffer);
+            ready[chunk % window] = true;
+            changed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < jobs && chunks > 0; i++) {
+        threads.emplace_back([&]() {
+            trace::recorder().set_thread_name("export worker");
+            worker();
+        });
+    }
+
+    std::string failure;
+    for (size_t chunk = 0; chunk < chunks; chunk++) {
+        std::string buffer;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&]() { return ready[chunk % window]; });
+            ready[chunk % window] = false;
+            buffer = std::move(slots[chunk % window]);
+        }
+        try {
+            write(buffer);
+        } catch (const std::exception &e) {
+            failure = e.what();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        slots[chunk % window] = std::move(buffer);  // hand the capacity back
+        written = chunk + 1;
+        stop = !failure.empty();
+        changed.notify_all();
+        if (stop) break;
+    }
+    for (auto& thread : threads) thread.join();
+    if (!failure.empty()) throw std::runtime_error(failure);
+
+    write(footer(format));
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+// Export to a file ("-" for stdout); a failed export removes the partial file
+inline ExportStats export_snapshot(const StoreSnapshot &snapshot, ExportFormat format, const std::string &path, size_t jobs = 0) {
+    if (path == "-") {
+        ExportStats stats = export_snapshot(snapshot, format, stdout, jobs);
+        std::fflush(stdout);
+        return stats;
+    }
+
+    std::FILE* out = std::fopen(path.c_str(), "wb");
+    if (!out) throw std::runtime_error("cannot create " + path);
+    ExportStats stats;
+    try {
+        stats = export_snapshot(snapshot, format, out, jobs);
+    } catch (const std::exception &e) {
+        std::fclose(out);
+        std::remove(path.c_str());
+        throw std::runtime_error("error writing " + path + ": " + e.what());
+    }
+    if (std::fclose(out) != 0) {
+        std::remove(path.c_str());
+        throw std::runtime_error("error writing " + path);
+    }
+    return stats;
+}
+
+#endif // EXPORT_HPP
@@ -1,8 +1,11 @@
 // globals.cpp
 #include "globals.hpp"
+#include "store.hpp"
+#include "database.hpp"
 
 namespace nmapVisualizerGlobals {
-	std::vector<Network> networks;
-	std::string selected = "";
-	std::mutex networks_mutex;
+	StringPool strings;
+	IpAddress selected;
+	NetworkStore store;
+	ScanDatabase database;
 }
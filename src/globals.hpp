@@ -3,27 +3,268 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
+#include <array>
+#include <atomic>
 #include <mutex>
+#include <memory>
+#include <unordered_map>
+#include <functional>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 
+#if defined(_WIN32) || defined(_WIN64)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#endif
+
+// Interning table for the few distinct strings a scan repeats millions of
+// times (services, vendors, OS names). Ids are stable for the program's
+// lifetime and id 0 is the empty string. Lookups by id are lock-free: strings
+// live in fixed-size chunks that never move once allocated.
+class StringPool {
+private:
+    static constexpr size_t kChunkBits = 12;
+    static constexpr size_t kChunkSize = size_t{1} << kChunkBits;
+    static constexpr size_t kMaxChunks = 4096;
+
+    std::array<std::atomic<std::string*>, kMaxChunks> chunks_{};
+    std::unordered_map<std::string_view, uint32_t> ids_;
+    std::atomic<uint32_t> size_{0};
+    std::mutex mutex_;
+
+public:
+    StringPool() {
+        intern("");
+    }
+
+    ~StringPool() {
+        for (auto& chunk : chunks_) delete[] chunk.load();
+    }
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    uint32_t intern(std::string_view value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = ids_.find(value);
+        if (it != ids_.end()) return it->second;
+
+        uint32_t id = size_.load(std::memory_order_relaxed);
+        size_t chunk = id >> kChunkBits;
+        if (chunk >= kMaxChunks) return 0;  // table full; degrade to empty rather than grow unbounded
+        if (!chunks_[chunk].load(std::memory_order_relaxed)) {
+            chunks_[chunk].store(new std::string[kChunkSize], std::memory_order_release);
+        }
+        std::string& slot = chunks_[chunk].load(std::memory_order_relaxed)[id & (kChunkSize - 1)];
+        slot.assign(value.data(), value.size());
+        ids_.emplace(std::string_view(slot), id);
+        size_.store(id + 1, std::memory_order_release);
+        return id;
+    }
+
+    const std::string& get(uint32_t id) const {
+        return chunks_[id >> kChunkBits].load(std::memory_order_acquire)[id & (kChunkSize - 1)];
+    }
+
+    size_t size() const { return size_.load(std::memory_order_acquire); }
+};
+
+namespace nmapVisualizerGlobals {
+    extern StringPool strings;
+}
+
+// 4-byte handle into nmapVisualizerGlobals::strings
+class InternedString {
+private:
+    uint32_t id_ = 0;
+
+public:
+    InternedString() = default;
+    InternedString(std::string_view value) : id_(nmapVisualizerGlobals::strings.intern(value)) {}
+    InternedString(const std::string &value) : InternedString(std::string_view(value)) {}
+    InternedString(const char *value) : InternedString(std::string_view(value)) {}
+
+    const std::string& str() const { return nmapVisualizerGlobals::strings.get(id_); }
+    uint32_t id() const { return id_; }
+    bool empty() const { return id_ == 0; }
+
+    bool operator==(const InternedString &other) const { return id_ == other.id_; }
+    bool operator!=(const InternedString &other) const { return id_ != other.id_; }
+};
+
+enum class Protocol : uint8_t { Unknown, Tcp, Udp, Sctp, Ip };
+
+enum class PortState : uint8_t { Unknown, Open, Closed, Filtered, Unfiltered, OpenFiltered, ClosedFiltered };
+
+inline Protocol parse_protocol(std::string_view text) {
+    if (text == "tcp") return Protocol::Tcp;
+    if (text == "udp") return Protocol::Udp;
+    if (text == "sctp") return Protocol::Sctp;
+    if (text == "ip") return Protocol::Ip;
+    return Protocol::Unknown;
+}
+
+inline const char* to_string(Protocol protocol) {
+    switch (protocol) {
+        case Protocol::Tcp:  return "tcp";
+        case Protocol::Udp:  return "udp";
+        case Protocol::Sctp: return "sctp";
+        case Protocol::Ip:   return "ip";
+        default:             return "";
+    }
+}
+
+inline PortState parse_port_state(std::string_view text) {
+    if (text == "open") return PortState::Open;
+    if (text == "closed") return PortState::Closed;
+    if (text == "filtered") return PortState::Filtered;
+    if (text == "unfiltered") return PortState::Unfiltered;
+    if (text == "open|filtered") return PortState::OpenFiltered;
+    if (text == "closed|filtered") return PortState::ClosedFiltered;
+    return PortState::Unknown;
+}
+
+inline const char* to_string(PortState state) {
+    switch (state) {
+        case PortState::Open:           return "open";
+        case PortState::Closed:         return "closed";
+        case PortState::Filtered:       return "filtered";
+        case PortState::Unfiltered:     return "unfiltered";
+        case PortState::OpenFiltered:   return "open|filtered";
+        case PortState::ClosedFiltered: return "closed|filtered";
+        default:                        return "";
+    }
+}
+
+// IPv4 or IPv6 address in network byte order (family 0 = unknown)
+class IpAddress {
+public:
+    uint8_t family = 0;  // 0, 4 or 6
+    std::array<uint8_t, 16> bytes{};
+
+    IpAddress() = default;
+
+    static IpAddress parse(const std::string &text) { return parse(text.c_str()); }
+
+    static IpAddress parse(const char *text) {
+        IpAddress ip;
+        if (inet_pton(AF_INET, text, ip.bytes.data()) == 1) {
+            ip.family = 4;
+        } else if (inet_pton(AF_INET6, text, ip.bytes.data()) == 1) {
+            ip.family = 6;
+        } else {
+            ip.bytes.fill(0);
+        }
+        return ip;
+    }
+
+    bool valid() const { return family != 0; }
+
+    std::string to_string() const {
+        if (!valid()) return "Unknown";
+        char buffer[INET6_ADDRSTRLEN] = {};
+        inet_ntop(family == 4 ? AF_INET : AF_INET6, bytes.data(), buffer, sizeof(buffer));
+        return buffer;
+    }
+
+    // IPv4 as a host-order integer (0 for anything else)
+    uint32_t v4() const {
+        if (family != 4) return 0;
+        return (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | bytes[3];
+    }
+
+    bool operator==(const IpAddress &other) const { return family == other.family && bytes == other.bytes; }
+    bool operator!=(const IpAddress &other) const { return !(*this == other); }
+};
+
+class MacAddress {
+public:
+    bool set = false;
+    std::array<uint8_t, 6> bytes{};
+
+    MacAddress() = default;
+
+    static MacAddress parse(const std::string &text) { return parse(text.c_str()); }
+
+    static MacAddress parse(const char *text) {
+        MacAddress mac;
+        unsigned int b[6];
+        if (std::sscanf(text, "%2x:%2x:%2x:%2x:%2x:%2x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) == 6) {
+            for (int i = 0; i < 6; i++) mac.bytes[i] = static_cast<uint8_t>(b[i]);
+            mac.set = true;
+        }
+        return mac;
+    }
+
+    bool valid() const { return set; }
+
+    std::string to_string() const {
+        if (!valid()) return "Unknown";
+        char buffer[18];
+        std::snprintf(buffer, sizeof(buffer), "%02X:%02X:%02X:%02X:%02X:%02X",
+                      bytes[0], bytes[1], bytes[2], bytes[3], bytes[4], bytes[5]);
+        return buffer;
+    }
+
+    bool operator==(const MacAddress &other) const { return set == other.set && bytes == other.bytes; }
+    bool operator!=(const MacAddress &other) const { return !(*this == other); }
+};
+
+struct IpAddressHash {
+    size_t operator()(const IpAddress &ip) const {
+        uint64_t hi, lo;
+        std::memcpy(&hi, ip.bytes.data(), 8);
+        std::memcpy(&lo, ip.bytes.data() + 8, 8);
+        return std::hash<uint64_t>()(hi ^ (lo * 0x9E3779B97F4A7C15ull) ^ ip.family);
+    }
+};
+
+struct MacAddressHash {
+    size_t operator()(const MacAddress &mac) const {
+        uint64_t value = 0;
+        std::memcpy(&value, mac.bytes.data(), 6);
+        return std::hash<uint64_t>()(value);
+    }
+};
+
+// 8 bytes per port: number, enums and an interned service description
 class Port {
 public:
-    int portNumber;
-    std::string protocol;
-    std::string state;
-    std::string service;
+    uint16_t portNumber;
+    Protocol protocol;
+    PortState state;
+    InternedString service;
+
+    Port(int number, Protocol proto, PortState st, InternedString serv)
+        : portNumber(static_cast<uint16_t>(number)), protocol(proto), state(st), service(serv) {}
 
     Port(int number, const std::string &proto, const std::string &st, const std::string &serv)
-        : portNumber(number), protocol(proto), state(st), service(serv) {}
+        : Port(number, parse_protocol(proto), parse_port_state(st), InternedString(serv)) {}
 };
 
 class DeviceInfo {
 public:
-    std::string ipAddress;
-    std::string macAddress;
-    std::string vendor;
-    std::string deviceType;
+    IpAddress ipAddress;
+    MacAddress macAddress;
+    InternedString vendor;
+    InternedString deviceType;
+    InternedString operatingSystem;
     std::vector<Port> ports;
-    std::string operatingSystem;
+    int64_t lastScanned = 0;  // unix seconds of the last full scan, 0 if unknown
+
+    DeviceInfo(
+        const IpAddress &ip,
+        const MacAddress &mac,
+        InternedString ven,
+        InternedString devType,
+        std::vector<Port> prt,
+        InternedString os
+    )
+        : ipAddress(ip), macAddress(mac), vendor(ven), deviceType(devType), operatingSystem(os), ports(std::move(prt)) {}
 
     DeviceInfo(
         const std::string &ip,
@@ -33,24 +274,11 @@ public:
         const std::vector<Port> &prt,
         const std::string &os
     )
-        : ipAddress(ip), macAddress(mac), vendor(ven), deviceType(devType), ports(prt), operatingSystem(os) {}
-};
-
-class Network {
-public:
-    std::string cidr;
-    std::vector<DeviceInfo> devices;
-    Network(
-        const std::string &c,
-        const std::vector<DeviceInfo> &d
-    )
-        : cidr(c), devices(d) {}
+        : DeviceInfo(IpAddress::parse(ip), MacAddress::parse(mac), ven, devType, prt, os) {}
 };
 
 namespace nmapVisualizerGlobals {
-    extern std::string selected;
-    extern std::vector<Network> networks;
-    extern std::mutex networks_mutex;
+    extern IpAddress selected;
 }
 
 #endif // GLOBALS_HPP
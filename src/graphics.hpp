@@ -2,12 +2,25 @@
 #define GRAPHICS_HPP
 
 #include "./utils.hpp"
+#include "./spatial.hpp"
+#include "./layout.hpp"
+#include "./cluster.hpp"
+#include "./layout_engine.hpp"
+#include "./diff.hpp"
+#include "./query.hpp"
+#include "./host_list.hpp"
+#include "./export.hpp"
+#include "./monitor.hpp"
+#include "./scan_session.hpp"
 #include "cairomm/fontface.h"
 #include <gtkmm.h>
 #include <sigc++/sigc++.h>
 #include <future>
 #include <sstream>
 #include <memory>
+#include <map>
+#include <set>
+#include <iomanip>
 
 #define M_PI 3.14159265358979323846
 
@@ -15,7 +28,9 @@
 LAYOUT
 FILE | SCAN OPTIONS     | GOBUTTON  | ENTER IP TEXT FIELD
 ------------------------------------------------------------
-LIST OF NETWORK TABS                | ATTRIBUTES
+FILTER BAR (port:22 os:~linux net:10.0.0.0/8 ...)
+------------------------------------------------------------
+NETWORK PICKER, HOST TABLE          | ATTRIBUTES
 ------------------------------------|
 DEVICE MAP                          |
 ------------------------------------------------------------
@@ -28,16 +43,45 @@ public:
         gesture_click = Gtk::GestureClick::create();
         add_controller(gesture_click);
         gesture_click->signal_pressed().connect(sigc::mem_fun(*this, &MapArea::on_click));
+
+        // pan with a middle/right drag, zoom around the pointer with the wheel
+        gesture_drag = Gtk::GestureDrag::create();
+        gesture_drag->set_button(0);
+        add_controller(gesture_drag);
+        gesture_drag->signal_drag_begin().connect([this](double, double) {
+            auto button = gesture_drag->get_current_button();
+            drag_active_ = (button == GDK_BUTTON_MIDDLE || button == GDK_BUTTON_SECONDARY);
+            drag_start_x_ = offset_x_;
+            drag_start_y_ = offset_y_;
+        });
+        gesture_drag->signal_drag_update().connect([this](double dx, double dy) {
+            if (!drag_active_) return;
+            offset_x_ = drag_start_x_ + dx;
+            offset_y_ = drag_start_y_ + dy;
+            scene_dirty_ = true;
+            queue_draw();
+        });
+
+        scroll_controller = Gtk::EventControllerScroll::create();
+        scroll_controller->set_flags(Gtk::EventControllerScroll::Flags::VERTICAL);
+        add_controller(scroll_controller);
+        scroll_controller->signal_scroll().connect(sigc::mem_fun(*this, &MapArea::on_scroll), false);
+
+        motion_controller = Gtk::EventControllerMotion::create();
+        add_controller(motion_controller);
+        motion_controller->signal_motion().connect(sigc::mem_fun(*this, &MapArea::on_motion));
+
+        // layouts run on a worker thread; frames are applied on the main loop
+        layout_dispatcher_.connect(sigc::mem_fun(*this, &MapArea::on_layout_frames));
+        layout_worker_.set_notify([this]() { layout_dispatcher_.emit(); });
+
+        // Positions are cached in normalized form; a resize only rescales them
         signal_resize().connect([this](int width, int height){
             for (auto& network : networks) {
-                auto& devices = network.devices;
-                for (auto& d : devices) {
-                    int num = devices.size();
-                    double angle = (&d - &devices[0]) * (2 * M_PI / num);
-                    d.x = width / 2.0 + (width / 3.0) * cos(angle);
-                    d.y = height / 2.0 + (height / 3.0) * sin(angle);
-                }
+                network.layout.scale(width, height);
+                network.cluster_layout.scale(width, height);
             }
+            rebuild_index();
             queue_draw();
         });
 
@@ -56,39 +100,109 @@ public:
     }
     
     void update_networks() {
-        std::lock_guard<std::mutex> lock(nmapVisualizerGlobals::networks_mutex);
+        trace::Scope scope("ui", "update_networks");
+        // Snapshot read: never blocks scan workers writing to the store
+        auto snapshot = nmapVisualizerGlobals::store.snapshot();
         networks.clear();
-        for (auto& net : nmapVisualizerGlobals::networks) {
-            Network newNet;
-            newNet.cidr = net.cidr;
-            newNet.center_x = get_width() / 2.0;
-            newNet.center_y = get_height() / 2.0;
-
-            for (auto& d : net.devices) {
-                newNet.devices.push_back(Device{
-                    d,
-                    0,
-                    0
-                });
-            }
-            
-            networks.push_back(newNet);
+        networks.reserve(snapshot->networks.size());
+        for (const auto& net : snapshot->networks) {
+            networks.emplace_back();
+            load_network(networks.back(), *net);
         }
-        for(auto& network : networks) {
-            auto& devices = network.devices;
-            for (auto& d : devices) {
-                int num = devices.size();
-                double angle = (&d - &devices[0]) * (2 * M_PI / num);
-                d.x = get_width() / 2.0 + (get_width() / 3.0) * cos(angle);
-                d.y = get_height() / 2.0 + (get_height() / 3.0) * sin(angle);
-            }
+        rebuild_index();
+        request_layout();
+        queue_draw();
+    }
+    
+    // Refresh a single network from the store and re-layout in the background
+    void update_network(const NetworkData& data) {
+        trace::Scope scope("ui", "update_network");
+        auto it = std::find_if(networks.begin(), networks.end(),
+            [&data](const Network& n) { return n.cidr == data.cidr; });
+        const bool added = it == networks.end();
+        if (added) {
+            networks.emplace_back();
+            it = networks.end() - 1;
         }
-        for (const auto& net : nmapVisualizerGlobals::networks) {
-            std::cout << "Network CIDR: " << net.cidr << ", Devices: " << net.devices.size() << std::endl;
-            for (const auto& d : net.devices) {
-                std::cout << " - Device IP: " << d.ipAddress << std::endl;
-            }
+        load_network(*it, data);
+        const auto n = static_cast<uint32_t>(it - networks.begin());
+        index_network(n);
+        // a new network changes the tiling of all of them
+        if (added) request_layout();
+        else request_layout(n);
+        queue_draw();
+    }
+
+    // Mark the hosts of one network that a rescan found new, gone or changed
+    void set_changes(const NetworkDiff& diff) {
+        ChangeMarks& marks = changes_[diff.cidr];
+        marks = ChangeMarks{};
+        for (const auto& host : diff.hosts) {
+            const auto& device = host.after ? host.after : host.before;
+            if (device->ipAddress.valid()) marks.by_ip[device->ipAddress] = host.kind;
+            else if (device->macAddress.valid()) marks.by_mac[device->macAddress] = host.kind;
         }
+        for (auto& network : networks) {
+            if (network.cidr == diff.cidr) apply_changes(network);
+        }
+        scene_dirty_ = true;
+        queue_draw();
+    }
+
+    void clear_changes() {
+        changes_.clear();
+        for (auto& network : networks) apply_changes(network);
+        scene_dirty_ = true;
+        queue_draw();
+    }
+
+    // Dim every host whose record is not in matches; nullptr shows all of them
+    void set_filter(std::shared_ptr<const HostSet> matches) {
+        if (!matches && !filter_) return;
+        filter_ = std::move(matches);
+        for (auto& network : networks) {
+            apply_filter(network);
+            dim_clusters(network);
+        }
+        scene_dirty_ = true;
+        queue_draw();
+    }
+
+    void set_layout_kind(LayoutKind kind) {
+        if (kind == layout_kind_) return;
+        layout_kind_ = kind;
+        request_layout();
+    }
+
+    // Regroup every network; the map switches to groups only when zoomed out
+    void set_cluster_mode(ClusterMode mode) {
+        if (mode == cluster_mode_) return;
+        cluster_mode_ = mode;
+        for (auto& network : networks) {
+            build_clusters(network);
+        }
+        hovered_cluster_ = ClusterRef{};
+        scene_dirty_ = true;
+        queue_draw();
+    }
+
+    // Frame timings plus the lines the app supplies, drawn in the top-left corner
+    void set_overlay(bool enabled) {
+        overlay_ = enabled;
+        queue_draw();
+    }
+
+    bool overlay() const { return overlay_; }
+
+    void set_overlay_lines(std::vector<std::string> lines) {
+        overlay_lines_ = std::move(lines);
+        if (overlay_) queue_draw();
+    }
+
+    void reset_view() {
+        zoom_ = 1.0;
+        offset_x_ = offset_y_ = 0.0;
+        scene_dirty_ = true;
         queue_draw();
     }
     
@@ -99,116 +213,644 @@ public:
     sigc::signal<void(void)>& signal_cleared() { return signal_cleared_; }
 
 private:
-    Glib::RefPtr<Gtk::GestureClick> gesture_click;
+    static constexpr double kNodeRadius = 20.0;
+    // node radius plus room for the label drawn below it
+    static constexpr double kCullMargin = 80.0;
+    // a network collapses into groups when its nodes get closer than this on screen
+    static constexpr double kMinNodeSpacing = 24.0;
+    // labels are skipped when the font would be smaller than this on screen
+    static constexpr double kMinLabelPixels = 6.0;
+    static constexpr double kFontSize = 10.0;
+    // opacity of nodes the filter bar excludes
+    static constexpr double kDimmedAlpha = 0.2;
 
-    struct Device {
-        DeviceInfo info;
-        double x, y;
-    };
+    Glib::RefPtr<Gtk::GestureClick> gesture_click;
+    Glib::RefPtr<Gtk::GestureDrag> gesture_drag;
+    Glib::RefPtr<Gtk::EventControllerScroll> scroll_controller;
+    Glib::RefPtr<Gtk::EventControllerMotion> motion_controller;
 
+    // Per-device data is kept as parallel arrays indexed like layout.x/y
     struct Network {
         std::string cidr;
-        std::vector<Device> devices;
-        double center_x, center_y;
+        std::vector<std::shared_ptr<const DeviceInfo>> devices;
+        std::vector<std::string> labels;  // formatted once, not per frame
+        std::vector<float> label_widths;  // measured on first draw, -1 until then
+        RingLayout layout;
+        SpatialGrid grid;  // device index by world position
+
+        Clustering subnets;  // /24 grouping fed to the layout engine
+        std::vector<HostChange> changes;  // diff highlight per device
+        std::vector<uint8_t> dimmed;      // 1 when the filter bar query excludes the device
+
+        // level of detail: groups on their own ring, used while clustered
+        Clustering clusters;
+        std::vector<std::string> cluster_labels;
+        RingLayout cluster_layout;
+        std::vector<uint8_t> cluster_dimmed;  // 1 when no member matches the filter
+        bool clustered = false;
+    };
+
+    struct ChangeMarks {
+        std::unordered_map<IpAddress, HostChange, IpAddressHash> by_ip;
+        std::unordered_map<MacAddress, HostChange, MacAddressHash> by_mac;
+    };
+
+    struct ClusterRef {
+        int64_t network = -1;
+        uint32_t cluster = 0;
+        bool valid() const { return network >= 0; }
+    };
+
+    struct ItemRef {
+        int64_t network = -1;
+        uint32_t device = 0;
+        bool valid() const { return network >= 0; }
+        bool operator==(const ItemRef& other) const { return network == other.network && device == other.device; }
+        bool operator!=(const ItemRef& other) const { return !(*this == other); }
     };
 
     std::vector<Network> networks;
+    std::vector<ItemRef> visible_;   // reused between scene renders
+    ItemRef hovered_;
+    ItemRef selected_;
+    ClusterRef hovered_cluster_;
+    ClusterMode cluster_mode_ = ClusterMode::Subnet;
+    bool draw_labels_ = true;
+
+    std::unordered_map<std::string, ChangeMarks> changes_;  // cidr -> last diff
+    std::shared_ptr<const HostSet> filter_;                 // hosts matching the filter bar, if any
+
+    bool overlay_ = false;
+    std::vector<std::string> overlay_lines_;
+    double frame_ms_ = 0.0;  // last draw_map, overlay excluded
+    double scene_ms_ = 0.0;  // last render_scene
+
+    LayoutKind layout_kind_ = LayoutKind::Ring;
+    Glib::Dispatcher layout_dispatcher_;
+    LayoutWorker layout_worker_;
+    std::set<uint32_t> layout_pending_;  // networks still waiting for a final layout frame
+
+    // retained scene: everything except the selection/hover overlay
+    Cairo::RefPtr<Cairo::ImageSurface> scene_;
+    int scene_width_ = 0, scene_height_ = 0, scene_scale_ = 0;
+    bool scene_dirty_ = true;
+
+    // view the scene was rendered with; while the wheel turns the cached
+    // scene is scaled instead, and rendered again once it stops
+    static constexpr unsigned kZoomSettleMs = 150;
+    double scene_zoom_ = 1.0, scene_offset_x_ = 0.0, scene_offset_y_ = 0.0;
+    sigc::connection zoom_settle_;
+
+    // view transform: screen = world * zoom_ + offset_
+    double zoom_ = 1.0;
+    double offset_x_ = 0.0, offset_y_ = 0.0;
+    double pointer_x_ = 0.0, pointer_y_ = 0.0;
+    double drag_start_x_ = 0.0, drag_start_y_ = 0.0;
+    bool drag_active_ = false;
+
+    double to_world_x(double sx) const { return (sx - offset_x_) / zoom_; }
+    double to_world_y(double sy) const { return (sy - offset_y_) / zoom_; }
+
+    // Copy one network from the store; real positions come from the layout worker
+    void load_network(Network& network, const NetworkData& data) {
+        network.cidr = data.cidr;
+        network.devices.assign(data.devices.begin(), data.devices.end());
+        network.labels.clear();
+        network.labels.reserve(data.devices.size());
+        for (const auto& d : data.devices) {
+            network.labels.push_back(d->ipAddress.to_string());
+        }
+        network.label_widths.assign(data.devices.size(), -1.0f);
+        network.subnets.build(network.devices, ClusterMode::Subnet);
+        apply_changes(network);
+        apply_filter(network);
+        // placeholder ring until the layout worker delivers real positions
+        if (network.layout.size() != network.devices.size()) {
+            network.layout.compute_ring(network.devices.size());
+        }
+        network.layout.scale(get_width(), get_height());
+        build_clusters(network);
+    }
 
-    void on_click(int, double x, double y) {
-        for (auto& net : networks) for (auto& d : net.devices) {
-            double dx = x - d.x, dy = y - d.y;
-            if (dx*dx + dy*dy <= 20*20) {
-                nmapVisualizerGlobals::selected = d.info.ipAddress;
-                signal_device_selected_.emit(d.info);
-                queue_draw();
-                return;
+    void apply_changes(Network& network) {
+        network.changes.assign(network.devices.size(), HostChange::None);
+        auto it = changes_.find(network.cidr);
+        if (it == changes_.end()) return;
+        const ChangeMarks& marks = it->second;
+        for (size_t i = 0; i < network.devices.size(); i++) {
+            const DeviceInfo& device = *network.devices[i];
+            if (device.ipAddress.valid()) {
+                auto found = marks.by_ip.find(device.ipAddress);
+                if (found != marks.by_ip.end()) network.changes[i] = found->second;
+            } else if (device.macAddress.valid()) {
+                auto found = marks.by_mac.find(device.macAddress);
+                if (found != marks.by_mac.end()) network.changes[i] = found->second;
+            }
+        }
+    }
+
+    void apply_filter(Network& network) {
+        network.dimmed.assign(network.devices.size(), 0);
+        if (!filter_) return;
+        for (size_t i = 0; i < network.devices.size(); i++) {
+            network.dimmed[i] = filter_->count(network.devices[i].get()) == 0;
+        }
+    }
+
+    void dim_clusters(Network& network) {
+        network.cluster_dimmed.assign(network.clusters.size(), filter_ ? 1 : 0);
+        if (!filter_) return;
+        for (size_t i = 0; i < network.dimmed.size(); i++) {
+            if (!network.dimmed[i]) network.cluster_dimmed[network.clusters.cluster_of[i]] = 0;
+        }
+    }
+
+    // Lay out every network again
+    void request_layout() {
+        layout_pending_.clear();
+        for (uint32_t n = 0; n < networks.size(); n++) layout_pending_.insert(n);
+        submit_layout();
+    }
+
+    // Lay out one network again; the others keep their positions
+    void request_layout(uint32_t n) {
+        layout_pending_.insert(n);
+        submit_layout();
+    }
+
+    // Hand the waiting networks to the layout worker. A request supersedes any
+    // running one, so networks it never delivered go along again
+    void submit_layout() {
+        // the force layout moves every network together
+        if (layout_kind_ == LayoutKind::ForceDirected) {
+            for (uint32_t n = 0; n < networks.size(); n++) layout_pending_.insert(n);
+        }
+        std::vector<uint32_t> index(layout_pending_.begin(), layout_pending_.end());
+        std::vector<LayoutNetwork> input(index.size());
+        for (size_t k = 0; k < index.size(); k++) {
+            const Network& network = networks[index[k]];
+            input[k].group_of = network.subnets.cluster_of;
+            input[k].group_count = static_cast<uint32_t>(network.subnets.size());
+            if (layout_kind_ == LayoutKind::ForceDirected) {
+                input[k].nx = network.layout.nx;
+                input[k].ny = network.layout.ny;
             }
         }
-        nmapVisualizerGlobals::selected.clear();
+        layout_worker_.submit(layout_kind_, std::move(input), std::move(index), networks.size());
+    }
+
+    void on_layout_frames() {
+        layout_worker_.drain_frames([this](LayoutFrame&& frame) {
+            if (frame.total != networks.size()) return;
+            for (size_t k = 0; k < frame.index.size(); k++) {
+                const uint32_t n = frame.index[k];
+                Network& network = networks[n];
+                RingLayout& result = frame.networks[k];
+                if (result.size() != network.devices.size()) continue;
+                network.layout.nx = std::move(result.nx);
+                network.layout.ny = std::move(result.ny);
+                network.layout.center_nx = result.center_nx;
+                network.layout.center_ny = result.center_ny;
+                network.layout.radius = result.radius;
+                network.layout.scale(get_width(), get_height());
+                place_clusters(network);
+                index_network(n);
+                if (frame.final) layout_pending_.erase(n);
+            }
+            queue_draw();
+        });
+    }
+
+    void build_clusters(Network& network) {
+        network.clusters.build(network.devices, cluster_mode_);
+        network.cluster_labels.clear();
+        network.cluster_labels.reserve(network.clusters.size());
+        for (size_t c = 0; c < network.clusters.size(); c++) {
+            network.cluster_labels.push_back(network.clusters.keys[c] + " (" + std::to_string(network.clusters.counts[c]) + ")");
+        }
+        dim_clusters(network);
+        place_clusters(network);
+    }
+
+    // Groups go on a ring around the network center, sized like the device layout
+    void place_clusters(Network& network) {
+        network.cluster_layout.center_nx = network.layout.center_nx;
+        network.cluster_layout.center_ny = network.layout.center_ny;
+        network.cluster_layout.radius = network.layout.radius;
+        network.cluster_layout.compute_ring(network.clusters.size());
+        network.cluster_layout.scale(get_width(), get_height());
+    }
+
+    // Approximate node spacing of a network in screen pixels at the current zoom
+    double ring_spacing(const Network& network) const {
+        const size_t count = network.devices.size();
+        if (count == 0) return 0.0;
+        const double radius = network.layout.radius * std::min(get_allocated_width(), get_allocated_height());
+        return zoom_ * 2 * M_PI * radius / count;
+    }
+
+    // Pick per network whether to draw devices or groups, and whether labels fit
+    void update_lod() {
+        draw_labels_ = zoom_ * kFontSize >= kMinLabelPixels;
+        for (auto& network : networks) {
+            const size_t count = network.devices.size();
+            network.clustered = network.clusters.size() < count && ring_spacing(network) < kMinNodeSpacing;
+        }
+        if (hovered_.valid() && networks[hovered_.network].clustered) hovered_ = ItemRef{};
+        if (hovered_cluster_.valid() && !networks[hovered_cluster_.network].clustered) hovered_cluster_ = ClusterRef{};
+    }
+
+    static double cluster_radius(uint32_t count) {
+        return std::min(kNodeRadius * 3, kNodeRadius * (1.0 + 0.25 * std::log2(static_cast<double>(count))));
+    }
+
+    // Device under a world point, ignoring networks that are drawn as groups
+    ItemRef hit_device(double wx, double wy) const {
+        ItemRef best;
+        double best_d2 = std::numeric_limits<double>::infinity();
+        for (size_t n = 0; n < networks.size(); n++) {
+            const Network& network = networks[n];
+            if (network.clustered) continue;
+            const int64_t hit = network.grid.nearest(wx, wy, kNodeRadius);
+            if (hit < 0) continue;
+            const double dx = network.layout.x[hit] - wx, dy = network.layout.y[hit] - wy;
+            if (dx * dx + dy * dy < best_d2) {
+                best_d2 = dx * dx + dy * dy;
+                best = ItemRef{static_cast<int64_t>(n), static_cast<uint32_t>(hit)};
+            }
+        }
+        return best;
+    }
+
+    ClusterRef hit_cluster(double wx, double wy) const {
+        for (size_t n = 0; n < networks.size(); n++) {
+            const Network& network = networks[n];
+            if (!network.clustered) continue;
+            for (uint32_t c = 0; c < network.clusters.size(); c++) {
+                const double dx = network.cluster_layout.x[c] - wx, dy = network.cluster_layout.y[c] - wy;
+                const double r = cluster_radius(network.clusters.counts[c]);
+                if (dx * dx + dy * dy <= r * r) return ClusterRef{static_cast<int64_t>(n), c};
+            }
+        }
+        return ClusterRef{};
+    }
+
+    // Zoom in far enough for a network to expand, centered on one of its groups
+    void expand_cluster(const ClusterRef& ref) {
+        const Network& network = networks[ref.network];
+        const double wx = network.cluster_layout.x[ref.cluster], wy = network.cluster_layout.y[ref.cluster];
+        const double needed = zoom_ * kMinNodeSpacing / std::max(ring_spacing(network), 1e-9);
+        zoom_ = std::clamp(needed * 1.05, zoom_, 20.0);
+        offset_x_ = get_width() / 2.0 - wx * zoom_;
+        offset_y_ = get_height() / 2.0 - wy * zoom_;
+        hovered_cluster_ = ClusterRef{};
+        scene_dirty_ = true;
+        queue_draw();
+    }
+
+    // Positions live in world space, so pan/zoom never invalidate the index.
+    // Each network has its own grid: a batch for one network re-indexes only it
+    void index_network(uint32_t n) {
+        Network& network = networks[n];
+        network.grid.clear(kNodeRadius * 4);
+        for (uint32_t i = 0; i < network.layout.size(); i++) {
+            network.grid.insert(i, network.layout.x[i], network.layout.y[i]);
+        }
+        network.grid.build();
+        if (hovered_.network == n) hovered_ = ItemRef{};
+        if (hovered_cluster_.network == n) hovered_cluster_ = ClusterRef{};
+
+        // device indices may have changed; find the selected device again
+        if (selected_.network == n) selected_ = ItemRef{};
+        if (!selected_.valid() && nmapVisualizerGlobals::selected.valid()) {
+            for (uint32_t i = 0; i < network.devices.size(); i++) {
+                if (network.devices[i]->ipAddress == nmapVisualizerGlobals::selected) {
+                    selected_ = ItemRef{n, i};
+                    break;
+                }
+            }
+        }
+        scene_dirty_ = true;
+    }
+
+    void rebuild_index() {
+        hovered_ = selected_ = ItemRef{};
+        hovered_cluster_ = ClusterRef{};
+        for (uint32_t n = 0; n < networks.size(); n++) index_network(n);
+        scene_dirty_ = true;
+    }
+
+    void on_click(int, double x, double y) {
+        ClusterRef cluster = hit_cluster(to_world_x(x), to_world_y(y));
+        if (cluster.valid()) {
+            expand_cluster(cluster);
+            return;
+        }
+        ItemRef hit = hit_device(to_world_x(x), to_world_y(y));
+        if (hit.valid()) {
+            const auto& info = networks[hit.network].devices[hit.device];
+            nmapVisualizerGlobals::selected = info->ipAddress;
+            selected_ = hit;
+            signal_device_selected_.emit(*info);
+            queue_draw();
+            return;
+        }
+        nmapVisualizerGlobals::selected = IpAddress();
+        selected_ = ItemRef{};
         signal_cleared_.emit();
         queue_draw();
     }
+
+    void on_motion(double x, double y) {
+        pointer_x_ = x;
+        pointer_y_ = y;
+        ItemRef hit = hit_device(to_world_x(x), to_world_y(y));
+        ClusterRef cluster = hit.valid() ? ClusterRef{} : hit_cluster(to_world_x(x), to_world_y(y));
+        if (hit != hovered_ || cluster.network != hovered_cluster_.network || cluster.cluster != hovered_cluster_.cluster) {
+            hovered_ = hit;
+            hovered_cluster_ = cluster;
+            queue_draw();
+        }
+    }
+
+    bool on_scroll(double /*dx*/, double dy) {
+        const double factor = dy < 0 ? 1.15 : 1.0 / 1.15;
+        const double new_zoom = std::clamp(zoom_ * factor, 0.05, 20.0);
+        // keep the world point under the pointer fixed
+        const double wx = to_world_x(pointer_x_), wy = to_world_y(pointer_y_);
+        zoom_ = new_zoom;
+        offset_x_ = pointer_x_ - wx * zoom_;
+        offset_y_ = pointer_y_ - wy * zoom_;
+        zoom_settle_.disconnect();
+        zoom_settle_ = Glib::signal_timeout().connect(sigc::mem_fun(*this, &MapArea::on_zoom_settled), kZoomSettleMs);
+        queue_draw();
+        return true;
+    }
+
+    bool on_zoom_settled() {
+        scene_dirty_ = true;
+        queue_draw();
+        return false;
+    }
     
     void draw_map(const Cairo::RefPtr<Cairo::Context>& cr, int /*width*/, int /*height*/) {
+        trace::Scope scope("render", "draw_map");
+        const auto frame_start = std::chrono::steady_clock::now();
         int width = get_width();
         int height = get_height();
+        int scale = get_scale_factor();
 
-        // Clear background
-        cr->set_source_rgb(0.1, 0.1, 0.1);
-        cr->rectangle(0, 0, width, height);
-        cr->fill();
+        if (scene_dirty_ || !scene_ || scene_width_ != width || scene_height_ != height || scene_scale_ != scale) {
+            render_scene(width, height, scale);
+            scene_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start).count();
+        }
 
-        for (MapArea::Network network : networks) {
-            std::vector<MapArea::Device> devices = network.devices;
-            for (MapArea::Device d : devices) {
-                int num = devices.size();
-                double angle = (&d - &devices[0]) * (2 * M_PI / num);
-                d.x = width / 2.0 + (width / 3.0) * cos(angle);
-                d.y = height / 2.0 + (height / 3.0) * sin(angle);
+        // Static layers are a single blit; only the overlay is drawn per frame.
+        // Mid-zoom the scene is stretched from the view it was rendered with
+        if (zoom_ == scene_zoom_ && offset_x_ == scene_offset_x_ && offset_y_ == scene_offset_y_) {
+            cr->set_source(scene_, 0, 0);
+            cr->paint();
+        } else {
+            const double ratio = zoom_ / scene_zoom_;
+            cr->save();
+            cr->set_source_rgb(0.1, 0.1, 0.1);
+            cr->paint();
+            cr->translate(offset_x_ - scene_offset_x_ * ratio, offset_y_ - scene_offset_y_ * ratio);
+            cr->scale(ratio, ratio);
+            cr->set_source(scene_, 0, 0);
+            cr->paint();
+            cr->restore();
+        }
 
+        cr->save();
+        cr->translate(offset_x_, offset_y_);
+        cr->scale(zoom_, zoom_);
+        cr->select_font_face("Sans", Cairo::ToyFontFace::Slant::NORMAL, Cairo::ToyFontFace::Weight::NORMAL);
+        cr->set_font_size(kFontSize);
+        if (hovered_cluster_.valid()) {
+            draw_cluster(cr, networks[hovered_cluster_.network], hovered_cluster_.cluster, 0.75, 0.9, 1.0);
+        }
+        if (hovered_.valid() && hovered_ != selected_) {
+            draw_device(cr, hovered_, 0.75, 0.9, 1.0);
+        }
+        if (selected_.valid()) {
+            // a selected device inside a collapsed network highlights its group
+            Network& network = networks[selected_.network];
+            if (network.clustered) {
+                draw_cluster(cr, network, network.clusters.cluster_of[selected_.device], 0.2, 0.8, 1.0);
+            } else {
+                draw_device(cr, selected_, 0.2, 0.8, 1.0);
             }
+        }
+        cr->restore();
 
-            // Draw connections
-            cr->set_line_width(2.0);
-            cr->set_source_rgb(0.7, 0.7, 0.7);
-            for (MapArea::Device d : devices) {
-                cr->move_to(d.x, d.y);
-                cr->line_to(width/2, height/2);
-                cr->stroke();
-            }
+        frame_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start).count();
+        if (overlay_) draw_overlay(cr);
+    }
 
-            // Draw devices
-            for (MapArea::Device d : devices) {
-                const bool is_selected = (nmapVisualizerGlobals::selected == d.info.ipAddress);
+    // Translucent panel of timing lines; drawn in screen space after the map
+    void draw_overlay(const Cairo::RefPtr<Cairo::Context>& cr) {
+        std::vector<std::string> lines;
+        std::ostringstream frame;
+        frame << std::fixed << std::setprecision(2) << "frame " << frame_ms_ << " ms, scene " << scene_ms_
+              << " ms, " << visible_.size() << " nodes drawn";
+        lines.push_back(frame.str());
+        lines.insert(lines.end(), overlay_lines_.begin(), overlay_lines_.end());
+
+        constexpr double kLineHeight = 15.0, kPadding = 8.0;
+        cr->save();
+        cr->select_font_face("Monospace", Cairo::ToyFontFace::Slant::NORMAL, Cairo::ToyFontFace::Weight::NORMAL);
+        cr->set_font_size(11.0);
+        double text_width = 0.0;
+        for (const auto& line : lines) {
+            Cairo::TextExtents extents;
+            cr->get_text_extents(line, extents);
+            text_width = std::max(text_width, extents.x_advance);
+        }
+        cr->set_source_rgba(0, 0, 0, 0.65);
+        cr->rectangle(kPadding, kPadding, text_width + 2 * kPadding, lines.size() * kLineHeight + kPadding);
+        cr->fill();
+        cr->set_source_rgb(0.6, 1.0, 0.6);
+        for (size_t i = 0; i < lines.size(); i++) {
+            cr->move_to(2 * kPadding, kPadding + (i + 1) * kLineHeight);
+            cr->show_text(lines[i]);
+        }
+        cr->restore();
+    }
 
-                // circle
-                if (is_selected) {
-                    cr->set_source_rgb(0.2, 0.8, 1.0);
-                } else {
-                    cr->set_source_rgb(1.0, 1.0, 1.0);
-                }
-                cr->arc(d.x, d.y, 20.0, 0, 2*M_PI);
-                cr->fill();
+    // Redraw background, spokes, nodes and labels into the offscreen scene.
+    // Runs only after data, size or view changes, never for selection/hover.
+    void render_scene(int width, int height, int scale) {
+        trace::Scope scope("render", "render_scene");
+        // pan/zoom reuse the surface; only a size or scale change reallocates
+        if (!scene_ || scene_width_ != width || scene_height_ != height || scene_scale_ != scale) {
+            scene_ = Cairo::ImageSurface::create(Cairo::Surface::Format::ARGB32,
+                                                 std::max(1, width * scale), std::max(1, height * scale));
+            scene_->set_device_scale(scale, scale);
+        }
+        scene_width_ = width;
+        scene_height_ = height;
+        scene_scale_ = scale;
+        scene_zoom_ = zoom_;
+        scene_offset_x_ = offset_x_;
+        scene_offset_y_ = offset_y_;
+        scene_dirty_ = false;
 
-                // font
-                cr->select_font_face("Sans", Cairo::ToyFontFace::Slant::NORMAL, Cairo::ToyFontFace::Weight::NORMAL);
-                cr->set_font_size(10.0);
+        auto cr = Cairo::Context::create(scene_);
 
-                // extents
-                Cairo::TextExtents extents;
-                cr->get_text_extents(d.info.ipAddress, extents);
+        // Clear background
+        cr->set_source_rgb(0.1, 0.1, 0.1);
+        cr->rectangle(0, 0, width, height);
+        cr->fill();
+
+        cr->translate(offset_x_, offset_y_);
+        cr->scale(zoom_, zoom_);
+
+        update_lod();
+
+        // Only devices inside the viewport (plus label margin) are drawn, and
+        // only for networks that are not collapsed into groups
+        const double x0 = to_world_x(0) - kCullMargin, y0 = to_world_y(0) - kCullMargin;
+        const double x1 = to_world_x(width) + kCullMargin, y1 = to_world_y(height) + kCullMargin;
+        visible_.clear();
+        for (size_t n = 0; n < networks.size(); n++) {
+            if (networks[n].clustered) continue;
+            networks[n].grid.query_rect(x0, y0, x1, y1, [this, n](uint32_t i, double, double) {
+                visible_.push_back(ItemRef{static_cast<int64_t>(n), i});
+            });
+        }
 
-                // label shadow
-                cr->set_source_rgba(0, 0, 0, 0.5);
-                cr->move_to(d.x - extents.width / 2 + 1, d.y + 31);
-                cr->show_text(d.info.ipAddress);
+        // Draw connections
+        cr->set_line_width(2.0);
+        cr->set_source_rgb(0.7, 0.7, 0.7);
+        for (const ItemRef& ref : visible_) {
+            const RingLayout& layout = networks[ref.network].layout;
+            cr->move_to(layout.x[ref.device], layout.y[ref.device]);
+            cr->line_to(layout.center_x, layout.center_y);
+        }
+        for (const Network& network : networks) {
+            if (!network.clustered) continue;
+            const RingLayout& layout = network.cluster_layout;
+            for (size_t c = 0; c < layout.size(); c++) {
+                cr->move_to(layout.x[c], layout.y[c]);
+                cr->line_to(layout.center_x, layout.center_y);
+            }
+        }
+        cr->stroke();
 
-                // text
-                cr->set_source_rgb(1.0, 1.0, 1.0);
-                cr->move_to(d.x - extents.width / 2, d.y + 30);
-                cr->show_text(d.info.ipAddress);
+        // Draw devices and groups
+        cr->select_font_face("Sans", Cairo::ToyFontFace::Slant::NORMAL, Cairo::ToyFontFace::Weight::NORMAL);
+        cr->set_font_size(kFontSize);
+        for (const ItemRef& ref : visible_) {
+            draw_device(cr, ref, 1.0, 1.0, 1.0);
+        }
+        for (Network& network : networks) {
+            if (!network.clustered) continue;
+            const RingLayout& layout = network.cluster_layout;
+            for (uint32_t c = 0; c < layout.size(); c++) {
+                if (layout.x[c] < x0 || layout.x[c] > x1 || layout.y[c] < y0 || layout.y[c] > y1) continue;
+                draw_cluster(cr, network, c, 0.95, 0.75, 0.35);
             }
+        }
 
+        cr->select_font_face("Sans", Cairo::ToyFontFace::Slant::NORMAL, Cairo::ToyFontFace::Weight::BOLD);
+        for (const Network& network : networks) {
             // Draw network center
+            const double cx = network.layout.center_x, cy = network.layout.center_y;
             cr->set_source_rgb(1.0, 1.0, 1.0);
-            cr->arc(width/2, height/2, 20.0, 0, 2*M_PI);
+            cr->arc(cx, cy, kNodeRadius, 0, 2*M_PI);
             cr->fill();
 
             // Draw network label
-            cr->select_font_face("Sans", Cairo::ToyFontFace::Slant::NORMAL, Cairo::ToyFontFace::Weight::BOLD);
-            cr->set_font_size(10.0);
             Cairo::TextExtents extents;
             cr->get_text_extents(network.cidr, extents);
 
             cr->set_source_rgba(0, 0, 0, 0.5);
-            cr->move_to(width/2 - extents.width / 2 + 1, height/2 + 31);
+            cr->move_to(cx - extents.width / 2 + 1, cy + 31);
             cr->show_text(network.cidr);
 
             cr->set_source_rgb(1.0, 1.0, 1.0);
-            cr->move_to(width/2 - extents.width / 2, height/2 + 30);
+            cr->move_to(cx - extents.width / 2, cy + 30);
             cr->show_text(network.cidr);
         }
     }
+
+    // One node with its label; the caller sets font face and size
+    void draw_device(const Cairo::RefPtr<Cairo::Context>& cr, const ItemRef& ref, double r, double g, double b) {
+        Network& network = networks[ref.network];
+        const double x = network.layout.x[ref.device];
+        const double y = network.layout.y[ref.device];
+
+        // hosts filtered out stay in place but fade, without a label
+        const bool dimmed = network.dimmed[ref.device];
+        const double alpha = dimmed ? kDimmedAlpha : 1.0;
+
+        // circle
+        cr->set_source_rgba(r, g, b, alpha);
+        cr->arc(x, y, kNodeRadius, 0, 2*M_PI);
+        cr->fill();
+
+        // diff ring: green new, red gone, orange changed
+        switch (network.changes[ref.device]) {
+            case HostChange::Added:   cr->set_source_rgba(0.3, 0.85, 0.3, alpha); break;
+            case HostChange::Removed: cr->set_source_rgba(0.9, 0.25, 0.25, alpha); break;
+            case HostChange::Changed: cr->set_source_rgba(1.0, 0.6, 0.1, alpha); break;
+            default: break;
+        }
+        if (network.changes[ref.device] != HostChange::None) {
+            cr->set_line_width(4.0);
+            cr->arc(x, y, kNodeRadius + 4, 0, 2*M_PI);
+            cr->stroke();
+        }
+
+        if (!draw_labels_ || dimmed) return;
+
+        // extents are measured once per label and reused
+        const std::string& label = network.labels[ref.device];
+        float& label_width = network.label_widths[ref.device];
+        if (label_width < 0) {
+            Cairo::TextExtents extents;
+            cr->get_text_extents(label, extents);
+            label_width = static_cast<float>(extents.width);
+        }
+
+        // label shadow
+        cr->set_source_rgba(0, 0, 0, 0.5);
+        cr->move_to(x - label_width / 2 + 1, y + 31);
+        cr->show_text(label);
+
+        // text
+        cr->set_source_rgb(1.0, 1.0, 1.0);
+        cr->move_to(x - label_width / 2, y + 30);
+        cr->show_text(label);
+    }
+
+    // One group node sized by member count, labelled "key (count)"
+    void draw_cluster(const Cairo::RefPtr<Cairo::Context>& cr, const Network& network, uint32_t c,
+                      double r, double g, double b) {
+        const double x = network.cluster_layout.x[c];
+        const double y = network.cluster_layout.y[c];
+        const double radius = cluster_radius(network.clusters.counts[c]);
+        const bool dimmed = network.cluster_dimmed[c];
+
+        cr->set_source_rgba(r, g, b, dimmed ? kDimmedAlpha : 1.0);
+        cr->arc(x, y, radius, 0, 2*M_PI);
+        cr->fill();
+
+        if (!draw_labels_ || dimmed) return;
+
+        const std::string& label = network.cluster_labels[c];
+        Cairo::TextExtents extents;
+        cr->get_text_extents(label, extents);
+
+        cr->set_source_rgba(0, 0, 0, 0.5);
+        cr->move_to(x - extents.width / 2 + 1, y + radius + 11);
+        cr->show_text(label);
+
+        cr->set_source_rgb(1.0, 1.0, 1.0);
+        cr->move_to(x - extents.width / 2, y + radius + 10);
+        cr->show_text(label);
+    }
 };
 
 class MainWindow : public Gtk::Window {
@@ -222,12 +864,18 @@ class MainWindow : public Gtk::Window {
             auto fileMenu = Gio::Menu::create();
             auto scanOptions = Gtk::make_managed<Gtk::MenuButton>();
             auto scanOptionsMenu = Gio::Menu::create();
+            auto view = Gtk::make_managed<Gtk::MenuButton>();
+            auto viewMenu = Gio::Menu::create();
             auto go_button = Gtk::make_managed<Gtk::Button>("Scan");
             ip_entry_ = Gtk::make_managed<Gtk::Entry>();
+            filter_entry_ = Gtk::make_managed<Gtk::SearchEntry>();
 
             // create main layout
             auto main_paned = Gtk::make_managed<Gtk::Paned>(Gtk::Orientation::HORIZONTAL);
             map_area_ = Gtk::make_managed<MapArea>();
+            auto map_paned = Gtk::make_managed<Gtk::Paned>(Gtk::Orientation::VERTICAL);
+            host_list_ = Gtk::make_managed<HostListPanel>();
+            ports_view_ = Gtk::make_managed<TableView<Port>>(host_list_detail::port_columns());
             // create boxes
             auto top_hbox = Gtk::make_managed<Gtk::Box>(Gtk::Orientation::HORIZONTAL, 10); 
             auto top_hbox_left = Gtk::make_managed<Gtk::Box>(Gtk::Orientation::HORIZONTAL, 5);
@@ -255,9 +903,12 @@ class MainWindow : public Gtk::Window {
             add_row("MAC", mac_label_, 1);
             add_row("Vendor", vendor_label_, 2);
             add_row("OS", os_label_, 3);
-            add_row("Ports", ports_label_, 4);
 
             attrs_box->append(*attrs_grid);
+            auto ports_title = Gtk::make_managed<Gtk::Label>("Ports");
+            ports_title->set_xalign(0);
+            attrs_box->append(*ports_title);
+            attrs_box->append(*ports_view_);
             show_empty_attrs();
 
             // Add status label
@@ -275,6 +926,13 @@ class MainWindow : public Gtk::Window {
             file->set_label("File");
 
             fileMenu->append("Say Hello", "app.hello");
+            fileMenu->append("Import XML...", "app.import_xml");
+            fileMenu->append("Export...", "app.export");
+            fileMenu->append("Reload Database", "app.db_reload");
+            fileMenu->append("Compact Database", "app.db_compact");
+            fileMenu->append("Clear Database", "app.db_clear");
+            fileMenu->append("Trace: Start Recording", "app.trace_start");
+            fileMenu->append("Trace: Stop and Save...", "app.trace_save");
             fileMenu->append("Quit", "app.quit");
 
             file->set_menu_model(fileMenu);
@@ -282,11 +940,51 @@ class MainWindow : public Gtk::Window {
             // initialize scan options menu
             scanOptions->set_label("Scan Options");
 
-            scanOptionsMenu->append("Say Hello", "app.hello");
-            scanOptionsMenu->append("Quit", "app.quit");
+            scanOptionsMenu->append("Cancel Scans", "app.cancel_scans");
+            scanOptionsMenu->append("Profile: Quick", "app.profile::quick");
+            scanOptionsMenu->append("Profile: Default", "app.profile::default");
+            scanOptionsMenu->append("Profile: Service Detection", "app.profile::services");
+            scanOptionsMenu->append("Profile: Thorough", "app.profile::thorough");
+            scanOptionsMenu->append("Timing: T3 Normal", "app.timing::normal");
+            scanOptionsMenu->append("Timing: T4 Aggressive", "app.timing::aggressive");
+            scanOptionsMenu->append("Timing: T5 Insane", "app.timing::insane");
+            scanOptionsMenu->append("Ports: Top 100", "app.ports::top100");
+            scanOptionsMenu->append("Ports: Top 1000", "app.ports::default");
+            scanOptionsMenu->append("Ports: All", "app.ports::all");
+            scanOptionsMenu->append("Version Detection (-sV)", "app.toggle_version_detection");
+            scanOptionsMenu->append("OS Detection (-O)", "app.toggle_os_detection");
+            scanOptionsMenu->append("Min Rate: Off", "app.min_rate::off");
+            scanOptionsMenu->append("Min Rate: 1000 pps", "app.min_rate::1000");
+            scanOptionsMenu->append("Scans: Full", "app.scan_mode::full");
+            scanOptionsMenu->append("Scans: Incremental", "app.scan_mode::incremental");
+            scanOptionsMenu->append("Rescan TTL: 1 Hour", "app.rescan_ttl::hour");
+            scanOptionsMenu->append("Rescan TTL: 1 Day", "app.rescan_ttl::day");
+            scanOptionsMenu->append("Rescan TTL: 1 Week", "app.rescan_ttl::week");
+            scanOptionsMenu->append("Monitor: Start on Targets", "app.monitor_start");
+            scanOptionsMenu->append("Monitor: Stop", "app.monitor_stop");
+            scanOptionsMenu->append("Monitor: Every 5 Minutes", "app.monitor_interval_5m");
+            scanOptionsMenu->append("Monitor: Every 15 Minutes", "app.monitor_interval_15m");
+            scanOptionsMenu->append("Monitor: Every Hour", "app.monitor_interval_1h");
+            scanOptionsMenu->append("Monitor: History...", "app.monitor_history");
 
             scanOptions->set_menu_model(scanOptionsMenu);
 
+            // initialize view menu
+            view->set_label("View");
+
+            viewMenu->append("Group by Subnet", "app.cluster_subnet");
+            viewMenu->append("Group by Vendor", "app.cluster_vendor");
+            viewMenu->append("Group by Service", "app.cluster_service");
+            viewMenu->append("Reset View", "app.reset_view");
+            viewMenu->append("Clear Changes", "app.clear_changes");
+            viewMenu->append("Toggle Performance Overlay", "app.toggle_overlay");
+            viewMenu->append("Layout: Ring", "app.layout_ring");
+            viewMenu->append("Layout: Radial by Subnet", "app.layout_radial");
+            viewMenu->append("Layout: Hierarchical", "app.layout_hierarchical");
+            viewMenu->append("Layout: Force-Directed", "app.layout_force");
+
+            view->set_menu_model(viewMenu);
+
             // initialize go button
             go_button->set_tooltip_text("Start nmap scan");
             
@@ -303,21 +1001,32 @@ class MainWindow : public Gtk::Window {
             // set up top_hbox
             top_hbox_left->append(*file);
             top_hbox_left->append(*scanOptions);
+            top_hbox_left->append(*view);
             top_hbox_right->set_halign(Gtk::Align::END);
             top_hbox_right->append(*go_button);
             top_hbox_right->append(*ip_entry_);
             top_hbox->append(*top_hbox_left);
             top_hbox->append(*top_hbox_right);
 
+            // filter bar: re-run once typing pauses (SearchEntry debounces)
+            filter_entry_->set_placeholder_text("Filter hosts: port:22 state:open os:~linux vendor:cisco net:10.0.0.0/8");
+            filter_entry_->set_hexpand(true);
+            filter_entry_->signal_search_changed().connect([this]() {
+                if (auto app = get_application()) {
+                    app->activate_action("apply_filter");
+                }
+            });
+
             /*
             ###########################
             ##       MAIN AREA       ##
             ###########################
             */
 
-            // devices
-            // device_map_box->append(*map_area);
-            main_paned->set_start_child(*map_area_);
+            // devices: map above, network picker and host table below
+            map_paned->set_start_child(*map_area_);
+            map_paned->set_end_child(*host_list_);
+            main_paned->set_start_child(*map_paned);
 
             // attributes
             attrs_frame->set_child(*attrs_box);
@@ -337,6 +1046,9 @@ class MainWindow : public Gtk::Window {
 
             map_area_->set_hexpand(true);
             map_area_->set_vexpand(true);
+            map_area_->set_size_request(-1, 300);
+            host_list_->set_size_request(-1, 200);
+            ports_view_->set_size_request(280, 160);
 
             ip_entry_->set_halign(Gtk::Align::FILL);
             ip_entry_->set_hexpand(true);
@@ -356,10 +1068,12 @@ class MainWindow : public Gtk::Window {
             */
             set_child(*vbox);
             vbox->append(*top_hbox);
+            vbox->append(*filter_entry_);
             vbox->append(*main_paned);
 
             map_area_->signal_device_selected().connect(sigc::mem_fun(*this, &MainWindow::update_attrs));
             map_area_->signal_cleared().connect([this]{ show_empty_attrs(); });
+            host_list_->signal_device_selected().connect(sigc::mem_fun(*this, &MainWindow::update_attrs));
                     
             show();
         }
@@ -369,21 +1083,20 @@ class MainWindow : public Gtk::Window {
             return ip_entry_ ? ip_entry_->get_text() : "";
         }
 
+        std::string get_filter_text() const {
+            return filter_entry_ ? filter_entry_->get_text() : "";
+        }
+
         MapArea* get_map_area() const { return map_area_; }
 
+        HostListPanel* get_host_list() const { return host_list_; }
+
         void update_attrs(const DeviceInfo& d) {
-            ip_label_->set_text(d.ipAddress);
-            mac_label_->set_text(d.macAddress);
-            vendor_label_->set_text(d.vendor);
-            os_label_->set_text(d.operatingSystem);
-            std::string ports;
-            for (const auto& p : d.ports) {
-                ports += std::to_string(p.portNumber) + "/" + p.protocol + " " + p.state;
-                if (!p.service.empty()) ports += " (" + p.service + ")";
-                ports += "\n";
-            }
-            if (ports.empty()) ports = "-";
-            ports_label_->set_text(ports);
+            ip_label_->set_text(d.ipAddress.to_string());
+            mac_label_->set_text(d.macAddress.to_string());
+            vendor_label_->set_text(d.vendor.str());
+            os_label_->set_text(d.operatingSystem.str());
+            ports_view_->set_rows(d.ports);
         }
 
         void show_empty_attrs() {
@@ -391,7 +1104,7 @@ class MainWindow : public Gtk::Window {
             if (mac_label_) mac_label_->set_text("-");
             if (vendor_label_) vendor_label_->set_text("-");
             if (os_label_) os_label_->set_text("-");
-            if (ports_label_) ports_label_->set_text("-");
+            if (ports_view_) ports_view_->set_rows({});
         }
 
         void set_status(const std::string& status) {
@@ -402,12 +1115,14 @@ class MainWindow : public Gtk::Window {
 
     private:
         Gtk::Entry* ip_entry_ = nullptr;
+        Gtk::SearchEntry* filter_entry_ = nullptr;
         MapArea* map_area_ = nullptr;
+        HostListPanel* host_list_ = nullptr;
+        TableView<Port>* ports_view_ = nullptr;
         Gtk::Label* ip_label_ = nullptr;
         Gtk::Label* mac_label_ = nullptr;
         Gtk::Label* vendor_label_ = nullptr;
         Gtk::Label* os_label_ = nullptr;
-        Gtk::Label* ports_label_ = nullptr;
         Gtk::Label* status_label_ = nullptr;
 };
 
@@ -415,6 +1130,7 @@ class nmapVisualizer : public Gtk::Application {
     protected:
         nmapVisualizer() : Gtk::Application("org.kaska.nmapVisualizer") {
             scanner_ = std::make_unique<ParallelScanner>();
+            session_ = std::make_unique<ScanSession>(*scanner_);
         }
 
         void on_startup() override {
@@ -424,18 +1140,97 @@ class nmapVisualizer : public Gtk::Application {
             add_action("hello", sigc::mem_fun(*this, &nmapVisualizer::on_hello));
             add_action("quit", sigc::mem_fun(*this, &nmapVisualizer::on_quit));
             add_action("go_button", sigc::mem_fun(*this, &nmapVisualizer::on_go_button_clicked));
+            add_action("cancel_scans", sigc::mem_fun(*this, &nmapVisualizer::on_cancel_scans));
+            add_action("import_xml", sigc::mem_fun(*this, &nmapVisualizer::on_import_xml));
+            add_action("export", sigc::mem_fun(*this, &nmapVisualizer::on_export));
+            add_action("db_reload", sigc::mem_fun(*this, &nmapVisualizer::on_db_reload));
+            add_action("db_compact", sigc::mem_fun(*this, &nmapVisualizer::on_db_compact));
+            add_action("db_clear", sigc::mem_fun(*this, &nmapVisualizer::on_db_clear));
+            add_action("trace_start", sigc::mem_fun(*this, &nmapVisualizer::on_trace_start));
+            add_action("trace_save", sigc::mem_fun(*this, &nmapVisualizer::on_trace_save));
+            add_action("toggle_overlay", sigc::mem_fun(*this, &nmapVisualizer::on_toggle_overlay));
+            trace::recorder().set_thread_name("ui");
+            // Radio and check actions, so the menu shows the options in use;
+            // update_profile keeps their states in step with the scanner's profile
+            const auto& profiles = scan_profiles();
+            profile_action_ = add_action_radio_string("profile", [this, &profiles](const Glib::ustring &id) {
+                for (size_t i = 0; i < profiles.size() && i < std::size(kProfileIds); i++) {
+                    if (id == kProfileIds[i]) update_profile([&](ScanProfile &p) { p = profiles[i]; });
+                }
+            }, "");
+            timing_action_ = add_action_radio_string("timing", [this](const Glib::ustring &id) {
+                update_profile([&](ScanProfile &p) { p.timing = id == "normal" ? 3 : id == "aggressive" ? 4 : 5; });
+            }, "");
+            ports_action_ = add_action_radio_string("ports", [this](const Glib::ustring &id) {
+                update_profile([&](ScanProfile &p) {
+                    p.ports = id == "all" ? "1-65535" : "";
+                    p.fast = id == "top100";
+                });
+            }, "");
+            version_detection_action_ = add_action_bool("toggle_version_detection", [this]() {
+                update_profile([](ScanProfile &p) { p.service_detection = !p.service_detection; });
+            }, false);
+            os_detection_action_ = add_action_bool("toggle_os_detection", [this]() {
+                update_profile([](ScanProfile &p) { p.os_detection = !p.os_detection; });
+            }, false);
+            min_rate_action_ = add_action_radio_string("min_rate", [this](const Glib::ustring &id) {
+                update_profile([&](ScanProfile &p) { p.min_rate = id == "1000" ? 1000 : 0; });
+            }, "");
+            sync_profile_actions(scanner_->profile());
+            // Radio action, so the menu shows which mode is active
+            scan_mode_action_ = add_action_radio_string("scan_mode", [this](const Glib::ustring &mode) {
+                incremental_ = mode == "incremental";
+                scan_mode_action_->change_state(mode);
+            }, incremental_ ? "incremental" : "full");
+            rescan_ttl_action_ = add_action_radio_string("rescan_ttl", [this](const Glib::ustring &ttl) {
+                rescan_ttl_ = ttl == "hour" ? 3600 : ttl == "week" ? 7 * 86400 : 86400;
+                rescan_ttl_action_->change_state(ttl);
+            }, rescan_ttl_ == 3600 ? "hour" : rescan_ttl_ == 7 * 86400 ? "week" : "day");
+            add_action("monitor_start", sigc::mem_fun(*this, &nmapVisualizer::on_monitor_start));
+            add_action("monitor_stop", sigc::mem_fun(*this, &nmapVisualizer::on_monitor_stop));
+            add_action("monitor_interval_5m", [this]() { set_monitor_interval(5 * 60); });
+            add_action("monitor_interval_15m", [this]() { set_monitor_interval(15 * 60); });
+            add_action("monitor_interval_1h", [this]() { set_monitor_interval(3600); });
+            add_action("monitor_history", sigc::mem_fun(*this, &nmapVisualizer::on_monitor_history));
+            add_action("cluster_subnet", [this]() { set_cluster_mode(ClusterMode::Subnet); });
+            add_action("cluster_vendor", [this]() { set_cluster_mode(ClusterMode::Vendor); });
+            add_action("cluster_service", [this]() { set_cluster_mode(ClusterMode::Service); });
+            add_action("layout_ring", [this]() { set_layout_kind(LayoutKind::Ring); });
+            add_action("layout_radial", [this]() { set_layout_kind(LayoutKind::RadialSubnet); });
+            add_action("layout_hierarchical", [this]() { set_layout_kind(LayoutKind::Hierarchical); });
+            add_action("layout_force", [this]() { set_layout_kind(LayoutKind::ForceDirected); });
+            add_action("clear_changes", [this]() {
+                auto win = dynamic_cast<MainWindow*>(get_active_window());
+                if (win && win->get_map_area()) win->get_map_area()->clear_changes();
+            });
+            add_action("apply_filter", [this]() { refresh_views(true); });
+            add_action("reset_view", [this]() {
+                auto win = dynamic_cast<MainWindow*>(get_active_window());
+                if (win && win->get_map_area()) win->get_map_area()->reset_view();
+            });
             
-            // Start periodic timer to check for scan completion
-            Glib::signal_timeout().connect(
-                sigc::mem_fun(*this, &nmapVisualizer::on_timer_check_scans),
-                500  // Check every 500ms
-            );
+            // Scan workers push hosts into the scanner queue; drain it on the main loop
+            scan_dispatcher_.connect(sigc::mem_fun(*this, &nmapVisualizer::on_scan_events));
+            scanner_->set_notify([this]() { scan_dispatcher_.emit(); });
+            import_dispatcher_.connect(sigc::mem_fun(*this, &nmapVisualizer::on_import_finished));
+            export_dispatcher_.connect(sigc::mem_fun(*this, &nmapVisualizer::on_export_finished));
+            monitor_dispatcher_.connect(sigc::mem_fun(*this, &nmapVisualizer::poll_monitor));
+            database_dispatcher_.connect(sigc::mem_fun(*this, &nmapVisualizer::on_database_loaded));
+
+            // Previous results come back from the on-disk database, off the main loop
+            db_status_ = "Loading " + ScanDatabase::default_path() + "...";
+            start_database_load(true);
         }
 
         void on_activate() override {
             // create_window now returns a raw pointer and the app owns the window
             MainWindow* win = create_window();
-            if (win) win->present();
+            if (win) {
+                win->get_map_area()->update_networks();
+                refresh_views(false);
+                win->set_status(db_status_);
+                win->present();
+            }
         }
 
         // return raw pointer; application keeps ownership via add_window()
@@ -459,6 +1254,7 @@ class nmapVisualizer : public Gtk::Application {
         void on_go_button_clicked() {
             std::string target;
             if (auto win = dynamic_cast<MainWindow*>(get_active_window())) {
+                if (database_loading(win)) return;
                 target = win->get_ip_entry_text();
                 
                 if (target.empty()) {
@@ -468,76 +1264,669 @@ class nmapVisualizer : public Gtk::Application {
                 
                 std::cout << "Starting parallel nmap scan on target: " << target << std::endl;
                 win->set_status("Scanning " + target + "...");
+                const std::vector<std::string> targets = split_targets(target);
+
+                // Launch parallel scans; the session remembers what each network
+                // looked like before so the finished run can be diffed against it.
+                // In incremental mode known networks only get their changed or
+                // stale hosts re-probed
+                for (const auto& t : targets) session_->start(t, incremental_, rescan_ttl_);
                 
-                // Parse multiple targets (comma or space separated)
-                std::vector<std::string> targets;
-                std::stringstream ss(target);
-                std::string item;
-                
-                // Try comma first
-                while (std::getline(ss, item, ',')) {
-                    // Trim whitespace
-                    item.erase(0, item.find_first_not_of(" \t\n\r\f\v"));
-                    item.erase(item.find_last_not_of(" \t\n\r\f\v") + 1);
-                    if (!item.empty()) {
-                        targets.push_back(item);
+                update_scan_status();
+            }
+        }
+        
+        // Targets in the entry, comma or space separated
+        static std::vector<std::string> split_targets(const std::string &text) {
+            std::vector<std::string> targets;
+            std::stringstream ss(text);
+            std::string item;
+
+            // Try comma first
+            while (std::getline(ss, item, ',')) {
+                // Trim whitespace
+                item.erase(0, item.find_first_not_of(" \t\n\r\f\v"));
+                item.erase(item.find_last_not_of(" \t\n\r\f\v") + 1);
+                if (!item.empty()) {
+                    targets.push_back(item);
+                }
+            }
+
+            // If no comma found, try space
+            if (targets.size() <= 1) {
+                targets.clear();
+                ss.clear();
+                ss.str(text);
+                while (ss >> item) {
+                    targets.push_back(item);
+                }
+            }
+            return targets;
+        }
+
+        // Dispatcher callback: apply queued host deltas without rebuilding the whole map
+        void on_scan_events() {
+            auto win = dynamic_cast<MainWindow*>(get_active_window());
+            bool saved = false;
+            auto finished = session_->poll(
+                [&](const NetworkData &network) {
+                    if (win && win->get_map_area()) win->get_map_area()->update_network(network);
+                    saved = true;
+                },
+                [this](const ScanEvent &event) {
+                    if (event.kind == ScanEvent::Kind::Progress) progress_[event.task_id] = TaskProgress{event.target, event.progress};
+                    else progress_.erase(event.task_id);
+                });
+            if (saved) refresh_views(false);
+
+            std::string changes;
+            for (const auto& run : finished) {
+                if (!run.baseline || run.cancelled) continue;
+                if (win && win->get_map_area()) win->get_map_area()->set_changes(run.diff);
+                changes += (changes.empty() ? "" : "; ") + run.diff.summary();
+            }
+
+            update_scan_status();
+            if (win && !changes.empty()) win->set_status("Changes in " + changes);
+        }
+
+        void update_scan_status() {
+            auto win = dynamic_cast<MainWindow*>(get_active_window());
+            if (!win) return;
+
+            ScannerStats stats = scanner_->stats();
+            std::ostringstream status;
+            if (stats.queued + stats.running > 0) {
+                status << "Scanning... (" << stats.running << " running, " << stats.queued << " queued, "
+                       << stats.completed << " done, " << stats.hosts << " hosts, "
+                       << std::fixed << std::setprecision(1) << stats.hosts_per_second << " hosts/s)";
+
+                // Least advanced scans first: they decide when everything is done
+                std::vector<const TaskProgress*> tasks;
+                for (const auto& [id, task] : progress_) tasks.push_back(&task);
+                std::sort(tasks.begin(), tasks.end(), [](const TaskProgress* a, const TaskProgress* b) {
+                    return a->progress.percent < b->progress.percent;
+                });
+                constexpr size_t kShown = 3;
+                for (size_t i = 0; i < std::min(tasks.size(), kShown); i++) {
+                    const ScanProgress& p = tasks[i]->progress;
+                    status << (i == 0 ? " | " : "; ") << tasks[i]->target << ": " << p.task << " "
+                           << std::setprecision(0) << p.percent << "%";
+                    if (p.remaining > 0) status << ", ETA " << format_duration(p.remaining);
+                    status << ", " << p.hosts_up << " up";
+                }
+                if (tasks.size() > kShown) status << "; +" << tasks.size() - kShown << " more";
+            } else {
+                status << "Scan completed. Ready. (" << stats.completed << " done, " << stats.cancelled
+                       << " cancelled, " << stats.hosts << " hosts)";
+            }
+            win->set_status(status.str());
+        }
+
+        // Change the options used for scans started from now on
+        void update_profile(const std::function<void(ScanProfile&)> &change) {
+            ScanProfile profile = scanner_->profile();
+            change(profile);
+            scanner_->set_profile(profile);
+            sync_profile_actions(profile);
+            std::cout << "Scan profile: " << profile.describe() << std::endl;
+            if (auto win = dynamic_cast<MainWindow*>(get_active_window())) {
+                win->set_status("Scan profile: " + profile.describe());
+            }
+        }
+
+        // Check the menu entries matching the profile; a radio group whose
+        // entries all differ from it (e.g. a hand-tuned profile) shows none
+        void sync_profile_actions(const ScanProfile &profile) {
+            const auto& profiles = scan_profiles();
+            Glib::ustring id = "custom";
+            for (size_t i = 0; i < profiles.size() && i < std::size(kProfileIds); i++) {
+                if (profile.name == profiles[i].name && profile.arguments() == profiles[i].arguments()) id = kProfileIds[i];
+            }
+            profile_action_->change_state(id);
+
+            id = profile.timing == 3 ? "normal" : profile.timing == 4 ? "aggressive" : profile.timing == 5 ? "insane" : "custom";
+            timing_action_->change_state(id);
+
+            if (profile.ports == "1-65535") {
+                id = "all";
+            } else if (valid_port_spec(profile.ports)) {
+                id = "custom";
+            } else {
+                id = profile.fast ? "top100" : "default";
+            }
+            ports_action_->change_state(id);
+
+            version_detection_action_->change_state(profile.service_detection);
+            os_detection_action_->change_state(profile.os_detection);
+            min_rate_action_->change_state(Glib::ustring(profile.min_rate == 0 ? "off" : profile.min_rate == 1000 ? "1000" : "custom"));
+        }
+
+        void on_cancel_scans() {
+            scanner_->cancel_all();
+            progress_.clear();
+            update_scan_status();
+        }
+
+        // Rescan the targets in the entry on the monitor interval, beside interactive scans
+        void on_monitor_start() {
+            auto win = dynamic_cast<MainWindow*>(get_active_window());
+            if (!win || database_loading(win)) return;
+            const std::vector<std::string> targets = split_targets(win->get_ip_entry_text());
+            if (targets.empty()) {
+                win->set_status("Error: Please enter the targets to monitor");
+                return;
+            }
+
+            if (!monitor_) {
+                MonitorSettings settings;
+                settings.ttl_seconds = rescan_ttl_;
+                monitor_ = std::make_unique<Monitor>(settings);
+                monitor_->set_notify([this]() { monitor_dispatcher_.emit(); });
+            }
+            const int64_t now = static_cast<int64_t>(std::time(nullptr));
+            for (const auto& target : targets) monitor_->add_target(target, monitor_interval_, now);
+            if (!monitor_timer_.connected()) {
+                // Due passes are started from here; results also arrive through the dispatcher
+                monitor_timer_ = Glib::signal_timeout().connect_seconds([this]() {
+                    poll_monitor();
+                    return true;
+                }, 1);
+            }
+            win->set_status("Monitoring " + std::to_string(monitor_->targets().size()) + " targets every "
+                            + format_duration(monitor_interval_) + " (" + monitor_->settings().profile.describe() + ")");
+        }
+
+        void on_monitor_stop() {
+            monitor_timer_.disconnect();
+            if (monitor_) monitor_->clear();
+            if (auto win = dynamic_cast<MainWindow*>(get_active_window())) win->set_status("Monitoring stopped");
+        }
+
+        // Applies to targets added from now on; re-adding a target updates it
+        void set_monitor_interval(int64_t seconds) {
+            monitor_interval_ = seconds;
+            if (auto win = dynamic_cast<MainWindow*>(get_active_window())) {
+                win->set_status("Monitor interval: " + format_duration(seconds));
+            }
+        }
+
+        void poll_monitor() {
+            if (!monitor_) return;
+            auto win = dynamic_cast<MainWindow*>(get_active_window());
+            MapArea* map = win ? win->get_map_area() : nullptr;
+            bool saved = false;
+            const auto runs = monitor_->poll(static_cast<int64_t>(std::time(nullptr)), [&](const NetworkData &network) {
+                if (map) map->update_network(network);
+                saved = true;
+            });
+            if (saved) refresh_views(false);
+
+            for (const auto& run : runs) {
+                if (!run.alert()) continue;
+                std::cout << "Monitor: changes in " << run.diff.summary() << std::endl;
+                if (map) map->set_changes(run.diff);
+                if (win) win->set_status("Monitor: changes in " + run.diff.summary());
+
+                // One notification per target, replaced by the next pass that finds changes
+                auto notification = Gio::Notification::create("Network change in " + run.target);
+                notification->set_body(run.diff.summary());
+                send_notification("monitor-" + run.target, notification);
+            }
+        }
+
+        // Latest passes, newest first
+        void on_monitor_history() {
+            auto win = dynamic_cast<MainWindow*>(get_active_window());
+            if (!win) return;
+            std::ostringstream text;
+            if (!monitor_ || monitor_->history().empty()) {
+                text << "No monitoring passes yet.";
+            } else {
+                constexpr size_t kShown = 25;
+                const auto& history = monitor_->history();
+                size_t shown = 0;
+                for (auto it = history.rbegin(); it != history.rend() && shown < kShown; ++it, ++shown) {
+                    char when[32];
+                    const std::time_t finished = static_cast<std::time_t>(it->finished);
+                    std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", std::localtime(&finished));
+                    text << when << "  ";
+                    if (it->cancelled) text << it->target << ": cancelled";
+                    else if (!it->baseline) text << it->target << ": " << it->hosts << " hosts up (first pass)";
+                    else text << it->diff.summary() << ", " << it->hosts << " hosts up";
+                    text << "\n";
+                }
+                if (history.size() > kShown) text << "(" << history.size() - kShown << " older passes not shown)\n";
+            }
+            for (const auto& target : monitor_ ? monitor_->targets() : std::vector<MonitorTargetInfo>{}) {
+                text << "\n" << target.target << " every " << format_duration(target.interval_seconds) << ", "
+                     << target.passes << " passes, ";
+                if (target.running) {
+                    text << "scanning now";
+                } else {
+                    const int64_t wait = target.next_run - static_cast<int64_t>(std::time(nullptr));
+                    text << "next in " << format_duration(std::max<int64_t>(0, wait));
+                }
+            }
+
+            auto dialog = Gtk::AlertDialog::create("Monitoring History");
+            dialog->set_detail(text.str());
+            dialog->show(*win);
+        }
+
+        // Filter list for a Gtk::FileDialog from (name, glob pattern) pairs
+        static Glib::RefPtr<Gio::ListStore<Gtk::FileFilter>> file_filters(
+            std::initializer_list<std::pair<const char*, const char*>> patterns) {
+            auto filters = Gio::ListStore<Gtk::FileFilter>::create();
+            for (const auto& [name, pattern] : patterns) {
+                auto filter = Gtk::FileFilter::create();
+                filter->set_name(name);
+                filter->add_pattern(pattern);
+                filters->append(filter);
+            }
+            return filters;
+        }
+
+        // Closing a file dialog without choosing is not an error
+        static void report_dialog_error(MainWindow* win, const Gtk::DialogError &e) {
+            if (e.code() == Gtk::DialogError::DISMISSED || e.code() == Gtk::DialogError::CANCELLED) return;
+            std::cerr << "Error: " << e.what() << std::endl;
+            win->set_status(std::string("Error: ") + e.what());
+        }
+
+        // Pick saved -oX files and import them in the background
+        void on_import_xml() {
+            auto win = dynamic_cast<MainWindow*>(get_active_window());
+            if (!win || database_loading(win)) return;
+            if (import_future_.valid()) {
+                win->set_status("An import is already running");
+                return;
+            }
+
+            auto dialog = Gtk::FileDialog::create();
+            dialog->set_title("Import nmap XML");
+            dialog->set_accept_label("_Import");
+            dialog->set_filters(file_filters({{"nmap XML (*.xml)", "*.xml"}}));
+
+            dialog->open_multiple(*win, [this, dialog, win](const Glib::RefPtr<Gio::AsyncResult> &result) {
+                std::vector<std::string> paths;
+                try {
+                    auto files = dialog->open_multiple_finish(result);
+                    for (guint i = 0; i < files->get_n_items(); i++) {
+                        auto file = std::dynamic_pointer_cast<Gio::File>(files->get_object(i));
+                        if (file) paths.push_back(file->get_path());
                     }
+                } catch (const Gtk::DialogError &e) {
+                    report_dialog_error(win, e);
                 }
-                
-                // If no comma found, try space
-                if (targets.size() <= 1) {
-                    targets.clear();
-                    ss.clear();
-                    ss.str(target);
-                    while (ss >> item) {
-                        targets.push_back(item);
+                if (paths.empty()) return;
+
+                win->set_status("Importing " + std::to_string(paths.size()) + " files...");
+                import_future_ = std::async(std::launch::async, [this, paths]() {
+                    // Emit on failure too, or the future is never collected and
+                    // every later import reports one already running
+                    try {
+                        ImportStats stats = import_nmap_files(collect_xml_files(paths));
+                        import_dispatcher_.emit();
+                        return stats;
+                    } catch (...) {
+                        import_dispatcher_.emit();
+                        throw;
                     }
+                });
+            });
+        }
+
+        void on_import_finished() {
+            if (!import_future_.valid()) return;
+            std::ostringstream status;
+            try {
+                ImportStats stats = import_future_.get();
+                status << std::fixed << std::setprecision(1)
+                       << "Imported " << stats.hosts << " hosts from " << stats.files - stats.failed << "/" << stats.files
+                       << " files in " << stats.seconds << " s (" << stats.mb_per_second() << " MB/s, "
+                       << stats.hosts_per_second() << " hosts/s)";
+            } catch (const std::exception &e) {
+                status << "Error importing: " << e.what();
+                std::cerr << status.str() << std::endl;
+            }
+
+            // Files parsed before a failure are already in the store
+            if (auto win = dynamic_cast<MainWindow*>(get_active_window())) {
+                win->get_map_area()->update_networks();
+                refresh_views(false);
+                win->set_status(status.str());
+            }
+        }
+
+        // Export the current snapshot; the format follows the file extension
+        void on_export() {
+            auto win = dynamic_cast<MainWindow*>(get_active_window());
+            if (!win) return;
+            if (export_future_.valid()) {
+                win->set_status("An export is already running");
+                return;
+            }
+
+            auto dialog = Gtk::FileDialog::create();
+            dialog->set_title("Export Hosts");
+            dialog->set_accept_label("_Export");
+            dialog->set_initial_name("nmapvis-hosts.csv");
+            dialog->set_filters(file_filters({
+                {"CSV (*.csv)", "*.csv"}, {"JSON Lines (*.jsonl)", "*.jsonl"},
+                {"GraphML (*.graphml)", "*.graphml"}, {"Graphviz DOT (*.dot)", "*.dot"},
+            }));
+
+            dialog->save(*win, [this, dialog, win](const Glib::RefPtr<Gio::AsyncResult> &result) {
+                std::string path;
+                try {
+                    if (auto file = dialog->save_finish(result)) path = file->get_path();
+                } catch (const Gtk::DialogError &e) {
+                    report_dialog_error(win, e);
                 }
-                
-                // Launch parallel scans
-                for (const auto& t : targets) {
-                    scanner_->add_scan(t, t);
+                if (path.empty()) return;
+
+                auto format = export_format_for_path(path);
+                if (!format) {
+                    win->set_status("Error: export file must end in .csv, .jsonl, .graphml or .dot");
+                    return;
                 }
-                
-                win->set_status("Scanning " + std::to_string(targets.size()) + " target(s)...");
+                auto snapshot = nmapVisualizerGlobals::store.snapshot();
+                win->set_status("Exporting " + std::to_string(snapshot->device_count()) + " hosts to " + path + "...");
+                export_future_ = std::async(std::launch::async, [this, snapshot, format, path]() {
+                    try {
+                        ExportStats stats = export_snapshot(*snapshot, *format, path);
+                        export_dispatcher_.emit();
+                        return stats;
+                    } catch (...) {
+                        export_dispatcher_.emit();
+                        throw;
+                    }
+                });
+            });
+        }
+
+        void on_export_finished() {
+            if (!export_future_.valid()) return;
+            std::ostringstream status;
+            try {
+                ExportStats stats = export_future_.get();
+                status << std::fixed << std::setprecision(1)
+                       << "Exported " << stats.hosts << " hosts (" << stats.bytes / 1e6 << " MB) in " << stats.seconds
+                       << " s (" << stats.hosts_per_second() << " hosts/s)";
+            } catch (const std::exception &e) {
+                status << "Error exporting: " << e.what();
+                std::cerr << status.str() << std::endl;
             }
+            if (auto win = dynamic_cast<MainWindow*>(get_active_window())) win->set_status(status.str());
         }
-        
-        // Timer callback to check scan progress
-        bool on_timer_check_scans() {
-            if (scanner_->check_progress()) {
-                // A scan completed, update the UI
-                if (auto win = dynamic_cast<MainWindow*>(get_active_window())) {
-                    if (auto map = win->get_map_area()) {
-                        // Use Glib dispatcher for thread-safe UI update
-                        Glib::signal_idle().connect_once([win, map]() {
-                            map->update_networks();
-                            map->queue_draw();
-                            
-                            int active = 0;
-                            // Update status would require scanner access, simplified here
-                            win->set_status("Scan completed. Ready.");
-                        });
+
+        // Replace the store contents with the database; returns a status line.
+        // Runs on the load thread; a file mostly made of rescans is compacted
+        std::string load_database() {
+            auto start = std::chrono::steady_clock::now();
+            nmapVisualizerGlobals::store.clear();
+            size_t hosts = nmapVisualizerGlobals::database.load_compacting(nmapVisualizerGlobals::store);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            std::ostringstream status;
+            status << "Loaded " << nmapVisualizerGlobals::store.snapshot()->device_count() << " hosts (" << hosts
+                   << " records) from " << nmapVisualizerGlobals::database.path() << " in "
+                   << std::fixed << std::setprecision(1) << ms << " ms";
+            std::cout << status.str() << std::endl;
+            return status.str();
+        }
+
+        // Open (at start-up) and load the database in the background; the
+        // store is published to the views by on_database_loaded
+        void start_database_load(bool open) {
+            database_future_ = std::async(std::launch::async, [this, open]() {
+                std::string status;
+                try {
+                    if (open) nmapVisualizerGlobals::database.open(ScanDatabase::default_path());
+                    status = load_database();
+                } catch (const std::exception &e) {
+                    status = std::string(open ? "Error opening scan database: " : "Error loading scan database: ") + e.what();
+                    std::cerr << status << std::endl;
+                }
+                database_dispatcher_.emit();
+                return status;
+            });
+        }
+
+        void on_database_loaded() {
+            if (!database_future_.valid()) return;
+            db_status_ = database_future_.get();
+            if (auto win = dynamic_cast<MainWindow*>(get_active_window())) {
+                win->get_map_area()->update_networks();
+                refresh_views(false);
+                win->set_status(db_status_);
+            }
+        }
+
+        // Scans, imports and database actions wait for the load, which replaces the store
+        bool database_loading(MainWindow* win) {
+            if (!database_future_.valid()) return false;
+            if (win) win->set_status("Still loading the scan database...");
+            return true;
+        }
+
+        void on_db_reload() {
+            auto win = dynamic_cast<MainWindow*>(get_active_window());
+            if (database_loading(win)) return;
+            if (win) win->set_status("Loading " + nmapVisualizerGlobals::database.path() + "...");
+            start_database_load(false);
+        }
+
+        // Rewrite the database with only the current hosts, dropping rescan history
+        void on_db_compact() {
+            auto win = dynamic_cast<MainWindow*>(get_active_window());
+            if (database_loading(win)) return;
+            std::string status = "Database compacted";
+            try {
+                nmapVisualizerGlobals::database.compact(*nmapVisualizerGlobals::store.snapshot());
+            } catch (const std::exception &e) {
+                status = std::string("Error compacting scan database: ") + e.what();
+                std::cerr << status << std::endl;
+            }
+            if (win) win->set_status(status);
+        }
+
+        void on_db_clear() {
+            auto win = dynamic_cast<MainWindow*>(get_active_window());
+            if (database_loading(win)) return;
+            std::string status = "Database cleared";
+            try {
+                nmapVisualizerGlobals::database.clear();
+                nmapVisualizerGlobals::store.clear();
+            } catch (const std::exception &e) {
+                status = std::string("Error clearing scan database: ") + e.what();
+                std::cerr << status << std::endl;
+            }
+            if (win) {
+                win->get_map_area()->update_networks();
+                refresh_views(false);
+                win->set_status(status);
+            }
+        }
+
+        // Re-run the filter bar query against the store and refill the host
+        // table. The index is rebuilt only when the snapshot changed; announce
+        // puts the match count in the status line (scan updates refresh quietly)
+        void refresh_views(bool announce) {
+            trace::Scope scope("ui", "refresh_views");
+            auto win = dynamic_cast<MainWindow*>(get_active_window());
+            if (!win || !win->get_map_area()) return;
+            auto snapshot = nmapVisualizerGlobals::store.snapshot();
+            const std::string text = win->get_filter_text();
+            try {
+                Query query = Query::parse(text);
+                if (query.empty()) {
+                    filter_matches_.reset();
+                    if (announce) win->set_status("");
+                } else {
+                    auto start = std::chrono::steady_clock::now();
+                    if (host_index_.snapshot != snapshot) host_index_.build(snapshot);
+                    QueryResult result = host_index_.evaluate(query);
+                    auto matches = std::make_shared<HostSet>();
+                    matches->reserve(result.hosts.size());
+                    for (uint32_t host : result.hosts) matches->insert(host_index_.devices[host]);
+                    filter_matches_ = std::move(matches);
+                    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                    if (announce) {
+                        std::ostringstream status;
+                        status << "Filter: " << result.hosts.size() << " of " << host_index_.size() << " hosts match ("
+                               << std::fixed << std::setprecision(1) << ms << " ms)";
+                        win->set_status(status.str());
                     }
                 }
-                scanner_->clear_completed();
+            } catch (const std::invalid_argument &e) {
+                // keep the last good filter while the query is being typed
+                if (announce) win->set_status(std::string("Filter: ") + e.what());
             }
-            
-            // Update status with active scan count
-            int active_scans = scanner_->active_count();
-            if (active_scans > 0) {
-                if (auto win = dynamic_cast<MainWindow*>(get_active_window())) {
-                    Glib::signal_idle().connect_once([win, active_scans]() {
-                        win->set_status("Scanning... (" + std::to_string(active_scans) + " active)");
-                    });
+            win->get_map_area()->set_filter(filter_matches_);
+            win->get_host_list()->show_hosts(snapshot, filter_matches_);
+        }
+
+        void on_trace_start() {
+            trace::recorder().start();
+            if (auto win = dynamic_cast<MainWindow*>(get_active_window())) {
+                win->set_status("Recording trace; File > Trace: Stop and Save... writes it out");
+            }
+        }
+
+        // Stop recording and write Chrome trace JSON (chrome://tracing, ui.perfetto.dev)
+        void on_trace_save() {
+            auto win = dynamic_cast<MainWindow*>(get_active_window());
+            if (!win) return;
+
+            // Recording goes on until a file is chosen, so a cancelled dialog loses nothing
+            auto dialog = Gtk::FileDialog::create();
+            dialog->set_title("Save Trace");
+            dialog->set_initial_name("nmapvis-trace.json");
+
+            dialog->save(*win, [dialog, win](const Glib::RefPtr<Gio::AsyncResult> &result) {
+                std::string path;
+                try {
+                    if (auto file = dialog->save_finish(result)) path = file->get_path();
+                } catch (const Gtk::DialogError &e) {
+                    report_dialog_error(win, e);
+                }
+                if (path.empty()) return;
+
+                trace::recorder().stop();
+                std::string status;
+                try {
+                    const size_t events = trace::recorder().write_json(path);
+                    status = "Wrote " + std::to_string(events) + " trace events to " + path;
+                } catch (const std::exception &e) {
+                    status = std::string("Error writing trace: ") + e.what();
+                    std::cerr << status << std::endl;
                 }
+                win->set_status(status);
+            });
+        }
+
+        void on_toggle_overlay() {
+            auto win = dynamic_cast<MainWindow*>(get_active_window());
+            if (!win || !win->get_map_area()) return;
+            const bool enable = !win->get_map_area()->overlay();
+            win->get_map_area()->set_overlay(enable);
+            overlay_timer_.disconnect();
+            if (!enable) return;
+            overlay_sample_time_ = std::chrono::steady_clock::now();
+            overlay_sample_hosts_ = trace::stats().hosts_parsed.load(std::memory_order_relaxed);
+            update_overlay();
+            overlay_timer_ = Glib::signal_timeout().connect([this]() {
+                update_overlay();
+                return true;
+            }, 500);
+        }
+
+        // Rates since the previous sample, queue depths and lock contention
+        void update_overlay() {
+            auto win = dynamic_cast<MainWindow*>(get_active_window());
+            if (!win || !win->get_map_area()) return;
+            const auto now = std::chrono::steady_clock::now();
+            const uint64_t parsed = trace::stats().hosts_parsed.load(std::memory_order_relaxed);
+            const double seconds = std::chrono::duration<double>(now - overlay_sample_time_).count();
+            const double parse_rate = seconds > 0.0 ? (parsed - overlay_sample_hosts_) / seconds : 0.0;
+            overlay_sample_time_ = now;
+            overlay_sample_hosts_ = parsed;
+
+            const ScannerStats scan = scanner_->stats();
+            const trace::Stats& totals = trace::stats();
+            auto snapshot = nmapVisualizerGlobals::store.snapshot();
+            std::vector<std::string> lines;
+            std::ostringstream line;
+            line << std::fixed << std::setprecision(0) << "parse " << parse_rate << " hosts/s (" << parsed << " total)";
+            lines.push_back(line.str());
+            line.str("");
+            line << "scan " << scan.queued << " queued, " << scan.running << " running, " << scan.events_pending << " events pending";
+            lines.push_back(line.str());
+            line.str("");
+            line << std::fixed << std::setprecision(1) << "locks " << totals.lock_waits.load() << " contended, "
+                 << totals.lock_wait_us.load() / 1000.0 << " ms blocked";
+            lines.push_back(line.str());
+            line.str("");
+            line << "store " << snapshot->device_count() << " hosts, " << snapshot->networks.size() << " networks, v" << snapshot->version;
+            lines.push_back(line.str());
+            if (trace::recorder().enabled()) {
+                lines.push_back("trace recording (" + std::to_string(totals.dropped_events.load()) + " events dropped)");
             }
-            
-            return true;  // Keep timer running
+            win->get_map_area()->set_overlay_lines(std::move(lines));
+        }
+
+        void set_cluster_mode(ClusterMode mode) {
+            auto win = dynamic_cast<MainWindow*>(get_active_window());
+            if (win && win->get_map_area()) win->get_map_area()->set_cluster_mode(mode);
+        }
+
+        void set_layout_kind(LayoutKind kind) {
+            auto win = dynamic_cast<MainWindow*>(get_active_window());
+            if (win && win->get_map_area()) win->get_map_area()->set_layout_kind(kind);
         }
 
     private:
+        Glib::Dispatcher scan_dispatcher_;
         std::unique_ptr<ParallelScanner> scanner_;
+        std::string db_status_;
+
+        std::unique_ptr<ScanSession> session_;  // runs of scanner_, diffed against the network as it was before
+
+        // Latest --stats-every report per running scan (incremental scans report under their job id)
+        struct TaskProgress {
+            std::string target;
+            ScanProgress progress;
+        };
+        std::map<uint64_t, TaskProgress> progress_;
+        bool incremental_ = false;  // Scans: Incremental probes only new and stale hosts of known networks
+        static constexpr const char* kProfileIds[] = {"quick", "default", "services", "thorough"};  // scan_profiles() order
+        Glib::RefPtr<Gio::SimpleAction> profile_action_;
+        Glib::RefPtr<Gio::SimpleAction> timing_action_;
+        Glib::RefPtr<Gio::SimpleAction> ports_action_;
+        Glib::RefPtr<Gio::SimpleAction> version_detection_action_;
+        Glib::RefPtr<Gio::SimpleAction> os_detection_action_;
+        Glib::RefPtr<Gio::SimpleAction> min_rate_action_;
+        Glib::RefPtr<Gio::SimpleAction> scan_mode_action_;
+        int64_t rescan_ttl_ = 86400;  // seconds before a host gets a full scan again
+        Glib::RefPtr<Gio::SimpleAction> rescan_ttl_action_;
+        Glib::Dispatcher import_dispatcher_;
+        std::future<ImportStats> import_future_;
+        Glib::Dispatcher export_dispatcher_;
+        std::future<ExportStats> export_future_;
+        Glib::Dispatcher monitor_dispatcher_;
+        std::unique_ptr<Monitor> monitor_;  // created by the first Monitor: Start; destroyed before its dispatcher
+        Glib::Dispatcher database_dispatcher_;
+        std::future<std::string> database_future_;  // start-up load or Database: Reload
+        sigc::connection monitor_timer_;
+        int64_t monitor_interval_ = 15 * 60;
+        HostIndex host_index_;  // filter bar index over the last snapshot it was built from
+        std::shared_ptr<const HostSet> filter_matches_;  // nullptr while the filter bar is empty
+        sigc::connection overlay_timer_;
+        std::chrono::steady_clock::time_point overlay_sample_time_;
+        uint64_t overlay_sample_hosts_ = 0;
 
     public:
         static Glib::RefPtr<nmapVisualizer> create() {
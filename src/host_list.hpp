@@ -0,0 +1,358 @@
+#ifndef HOST_LIST_HPP
+#define HOST_LIST_HPP
+
+#include <gtkmm.h>
+#include <algorithm>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "store.hpp"
+#include "query.hpp"
+
+// Header, cell text and sort order of one table column
+template <typename T>
+struct TableColumn {
+    std::string title;
+    std::function<std::string(const T&)> text;
+    std::function<bool(const T&, const T&)> less;
+    bool expand = false;
+};
+
+// Row object handed to the list item widgets; only rows a view asks for are wrapped
+template <typename T>
+class TableRow : public Glib::Object {
+public:
+    T value;
+    std::shared_ptr<const void> keepalive;  // owner of whatever value points into
+
+    static Glib::RefPtr<TableRow> create(const T &value, std::shared_ptr<const void> keepalive) {
+        return Glib::make_refptr_for_instance<TableRow>(new TableRow(value, std::move(keepalive)));
+    }
+
+protected:
+    TableRow(const T &v, std::shared_ptr<const void> k)
+        : Glib::ObjectBase(typeid(TableRow)), value(v), keepalive(std::move(k)) {}
+};
+
+// Gio::ListModel over a plain vector. Sorting permutes indexes, and rows
+// become objects only when a view binds them, so a 100k-row table costs one
+// vector plus a screenful of widgets.
+template <typename T>
+class TableModel : public Glib::Object, public Gio::ListModel {
+public:
+    static Glib::RefPtr<TableModel> create() {
+        return Glib::make_refptr_for_instance<TableModel>(new TableModel());
+    }
+
+    // Rows that show the same thing; without it every refresh replaces the whole list
+    void set_identity(std::function<bool(const T&, const T&)> same) { same_ = std::move(same); }
+
+    // Only the span between the unchanged head and tail is reported as
+    // changed, so views keep the widgets, scroll position and selection of
+    // the rest. A scan appending hosts touches just the new rows
+    void set_rows(std::vector<T> rows, std::shared_ptr<const void> keepalive) {
+        std::vector<T> old_rows = std::move(rows_);
+        std::vector<uint32_t> old_order = std::move(order_);
+        rows_ = std::move(rows);
+        keepalive_ = std::move(keepalive);
+        order_.resize(rows_.size());
+        apply_order();
+
+        size_t head = 0, tail = 0;
+        if (same_) {
+            const size_t common = std::min(old_order.size(), order_.size());
+            auto same_at = [&](size_t old_position, size_t position) {
+                return same_(old_rows[old_order[old_position]], rows_[order_[position]]);
+            };
+            while (head < common && same_at(head, head)) head++;
+            while (tail < common - head && same_at(old_order.size() - 1 - tail, order_.size() - 1 - tail)) tail++;
+        }
+        if (head == old_order.size() && head == order_.size()) return;
+        items_changed(static_cast<guint>(head), static_cast<guint>(old_order.size() - head - tail),
+                      static_cast<guint>(order_.size() - head - tail));
+    }
+
+    // nullptr keeps the order rows were given in
+    void set_order(std::function<bool(const T&, const T&)> less, bool descending) {
+        less_ = std::move(less);
+        descending_ = descending;
+        apply_order();
+        items_changed(0, static_cast<guint>(order_.size()), static_cast<guint>(order_.size()));
+    }
+
+    size_t size() const { return order_.size(); }
+
+protected:
+    TableModel() : Glib::ObjectBase(typeid(TableModel)) {}
+
+    GType get_item_type_vfunc() override { return G_TYPE_OBJECT; }
+
+    guint get_n_items_vfunc() override { return static_cast<guint>(order_.size()); }
+
+    // transfer full: the caller owns the returned reference
+    gpointer get_item_vfunc(guint position) override {
+        if (position >= order_.size()) return nullptr;
+        return TableRow<T>::create(rows_[order_[position]], keepalive_)->gobj_copy();
+    }
+
+private:
+    std::vector<T> rows_;
+    std::vector<uint32_t> order_;  // position -> index into rows_
+    std::shared_ptr<const void> keepalive_;
+    std::function<bool(const T&, const T&)> less_;
+    std::function<bool(const T&, const T&)> same_;
+    bool descending_ = false;
+
+    void apply_order() {
+        std::iota(order_.begin(), order_.end(), 0u);
+        if (!less_) return;
+        // stable, so equal keys keep the source order in both directions
+        std::stable_sort(order_.begin(), order_.end(), [this](uint32_t a, uint32_t b) {
+            return descending_ ? less_(rows_[b], rows_[a]) : less_(rows_[a], rows_[b]);
+        });
+    }
+};
+
+// Scrolled ColumnView over a TableModel: cell labels are recycled as rows
+// scroll past, and clicking a header re-sorts the model rather than wrapping
+// every row for a Gtk::SortListModel
+template <typename T>
+class TableView : public Gtk::ScrolledWindow {
+public:
+    explicit TableView(std::vector<TableColumn<T>> columns)
+        : columns_(std::move(columns)), model_(TableModel<T>::create()), selection_(Gtk::SingleSelection::create(model_)) {
+        selection_->set_autoselect(false);
+        selection_->set_can_unselect(true);
+        view_.set_model(selection_);
+        view_.set_show_column_separators(true);
+
+        for (size_t i = 0; i < columns_.size(); i++) {
+            auto factory = Gtk::SignalListItemFactory::create();
+            factory->signal_setup().connect([](const Glib::RefPtr<Gtk::ListItem>& item) {
+                auto label = Gtk::make_managed<Gtk::Label>();
+                label->set_xalign(0);
+                label->set_ellipsize(Pango::EllipsizeMode::END);
+                item->set_child(*label);
+            });
+            factory->signal_bind().connect([this, i](const Glib::RefPtr<Gtk::ListItem>& item) {
+                auto row = std::dynamic_pointer_cast<TableRow<T>>(item->get_item());
+                auto label = dynamic_cast<Gtk::Label*>(item->get_child());
+                if (row && label) label->set_text(columns_[i].text(row->value));
+            });
+
+            auto column = Gtk::ColumnViewColumn::create(columns_[i].title, factory);
+            column->set_resizable(true);
+            column->set_expand(columns_[i].expand);
+            // never run: it only makes the header sortable, the model does the sorting
+            column->set_sorter(Gtk::CustomSorter::create(
+                [](const Glib::RefPtr<const Glib::ObjectBase>&, const Glib::RefPtr<const Glib::ObjectBase>&) { return 0; }));
+            view_.append_column(column);
+            view_columns_.push_back(column);
+        }
+
+        if (auto sorter = std::dynamic_pointer_cast<Gtk::ColumnViewSorter>(view_.get_sorter())) {
+            sorter->signal_changed().connect([this](Gtk::Sorter::Change) { on_sort_changed(); });
+        }
+        selection_->property_selected().signal_changed().connect([this]() {
+            auto row = std::dynamic_pointer_cast<TableRow<T>>(selection_->get_selected_item());
+            if (row) signal_row_selected_.emit(row->value);
+        });
+
+        set_child(view_);
+        set_vexpand(true);
+        set_hexpand(true);
+    }
+
+    void set_rows(std::vector<T> rows, std::shared_ptr<const void> keepalive = nullptr) {
+        model_->set_rows(std::move(rows), std::move(keepalive));
+    }
+
+    void set_identity(std::function<bool(const T&, const T&)> same) { model_->set_identity(std::move(same)); }
+
+    size_t size() const { return model_->size(); }
+
+    sigc::signal<void(const T&)>& signal_row_selected() { return signal_row_selected_; }
+
+private:
+    std::vector<TableColumn<T>> columns_;
+    Glib::RefPtr<TableModel<T>> model_;
+    Glib::RefPtr<Gtk::SingleSelection> selection_;
+    Gtk::ColumnView view_;
+    std::vector<Glib::RefPtr<Gtk::ColumnViewColumn>> view_columns_;
+    sigc::signal<void(const T&)> signal_row_selected_;
+
+    void on_sort_changed() {
+        auto sorter = std::dynamic_pointer_cast<Gtk::ColumnViewSorter>(view_.get_sorter());
+        auto column = sorter ? sorter->get_primary_sort_column() : nullptr;
+        for (size_t i = 0; column && i < view_columns_.size(); i++) {
+            if (view_columns_[i] != column) continue;
+            model_->set_order(columns_[i].less, sorter->get_primary_sort_order() == Gtk::SortType::DESCENDING);
+            return;
+        }
+        model_->set_order(nullptr, false);
+    }
+};
+
+// One host in the table; pointers stay valid while the snapshot is held
+struct HostEntry {
+    const DeviceInfo* device;
+    const std::string* cidr;
+
+    // Snapshots share unchanged records, so the same pointer is the same host
+    // data; networks are copied when they change, so compare their names
+    bool same(const HostEntry &other) const { return device == other.device && *cidr == *other.cidr; }
+};
+
+namespace host_list_detail {
+
+inline size_t open_ports(const DeviceInfo &device) {
+    size_t count = 0;
+    for (const auto& port : device.ports) count += port.state == PortState::Open;
+    return count;
+}
+
+inline bool less_text(InternedString a, InternedString b) {
+    return a != b && a.str() < b.str();
+}
+
+inline bool less_ip(const IpAddress &a, const IpAddress &b) {
+    return a.family != b.family ? a.family < b.family : a.bytes < b.bytes;
+}
+
+inline std::string format_time(int64_t seconds) {
+    if (seconds <= 0) return "-";
+    std::time_t time = static_cast<std::time_t>(seconds);
+    std::tm local{};
+#if defined(_WIN32)
+    localtime_s(&local, &time);
+#else
+    localtime_r(&time, &local);
+#endif
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M", &local);
+    return buffer;
+}
+
+inline std::vector<TableColumn<HostEntry>> host_columns() {
+    using E = HostEntry;
+    return {
+        {"Network", [](const E& e) { return *e.cidr; }, [](const E& a, const E& b) { return *a.cidr < *b.cidr; }},
+        {"IP", [](const E& e) { return e.device->ipAddress.to_string(); },
+         [](const E& a, const E& b) { return less_ip(a.device->ipAddress, b.device->ipAddress); }},
+        {"MAC", [](const E& e) { return e.device->macAddress.to_string(); },
+         [](const E& a, const E& b) { return a.device->macAddress.bytes < b.device->macAddress.bytes; }},
+        {"Hostname", [](const E& e) { return e.device->deviceType.str(); },
+         [](const E& a, const E& b) { return less_text(a.device->deviceType, b.device->deviceType); }, true},
+        {"Vendor", [](const E& e) { return e.device->vendor.str(); },
+         [](const E& a, const E& b) { return less_text(a.device->vendor, b.device->vendor); }, true},
+        {"OS", [](const E& e) { return e.device->operatingSystem.str(); },
+         [](const E& a, const E& b) { return less_text(a.device->operatingSystem, b.device->operatingSystem); }, true},
+        {"Open", [](const E& e) { return std::to_string(open_ports(*e.device)); },
+         [](const E& a, const E& b) { return open_ports(*a.device) < open_ports(*b.device); }},
+        {"Last Scan", [](const E& e) { return format_time(e.device->lastScanned); },
+         [](const E& a, const E& b) { return a.device->lastScanned < b.device->lastScanned; }},
+    };
+}
+
+inline std::vector<TableColumn<Port>> port_columns() {
+    auto key = [](const Port& p) { return std::make_pair(p.portNumber, p.protocol); };
+    return {
+        {"Port", [](const Port& p) { return std::to_string(p.portNumber); },
+         [key](const Port& a, const Port& b) { return key(a) < key(b); }},
+        {"Proto", [](const Port& p) { return std::string(to_string(p.protocol)); },
+         [](const Port& a, const Port& b) { return a.protocol < b.protocol; }},
+        {"State", [](const Port& p) { return std::string(to_string(p.state)); },
+         [](const Port& a, const Port& b) { return a.state < b.state; }},
+        {"Service", [](const Port& p) { return p.service.str(); },
+         [](const Port& a, const Port& b) { return less_text(a.service, b.service); }, true},
+    };
+}
+
+} // namespace host_list_detail
+
+/*
+NETWORK PICKER: a drop-down with "All Networks" plus one entry per network
+above a single host table; picking one refills the table, so the widget
+count does not grow with the number of networks or hosts.
+*/
+class HostListPanel : public Gtk::Box {
+public:
+    HostListPanel()
+        : Gtk::Box(Gtk::Orientation::VERTICAL, 0), networks_(Gtk::StringList::create({})),
+          hosts_(host_list_detail::host_columns()) {
+        network_select_.set_model(networks_);
+        network_select_.set_halign(Gtk::Align::START);
+        network_select_.property_selected().signal_changed().connect([this]() {
+            if (!rebuilding_networks_) refill();
+        });
+        hosts_.set_identity([](const HostEntry& a, const HostEntry& b) { return a.same(b); });
+        hosts_.signal_row_selected().connect([this](const HostEntry& entry) {
+            signal_device_selected_.emit(*entry.device);
+        });
+        append(network_select_);
+        append(hosts_);
+    }
+
+    // Show the store (restricted to matches when a filter is active)
+    void show_hosts(std::shared_ptr<const StoreSnapshot> snapshot, std::shared_ptr<const HostSet> matches) {
+        if (snapshot == snapshot_ && matches == matches_) return;
+        snapshot_ = std::move(snapshot);
+        matches_ = std::move(matches);
+        rebuild_networks();
+        refill();
+    }
+
+    sigc::signal<void(DeviceInfo)>& signal_device_selected() { return signal_device_selected_; }
+
+private:
+    Gtk::DropDown network_select_;
+    Glib::RefPtr<Gtk::StringList> networks_;
+    TableView<HostEntry> hosts_;
+    std::vector<std::string> network_cidrs_;  // drop-down position -> cidr, "" for all
+    bool rebuilding_networks_ = false;
+    std::shared_ptr<const StoreSnapshot> snapshot_;
+    std::shared_ptr<const HostSet> matches_;
+    sigc::signal<void(DeviceInfo)> signal_device_selected_;
+
+    void rebuild_networks() {
+        std::vector<std::string> cidrs{""};
+        for (const auto& network : snapshot_->networks) cidrs.push_back(network->cidr);
+        if (cidrs == network_cidrs_) return;
+
+        // keep the current network selected if it is still there
+        const guint current = network_select_.get_selected();
+        const std::string shown = current < network_cidrs_.size() ? network_cidrs_[current] : "";
+        std::vector<Glib::ustring> names;
+        guint select = 0;
+        for (size_t i = 0; i < cidrs.size(); i++) {
+            names.push_back(cidrs[i].empty() ? "All Networks" : cidrs[i]);
+            if (cidrs[i] == shown) select = static_cast<guint>(i);
+        }
+        rebuilding_networks_ = true;
+        networks_->splice(0, networks_->get_n_items(), names);
+        network_select_.set_selected(select);
+        network_cidrs_ = std::move(cidrs);
+        rebuilding_networks_ = false;
+    }
+
+    void refill() {
+        const guint selected = network_select_.get_selected();
+        if (!snapshot_ || selected >= network_cidrs_.size()) return;
+        const std::string& cidr = network_cidrs_[selected];
+        std::vector<HostEntry> rows;
+        for (const auto& network : snapshot_->networks) {
+            if (!cidr.empty() && network->cidr != cidr) continue;
+            for (const auto& device : network->devices) {
+                if (matches_ && !matches_->count(device.get())) continue;
+                rows.push_back(HostEntry{device.get(), &network->cidr});
+            }
+        }
+        hosts_.set_rows(std::move(rows), snapshot_);
+    }
+};
+
+#endif // HOST_LIST_HPP
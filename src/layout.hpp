@@ -0,0 +1,47 @@
+#ifndef LAYOUT_HPP
+#define LAYOUT_HPP
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+
+// Device positions of one network in structure-of-arrays form. Normalized
+// coordinates (fractions of the widget size) are computed once per layout
+// change; pixel coordinates are derived from them on resize without trig and,
+// once the arrays have grown to the device count, without allocating.
+class RingLayout {
+public:
+    std::vector<float> nx, ny;   // normalized, 0..1 of the widget
+    std::vector<float> x, y;     // pixels at the last scale() size
+    float center_nx = 0.5f, center_ny = 0.5f;
+    float radius = 1.0f / 3.0f;  // normalized ring radius around the center
+    double center_x = 0.0, center_y = 0.0;
+
+    size_t size() const { return nx.size(); }
+
+    // Evenly spaced ring around the center
+    void compute_ring(size_t count) {
+        nx.resize(count);
+        ny.resize(count);
+        const double step = count ? 2 * 3.14159265358979323846 / count : 0.0;
+        for (size_t i = 0; i < count; i++) {
+            nx[i] = static_cast<float>(center_nx + std::cos(i * step) * radius);
+            ny[i] = static_cast<float>(center_ny + std::sin(i * step) * radius);
+        }
+    }
+
+    void scale(double width, double height) {
+        const size_t count = nx.size();
+        x.resize(count);
+        y.resize(count);
+        const float w = static_cast<float>(width), h = static_cast<float>(height);
+        for (size_t i = 0; i < count; i++) {
+            x[i] = nx[i] * w;
+            y[i] = ny[i] * h;
+        }
+        center_x = center_nx * width;
+        center_y = center_ny * height;
+    }
+};
+
+#endif // LAYOUT_HPP
@@ -0,0 +1,503 @@
+#ifndef LAYOUT_ENGINE_HPP
+#define LAYOUT_ENGINE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "layout.hpp"
+#include "queue.hpp"
+
+// Layout algorithms for MapArea. Everything works in normalized coordinates
+// (0..1 of the widget) and fills RingLayout::nx/ny, so the widget only has to
+// scale() the result. Nothing here touches GTK.
+enum class LayoutKind : uint8_t { Ring, RadialSubnet, Hierarchical, ForceDirected };
+
+// What a layout needs to know about one network
+struct LayoutNetwork {
+    std::vector<uint32_t> group_of;  // device -> subnet group (e.g. its /24)
+    uint32_t group_count = 0;
+    std::vector<float> nx, ny;       // current positions; seed the force layout, may be empty
+
+    size_t size() const { return group_of.size(); }
+};
+
+// Positions for every network of one request, in request order
+struct LayoutFrame {
+    uint64_t generation = 0;
+    bool final = false;
+    std::vector<RingLayout> networks;
+    std::vector<uint32_t> index;  // where each network sits among all `total` of them
+    size_t total = 0;
+};
+
+// Give each network its own cell of a near-square grid instead of stacking
+// every ring on the widget center
+inline void tile_networks(size_t count, std::vector<RingLayout> &out) {
+    out.resize(count);
+    if (count == 0) return;
+    const size_t cols = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+    const size_t rows = (count + cols - 1) / cols;
+    const float cell = 1.0f / static_cast<float>(std::max(cols, rows));
+    for (size_t i = 0; i < count; i++) {
+        RingLayout &layout = out[i];
+        layout.center_nx = (static_cast<float>(i % cols) + 0.5f) / cols;
+        layout.center_ny = (static_cast<float>(i / cols) + 0.5f) / rows;
+        layout.radius = cell / 3.0f;
+    }
+}
+
+// Devices ordered by group, one angular sector per group with a one-slot gap
+// between sectors
+inline void layout_radial(const LayoutNetwork &network, RingLayout &layout) {
+    const size_t count = network.size();
+    layout.nx.resize(count);
+    layout.ny.resize(count);
+    if (count == 0) return;
+
+    // counting sort of device indices by group
+    std::vector<uint32_t> start(network.group_count + 1, 0);
+    for (uint32_t g : network.group_of) start[g + 1]++;
+    for (size_t g = 1; g < start.size(); g++) start[g] += start[g - 1];
+    std::vector<uint32_t> order(count);
+    std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+    for (uint32_t i = 0; i < count; i++) order[fill[network.group_of[i]]++] = i;
+
+    const size_t gaps = network.group_count > 1 ? network.group_count : 0;
+    const double step = 2 * 3.14159265358979323846 / static_cast<double>(count + gaps);
+    size_t slot = 0;
+    for (uint32_t g = 0; g < network.group_count; g++) {
+        for (uint32_t k = start[g]; k < start[g + 1]; k++, slot++) {
+            const uint32_t i = order[k];
+            layout.nx[i] = static_cast<float>(layout.center_nx + std::cos(slot * step) * layout.radius);
+            layout.ny[i] = static_cast<float>(layout.center_ny + std::sin(slot * step) * layout.radius);
+        }
+        if (gaps) slot++;
+    }
+}
+
+// Tree by CIDR: the network root on top, one column per group below it (as
+// wide as the group's share of devices), devices in a grid inside the column
+inline void layout_hierarchical(const LayoutNetwork &network, RingLayout &layout) {
+    const size_t count = network.size();
+    layout.nx.resize(count);
+    layout.ny.resize(count);
+    if (count == 0) return;
+
+    const float half = layout.radius * 1.5f;
+    const float left = layout.center_nx - half;
+    const float top = layout.center_ny - half * 0.4f;
+    const float width = half * 2.0f;
+    const float height = half * 1.4f;
+    layout.center_ny -= half * 0.8f;
+
+    std::vector<uint32_t> sizes(network.group_count, 0);
+    for (uint32_t g : network.group_of) sizes[g]++;
+
+    std::vector<float> column_x(network.group_count), column_w(network.group_count);
+    std::vector<uint32_t> columns(network.group_count), placed(network.group_count, 0);
+    float x = left;
+    for (uint32_t g = 0; g < network.group_count; g++) {
+        column_x[g] = x;
+        column_w[g] = width * sizes[g] / static_cast<float>(count);
+        x += column_w[g];
+        // roughly square cells inside the column
+        columns[g] = std::max<uint32_t>(1, static_cast<uint32_t>(std::lround(std::sqrt(sizes[g] * column_w[g] / height))));
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t g = network.group_of[i];
+        const uint32_t rows = (sizes[g] + columns[g] - 1) / columns[g];
+        const uint32_t col = placed[g] % columns[g], row = placed[g] / columns[g];
+        placed[g]++;
+        layout.nx[i] = column_x[g] + (col + 0.5f) * column_w[g] / columns[g];
+        layout.ny[i] = top + (row + 0.5f) * height / rows;
+    }
+}
+
+// Fruchterman-Reingold style force layout over all networks at once. Devices
+// are tied to their network's hub node by springs; repulsion between every
+// pair is approximated with a Barnes-Hut quadtree, so an iteration is
+// O(n log n).
+class ForceLayout {
+private:
+    static constexpr int kMaxDepth = 24;
+    static constexpr float kTheta = 0.8f;
+
+    struct QuadNode {
+        float x0, y0, size;          // square cell
+        float cx = 0, cy = 0;        // center of mass
+        float mass = 0;
+        int32_t child[4] = {-1, -1, -1, -1};
+        int32_t body = -1;           // single body in a leaf, -1 otherwise
+        bool leaf = true;
+    };
+
+    std::vector<float> px_, py_, dx_, dy_;
+    std::vector<uint32_t> hub_of_;   // body -> hub body (hubs point at themselves)
+    std::vector<size_t> offsets_;    // first body of each network; hubs follow all devices
+    std::vector<QuadNode> tree_;
+    std::vector<int32_t> stack_;
+    float k2_ = 0.0f, temperature_ = 0.0f;
+    int iteration_ = 0;
+
+    int32_t child_for(int32_t node, float x, float y) {
+        const float half = tree_[node].size / 2;
+        const int quadrant = (x >= tree_[node].x0 + half ? 1 : 0) | (y >= tree_[node].y0 + half ? 2 : 0);
+        if (tree_[node].child[quadrant] < 0) {
+            QuadNode child;
+            child.x0 = tree_[node].x0 + ((quadrant & 1) ? half : 0);
+            child.y0 = tree_[node].y0 + ((quadrant & 2) ? half : 0);
+            child.size = half;
+            tree_[node].child[quadrant] = static_cast<int32_t>(tree_.size());
+            tree_.push_back(child);
+        }
+        return tree_[node].child[quadrant];
+    }
+
+    static void add_mass(QuadNode &node, float x, float y) {
+        node.cx = (node.cx * node.mass + x) / (node.mass + 1);
+        node.cy = (node.cy * node.mass + y) / (node.mass + 1);
+        node.mass += 1;
+    }
+
+    void build_tree() {
+        float x0 = px_[0], y0 = py_[0], x1 = x0, y1 = y0;
+        for (size_t i = 1; i < px_.size(); i++) {
+            x0 = std::min(x0, px_[i]); x1 = std::max(x1, px_[i]);
+            y0 = std::min(y0, py_[i]); y1 = std::max(y1, py_[i]);
+        }
+        tree_.clear();
+        QuadNode root;
+        root.x0 = x0;
+        root.y0 = y0;
+        root.size = std::max(x1 - x0, y1 - y0) * 1.0001f + 1e-6f;
+        tree_.push_back(root);
+
+        for (uint32_t b = 0; b < px_.size(); b++) {
+            const float x = px_[b], y = py_[b];
+            int32_t node = 0;
+            for (int depth = 0;; depth++) {
+                if (tree_[node].leaf && tree_[node].mass == 0) {
+                    tree_[node].body = static_cast<int32_t>(b);
+                    add_mass(tree_[node], x, y);
+                    break;
+                }
+                if (tree_[node].leaf) {
+                    // coincident points end up sharing one bucket leaf
+                    if (depth >= kMaxDepth) {
+                        tree_[node].body = -1;
+                        add_mass(tree_[node], x, y);
+                        break;
+                    }
+                    const int32_t old = tree_[node].body;
+                    tree_[node].leaf = false;
+                    tree_[node].body = -1;
+                    if (old >= 0) {
+                        const int32_t child = child_for(node, px_[old], py_[old]);
+                        tree_[child].body = old;
+                        add_mass(tree_[child], px_[old], py_[old]);
+                    }
+                }
+                add_mass(tree_[node], x, y);
+                node = child_for(node, x, y);
+            }
+        }
+    }
+
+    void repulse(uint32_t b) {
+        const float x = px_[b], y = py_[b];
+        float fx = 0, fy = 0;
+        stack_.clear();
+        stack_.push_back(0);
+        while (!stack_.empty()) {
+            const QuadNode &node = tree_[stack_.back()];
+            stack_.pop_back();
+            if (node.mass == 0 || node.body == static_cast<int32_t>(b)) continue;
+            const float ddx = x - node.cx, ddy = y - node.cy;
+            const float d2 = std::max(ddx * ddx + ddy * ddy, 1e-10f);
+            if (node.leaf || node.size * node.size < kTheta * kTheta * d2) {
+                // magnitude k^2 / d per unit mass
+                const float scale = node.mass * k2_ / d2;
+                fx += ddx * scale;
+                fy += ddy * scale;
+            } else {
+                for (int32_t child : node.child) if (child >= 0) stack_.push_back(child);
+            }
+        }
+        dx_[b] += fx;
+        dy_[b] += fy;
+    }
+
+public:
+    // Seed from the given layouts (hubs start at the network centers)
+    void init(const std::vector<RingLayout> &layouts) {
+        offsets_.clear();
+        size_t devices = 0;
+        for (const auto &layout : layouts) {
+            offsets_.push_back(devices);
+            devices += layout.size();
+        }
+        const size_t bodies = devices + layouts.size();
+        px_.resize(bodies);
+        py_.resize(bodies);
+        dx_.assign(bodies, 0);
+        dy_.assign(bodies, 0);
+        hub_of_.resize(bodies);
+        for (size_t n = 0; n < layouts.size(); n++) {
+            const uint32_t hub = static_cast<uint32_t>(devices + n);
+            px_[hub] = layouts[n].center_nx;
+            py_[hub] = layouts[n].center_ny;
+            hub_of_[hub] = hub;
+            for (size_t i = 0; i < layouts[n].size(); i++) {
+                px_[offsets_[n] + i] = layouts[n].nx[i];
+                py_[offsets_[n] + i] = layouts[n].ny[i];
+                hub_of_[offsets_[n] + i] = hub;
+            }
+        }
+        // ideal edge length for n bodies in the unit square
+        const float k = 0.5f * std::sqrt(1.0f / std::max<size_t>(bodies, 1));
+        k2_ = k * k;
+        temperature_ = 0.05f;
+        iteration_ = 0;
+    }
+
+    size_t size() const { return px_.size(); }
+    int iteration() const { return iteration_; }
+    bool converged() const { return temperature_ < 1e-4f; }
+
+    void step() {
+        if (px_.empty()) return;
+        const size_t bodies = px_.size();
+        std::fill(dx_.begin(), dx_.end(), 0.0f);
+        std::fill(dy_.begin(), dy_.end(), 0.0f);
+
+        build_tree();
+        for (uint32_t b = 0; b < bodies; b++) repulse(b);
+
+        // springs to the hub (d^2 / k), pulling both ends
+        const float inv_k = 1.0f / std::sqrt(k2_);
+        for (uint32_t b = 0; b < bodies; b++) {
+            const uint32_t hub = hub_of_[b];
+            if (hub == b) continue;
+            const float ddx = px_[b] - px_[hub], ddy = py_[b] - py_[hub];
+            const float d = std::sqrt(ddx * ddx + ddy * ddy);
+            const float scale = d * inv_k;
+            dx_[b] -= ddx * scale;
+            dy_[b] -= ddy * scale;
+            dx_[hub] += ddx * scale;
+            dy_[hub] += ddy * scale;
+        }
+
+        // weak gravity keeps disconnected networks on screen
+        for (uint32_t b = 0; b < bodies; b++) {
+            dx_[b] -= (px_[b] - 0.5f) * 0.01f;
+            dy_[b] -= (py_[b] - 0.5f) * 0.01f;
+        }
+
+        // move, capped by the temperature
+        for (uint32_t b = 0; b < bodies; b++) {
+            const float d = std::sqrt(dx_[b] * dx_[b] + dy_[b] * dy_[b]);
+            if (d <= 0) continue;
+            const float limited = std::min(d, temperature_) / d;
+            px_[b] += dx_[b] * limited;
+            py_[b] += dy_[b] * limited;
+        }
+        temperature_ *= 0.97f;
+        iteration_++;
+    }
+
+    // Copy positions out, fitted into the widget with a small margin
+    void write(std::vector<RingLayout> &layouts) const {
+        if (px_.empty()) return;
+        const auto [x0, x1] = std::minmax_element(px_.begin(), px_.end());
+        const auto [y0, y1] = std::minmax_element(py_.begin(), py_.end());
+        const float span = std::max({*x1 - *x0, *y1 - *y0, 1e-6f});
+        const float scale = 0.9f / span;
+        const float ox = 0.5f - (*x0 + *x1) / 2 * scale, oy = 0.5f - (*y0 + *y1) / 2 * scale;
+
+        const size_t devices = px_.size() - layouts.size();
+        for (size_t n = 0; n < layouts.size(); n++) {
+            RingLayout &layout = layouts[n];
+            const size_t hub = devices + n;
+            layout.center_nx = px_[hub] * scale + ox;
+            layout.center_ny = py_[hub] * scale + oy;
+            float spread = 0;
+            for (size_t i = 0; i < layout.size(); i++) {
+                layout.nx[i] = px_[offsets_[n] + i] * scale + ox;
+                layout.ny[i] = py_[offsets_[n] + i] * scale + oy;
+                spread += std::hypot(layout.nx[i] - layout.center_nx, layout.ny[i] - layout.center_ny);
+            }
+            // group rings are drawn at the average device distance
+            layout.radius = layout.size() ? spread / layout.size() : layout.radius;
+        }
+    }
+};
+
+// Initial (non-iterative) positions for some of the widget's networks:
+// networks[n] takes cell index[n] of a grid tiled for `total` networks, so
+// one network can be laid out again without touching the others
+inline std::vector<RingLayout> layout_static(LayoutKind kind, const std::vector<LayoutNetwork> &networks,
+                                             const std::vector<uint32_t> &index, size_t total) {
+    std::vector<RingLayout> tiles, layouts(networks.size());
+    tile_networks(total, tiles);
+    for (size_t n = 0; n < networks.size(); n++) {
+        layouts[n] = tiles[index[n]];
+        switch (kind) {
+            case LayoutKind::RadialSubnet: layout_radial(networks[n], layouts[n]); break;
+            case LayoutKind::Hierarchical: layout_hierarchical(networks[n], layouts[n]); break;
+            default:                       layouts[n].compute_ring(networks[n].size()); break;
+        }
+    }
+    return layouts;
+}
+
+// Positions for a request covering every network
+inline std::vector<RingLayout> layout_static(LayoutKind kind, const std::vector<LayoutNetwork> &networks) {
+    std::vector<uint32_t> index(networks.size());
+    for (size_t n = 0; n < index.size(); n++) index[n] = static_cast<uint32_t>(n);
+    return layout_static(kind, networks, index, networks.size());
+}
+
+// Runs layouts on a background thread. Each submit() supersedes the previous
+// request; the force layout streams a frame every kFrameInterval so the UI can
+// animate, and finishes with a frame marked final. Frames are picked up on the
+// UI thread with drain_frames() after the notify callback fires.
+class LayoutWorker {
+private:
+    static constexpr auto kFrameInterval = std::chrono::milliseconds(50);
+    static constexpr int kMaxIterations = 300;
+
+    struct Job {
+        uint64_t generation;
+        LayoutKind kind;
+        std::vector<LayoutNetwork> networks;
+        std::vector<uint32_t> index;
+        size_t total;
+    };
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::optional<Job> pending_;
+    bool stopping_ = false;
+    std::atomic<uint64_t> generation_{0};
+
+    MpscQueue<LayoutFrame> frames_;
+    std::function<void()> notify_;
+    std::atomic<bool> notify_pending_{false};
+    std::thread thread_;
+
+    bool superseded(uint64_t generation) const {
+        return generation != generation_.load(std::memory_order_acquire);
+    }
+
+    void emit(LayoutFrame frame) {
+        frames_.push(std::move(frame));
+        if (notify_ && !notify_pending_.exchange(true, std::memory_order_acq_rel)) {
+            notify_();
+        }
+    }
+
+    void run_job(Job &job) {
+        std::vector<RingLayout> layouts = layout_static(job.kind, job.networks, job.index, job.total);
+        if (job.kind != LayoutKind::ForceDirected) {
+            emit(LayoutFrame{job.generation, true, std::move(layouts), std::move(job.index), job.total});
+            return;
+        }
+
+        // keep positions the user has already seen where possible
+        for (size_t n = 0; n < layouts.size(); n++) {
+            if (job.networks[n].nx.size() == layouts[n].size()) {
+                layouts[n].nx = job.networks[n].nx;
+                layouts[n].ny = job.networks[n].ny;
+            }
+        }
+
+        ForceLayout force;
+        force.init(layouts);
+        auto last_frame = std::chrono::steady_clock::now();
+        while (!force.converged() && force.iteration() < kMaxIterations) {
+            if (superseded(job.generation)) return;
+            force.step();
+            auto now = std::chrono::steady_clock::now();
+            if (now - last_frame >= kFrameInterval) {
+                force.write(layouts);
+                emit(LayoutFrame{job.generation, false, layouts, job.index, job.total});
+                last_frame = now;
+            }
+        }
+        force.write(layouts);
+        emit(LayoutFrame{job.generation, true, std::move(layouts), std::move(job.index), job.total});
+    }
+
+    void run() {
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stopping_ || pending_.has_value(); });
+                if (stopping_) return;
+                job = std::move(*pending_);
+                pending_.reset();
+            }
+            run_job(job);
+        }
+    }
+
+public:
+    LayoutWorker() : thread_([this] { run(); }) {}
+
+    ~LayoutWorker() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        generation_.fetch_add(1, std::memory_order_acq_rel);
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    LayoutWorker(const LayoutWorker&) = delete;
+    LayoutWorker& operator=(const LayoutWorker&) = delete;
+
+    // Called from the worker thread whenever frames become available
+    void set_notify(std::function<void()> notify) {
+        notify_ = std::move(notify);
+    }
+
+    // Queue a layout of the networks at `index` out of `total`, cancelling
+    // whatever is running; returns its generation. The force layout moves
+    // every network together, so its requests must cover all of them
+    uint64_t submit(LayoutKind kind, std::vector<LayoutNetwork> networks, std::vector<uint32_t> index, size_t total) {
+        const uint64_t generation = generation_.fetch_add(1, std::memory_order_acq_rel) + 1;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_ = Job{generation, kind, std::move(networks), std::move(index), total};
+        }
+        cv_.notify_one();
+        return generation;
+    }
+
+    // Hand the newest frame of the current generation to fn, dropping stale
+    // and superseded ones. Returns false when there was nothing to apply.
+    bool drain_frames(const std::function<void(LayoutFrame&&)> &fn) {
+        notify_pending_.store(false, std::memory_order_release);
+        std::optional<LayoutFrame> latest;
+        while (auto frame = frames_.pop()) {
+            if (frame->generation == generation_.load(std::memory_order_acquire)) latest = std::move(frame);
+        }
+        if (!latest) return false;
+        fn(std::move(*latest));
+        return true;
+    }
+};
+
+#endif // LAYOUT_ENGINE_HPP
@@ -1,6 +1,12 @@
 #include "graphics.hpp"
 
 int main (int argc, char *argv[]) {
+    // Headless imports moved to the command line tool
+    if (argc > 1 && std::string(argv[1]) == "--import") {
+        std::cerr << "Error: --import was removed; use nmapvis_cli import [--jobs N] <file.xml | directory>..." << std::endl;
+        return 1;
+    }
+
     try {
         std::locale::global(std::locale(""));
     } catch (const std::exception &e) {
@@ -0,0 +1,228 @@
+#ifndef MONITOR_HPP
+#define MONITOR_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "utils.hpp"
+#include "diff.hpp"
+#include "scan_session.hpp"
+
+/*
+Continuous monitoring: each target is rescanned on its own interval by a
+dedicated ParallelScanner, every pass is diffed against the network as it was
+stored when the pass started, and the outcome goes into a rolling history.
+
+The next pass is scheduled from the end of the previous one, stretched or
+shrunk at random by up to `jitter`, so targets added together drift apart
+instead of hitting the worker pool in bursts. Resource use is capped by the
+worker count (nmap processes at once), the number of targets in flight, the
+nice level of the nmap processes and the profile's --max-rate.
+
+Monitor is not thread-safe: it is driven from one consumer thread (the GTK
+main loop, or the CLI loop) through poll().
+*/
+
+// Light profile for unattended rescans: top 100 ports, normal timing, rate cap
+inline ScanProfile monitor_profile() {
+    ScanProfile profile;
+    profile.name = "Monitor";
+    profile.timing = 3;
+    profile.fast = true;
+    profile.max_rate = 500;
+    profile.stats_every = 0;
+    return profile;
+}
+
+struct MonitorSettings {
+    size_t workers = 1;           // scanner threads, i.e. nmap processes at once
+    size_t max_running = 1;       // targets with a pass in flight at once
+    int niceness = 10;            // nice level of the nmap processes
+    double jitter = 0.1;          // intervals vary by up to this fraction either way
+    size_t history = 200;         // completed passes kept, oldest dropped first
+    int64_t ttl_seconds = 86400;  // incremental passes re-probe hosts last scanned before this
+    ScanProfile profile = monitor_profile();
+};
+
+// One completed pass over a target
+struct MonitorRun {
+    std::string target;
+    int64_t started = 0;   // unix seconds
+    int64_t finished = 0;
+    size_t hosts = 0;      // hosts seen up
+    bool cancelled = false;
+    bool baseline = false; // the network was stored before the pass, so the diff means something
+    NetworkDiff diff;
+
+    // Hosts appeared or disappeared, or a port changed state or service
+    bool alert() const {
+        if (!baseline || cancelled) return false;
+        if (diff.added || diff.removed) return true;
+        return std::any_of(diff.hosts.begin(), diff.hosts.end(), [](const HostDiff& host) { return !host.ports.empty(); });
+    }
+};
+
+struct MonitorTargetInfo {
+    std::string target;
+    int64_t interval_seconds = 0;
+    int64_t next_run = 0;  // unix seconds; meaningless while running
+    bool running = false;
+    size_t passes = 0;
+};
+
+class Monitor {
+private:
+    // Passes that start together are spread over at most this many seconds
+    static constexpr int64_t kMaxStaggerSeconds = 60;
+
+    struct Target {
+        int64_t interval_seconds = 0;
+        int64_t next_run = 0;
+        size_t passes = 0;
+        int64_t started = 0;  // of the current pass
+    };
+
+    MonitorSettings settings_;
+    ParallelScanner scanner_;
+    ScanSession session_{scanner_};  // passes in flight
+    std::map<std::string, Target> targets_;
+    std::deque<MonitorRun> history_;
+    std::mt19937_64 random_;
+
+    int64_t stagger(int64_t interval_seconds) {
+        const double limit = std::min<double>(kMaxStaggerSeconds, interval_seconds * settings_.jitter);
+        return static_cast<int64_t>(std::uniform_real_distribution<double>(0.0, std::max(0.0, limit))(random_));
+    }
+
+    int64_t jittered(int64_t interval_seconds) {
+        std::uniform_real_distribution<double> spread(1.0 - settings_.jitter, 1.0 + settings_.jitter);
+        return std::max<int64_t>(1, std::llround(interval_seconds * spread(random_)));
+    }
+
+    // Known networks get an incremental pass; new ones a full sharded scan
+    void start(const std::string &name, Target &target, int64_t now) {
+        target.started = now;
+        session_.start(name, true, settings_.ttl_seconds);
+        std::clog << "Monitor pass " << target.passes + 1 << " of " << name << std::endl;
+    }
+
+    MonitorRun finish(Target &target, ScanRunResult &&result, int64_t now) {
+        MonitorRun run;
+        run.target = std::move(result.target);
+        run.started = target.started;
+        run.finished = now;
+        run.hosts = result.hosts;
+        run.cancelled = result.cancelled;
+        run.baseline = result.baseline;
+        run.diff = std::move(result.diff);
+
+        target.passes++;
+        target.next_run = now + jittered(target.interval_seconds);
+
+        history_.push_back(run);
+        while (history_.size() > settings_.history) history_.pop_front();
+        return run;
+    }
+
+public:
+    explicit Monitor(MonitorSettings settings = {})
+        : settings_(std::move(settings)), scanner_(std::max<size_t>(1, settings_.workers)), random_(std::random_device{}()) {
+        scanner_.set_profile(settings_.profile);
+        scanner_.set_niceness(settings_.niceness);
+    }
+
+    Monitor(const Monitor&) = delete;
+    Monitor& operator=(const Monitor&) = delete;
+
+    const MonitorSettings& settings() const { return settings_; }
+
+    // Called from scanner threads when results are waiting; the consumer should poll()
+    void set_notify(std::function<void()> notify) { scanner_.set_notify(std::move(notify)); }
+
+    void set_nmap_path(const std::string &nmap_path) { scanner_.set_nmap_path(nmap_path); }
+
+    // Monitor a target (an nmap target, also the network it is stored under).
+    // The first pass starts within a short random delay; adding a target
+    // again only changes its interval
+    void add_target(const std::string &name, int64_t interval_seconds, int64_t now) {
+        interval_seconds = std::max<int64_t>(1, interval_seconds);
+        auto [it, added] = targets_.try_emplace(name);
+        it->second.interval_seconds = interval_seconds;
+        if (added) it->second.next_run = now + stagger(interval_seconds);
+    }
+
+    // Stop monitoring a target, cancelling its pass in flight
+    bool remove_target(const std::string &name) {
+        auto it = targets_.find(name);
+        if (it == targets_.end()) return false;
+        session_.cancel(name);
+        targets_.erase(it);
+        return true;
+    }
+
+    void clear() {
+        scanner_.cancel_all();
+        session_.clear();
+        targets_.clear();
+    }
+
+    bool empty() const { return targets_.empty(); }
+
+    std::vector<MonitorTargetInfo> targets() const {
+        std::vector<MonitorTargetInfo> result;
+        for (const auto& [name, target] : targets_) {
+            result.push_back(MonitorTargetInfo{name, target.interval_seconds, target.next_run, session_.running(name), target.passes});
+        }
+        return result;
+    }
+
+    // When the next idle target is due (unix seconds), 0 when none is waiting
+    int64_t next_due() const {
+        int64_t due = 0;
+        for (const auto& [name, target] : targets_) {
+            if (!session_.running(name) && (due == 0 || target.next_run < due)) due = target.next_run;
+        }
+        return due;
+    }
+
+    // Completed passes, oldest first
+    const std::deque<MonitorRun>& history() const { return history_; }
+
+    ScannerStats stats() { return scanner_.stats(); }
+
+    // Store the hosts found since the last call, finish completed passes and
+    // start the due ones. on_saved sees each network as soon as its hosts are
+    // stored. Returns the passes completed by this call
+    std::vector<MonitorRun> poll(int64_t now, const std::function<void(const NetworkData&)> &on_saved = {}) {
+        std::vector<MonitorRun> finished;
+        for (auto& result : session_.poll(on_saved)) {
+            auto target = targets_.find(result.target);
+            if (target != targets_.end()) finished.push_back(finish(target->second, std::move(result), now));
+        }
+
+        // Longest-waiting targets first, as long as there is a free slot
+        size_t running = 0;
+        std::vector<std::map<std::string, Target>::iterator> due;
+        for (auto it = targets_.begin(); it != targets_.end(); ++it) {
+            if (session_.running(it->first)) running++;
+            else if (it->second.next_run <= now) due.push_back(it);
+        }
+        std::sort(due.begin(), due.end(), [](const auto& a, const auto& b) { return a->second.next_run < b->second.next_run; });
+        for (auto it : due) {
+            if (running >= std::max<size_t>(1, settings_.max_running)) break;
+            start(it->first, it->second, now);
+            running++;
+        }
+        return finished;
+    }
+};
+
+#endif // MONITOR_HPP
@@ -0,0 +1,277 @@
+#ifndef PERSISTENT_HPP
+#define PERSISTENT_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/*
+Copy-on-write containers behind the store's snapshots. Copying one shares
+every node with the original; a writer copies only the nodes on the path to
+what it changes, so publishing a network after a small batch costs
+O(batch * log n) instead of O(n).
+
+Writes take a Transaction. Nodes created under a transaction are changed in
+place when it writes again, so a large batch does not copy the same path over
+and over. Once the containers are published the transaction must not write to
+them any more; a new one copies whatever it touches.
+*/
+namespace persistent {
+
+class Transaction {
+public:
+    Transaction() : id_(counter().fetch_add(1, std::memory_order_relaxed)) {}
+
+    Transaction(const Transaction&) = delete;
+    Transaction& operator=(const Transaction&) = delete;
+
+    uint64_t id() const { return id_; }
+
+private:
+    uint64_t id_;
+
+    static std::atomic<uint64_t>& counter() {
+        static std::atomic<uint64_t> next{1};  // 0 marks nodes no transaction may edit
+        return next;
+    }
+};
+
+namespace detail {
+
+constexpr unsigned kBits = 5;
+constexpr size_t kWidth = size_t{1} << kBits;
+constexpr size_t kMask = kWidth - 1;
+
+// Copy a node the transaction does not own yet; owned nodes are returned as is
+template <typename Node>
+Node& editable(std::shared_ptr<Node> &slot, const Transaction &tx) {
+    if (!slot) {
+        slot = std::make_shared<Node>();
+        slot->edit = tx.id();
+    } else if (slot->edit != tx.id()) {
+        auto copy = std::make_shared<Node>(*slot);
+        copy->edit = tx.id();
+        slot = std::move(copy);
+    }
+    return *slot;
+}
+
+} // namespace detail
+
+// Indexed sequence: a 32-way trie over the index, with leaves of 32 values
+template <typename T>
+class Vector {
+private:
+    struct Node {
+        uint64_t edit = 0;
+        std::vector<std::shared_ptr<Node>> children;  // branches
+        std::vector<T> values;                        // leaves
+    };
+
+    std::shared_ptr<Node> root_;
+    unsigned shift_ = 0;  // levels above the leaves, times kBits
+    size_t size_ = 0;
+
+    const Node& leaf(size_t index) const {
+        const Node* node = root_.get();
+        for (unsigned shift = shift_; shift > 0; shift -= detail::kBits) {
+            node = node->children[(index >> shift) & detail::kMask].get();
+        }
+        return *node;
+    }
+
+    // Editable leaf for index, creating missing nodes on the way
+    Node& editable_leaf(size_t index, const Transaction &tx) {
+        Node* node = &detail::editable(root_, tx);
+        for (unsigned shift = shift_; shift > 0; shift -= detail::kBits) {
+            if (node->children.empty()) node->children.resize(detail::kWidth);
+            node = &detail::editable(node->children[(index >> shift) & detail::kMask], tx);
+        }
+        return *node;
+    }
+
+public:
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() = default;
+        const_iterator(const Vector* vector, size_t index) : vector_(vector), index_(index) {}
+
+        reference operator*() const {
+            if (!leaf_) leaf_ = &vector_->leaf(index_);
+            return leaf_->values[index_ & detail::kMask];
+        }
+        pointer operator->() const { return &**this; }
+
+        const_iterator& operator++() {
+            index_++;
+            if ((index_ & detail::kMask) == 0) leaf_ = nullptr;
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const const_iterator &other) const { return index_ == other.index_; }
+        bool operator!=(const const_iterator &other) const { return index_ != other.index_; }
+
+    private:
+        const Vector* vector_ = nullptr;
+        size_t index_ = 0;
+        mutable const Node* leaf_ = nullptr;  // leaf holding index_, looked up once per 32 values
+    };
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    const T& operator[](size_t index) const { return leaf(index).values[index & detail::kMask]; }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size_); }
+
+    void set(size_t index, T value, const Transaction &tx) {
+        editable_leaf(index, tx).values[index & detail::kMask] = std::move(value);
+    }
+
+    void push_back(T value, const Transaction &tx) {
+        // Full trie: the old root becomes the first child of a new one
+        if (root_ && size_ == (detail::kWidth << shift_)) {
+            auto root = std::make_shared<Node>();
+            root->edit = tx.id();
+            root->children.resize(detail::kWidth);
+            root->children[0] = std::move(root_);
+            root_ = std::move(root);
+            shift_ += detail::kBits;
+        }
+        Node& node = editable_leaf(size_, tx);
+        if (node.values.capacity() < detail::kWidth) node.values.reserve(detail::kWidth);
+        node.values.push_back(std::move(value));
+        size_++;
+    }
+};
+
+// Hash map: a trie over 5-bit slices of the (remixed) hash, with buckets of
+// up to kBucket entries that split into a branch when they overflow
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class Map {
+private:
+    static constexpr size_t kBucket = 8;
+    static constexpr unsigned kMaxDepth = 64 / detail::kBits;  // past this, buckets only grow
+
+    struct Node {
+        uint64_t edit = 0;
+        std::vector<std::shared_ptr<Node>> children;  // non-empty for branches
+        std::vector<std::pair<Key, Value>> entries;   // buckets
+    };
+
+    std::shared_ptr<Node> root_;
+    size_t size_ = 0;
+
+    // Spread the bits: std::hash of an integer is the identity on common libraries
+    static uint64_t hash_of(const Key &key) {
+        uint64_t x = static_cast<uint64_t>(Hash()(key));
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9ull;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    static size_t slot(uint64_t hash, unsigned depth) { return (hash >> (depth * detail::kBits)) & detail::kMask; }
+
+public:
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    const Value* find(const Key &key) const {
+        const uint64_t hash = hash_of(key);
+        const Node* node = root_.get();
+        for (unsigned depth = 0; node; depth++) {
+            if (node->children.empty()) {
+                for (const auto& entry : node->entries) {
+                    if (entry.first == key) return &entry.second;
+                }
+                return nullptr;
+            }
+            node = node->children[slot(hash, depth)].get();
+        }
+        return nullptr;
+    }
+
+    bool contains(const Key &key) const { return find(key) != nullptr; }
+
+    // Insert or overwrite
+    void assign(const Key &key, Value value, const Transaction &tx) {
+        const uint64_t hash = hash_of(key);
+        std::shared_ptr<Node>* link = &root_;
+        for (unsigned depth = 0;; depth++) {
+            Node& node = detail::editable(*link, tx);
+            if (!node.children.empty()) {
+                link = &node.children[slot(hash, depth)];
+                continue;
+            }
+            for (auto& entry : node.entries) {
+                if (entry.first == key) {
+                    entry.second = std::move(value);
+                    return;
+                }
+            }
+            if (node.entries.size() < kBucket || depth >= kMaxDepth) {
+                node.entries.emplace_back(key, std::move(value));
+                size_++;
+                return;
+            }
+            // Split the full bucket by the next slice of the hash, then retry one level down
+            std::vector<std::pair<Key, Value>> entries = std::move(node.entries);
+            node.entries.clear();
+            node.children.resize(detail::kWidth);
+            for (auto& entry : entries) {
+                detail::editable(node.children[slot(hash_of(entry.first), depth)], tx).entries.push_back(std::move(entry));
+            }
+            link = &node.children[slot(hash, depth)];
+        }
+    }
+
+    // Insert unless present; false when the key was already there
+    bool insert(const Key &key, Value value, const Transaction &tx) {
+        if (contains(key)) return false;
+        assign(key, std::move(value), tx);
+        return true;
+    }
+
+    bool erase(const Key &key, const Transaction &tx) {
+        if (!contains(key)) return false;
+        const uint64_t hash = hash_of(key);
+        std::shared_ptr<Node>* link = &root_;
+        for (unsigned depth = 0;; depth++) {
+            Node& node = detail::editable(*link, tx);
+            if (!node.children.empty()) {
+                link = &node.children[slot(hash, depth)];
+                continue;
+            }
+            for (size_t i = 0; i < node.entries.size(); i++) {
+                if (node.entries[i].first != key) continue;
+                node.entries[i] = std::move(node.entries.back());
+                node.entries.pop_back();
+                size_--;
+                return true;
+            }
+            return false;
+        }
+    }
+};
+
+} // namespace persistent
+
+#endif // PERSISTENT_HPP
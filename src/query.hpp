@@ -0,0 +1,425 @@
+#ifndef QUERY_HPP
+#define QUERY_HPP
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <cstdint>
+#if __has_include(<bit>)
+#include <bit>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "globals.hpp"
+#include "store.hpp"
+
+/*
+Host filter language: whitespace-separated terms, all of which must match.
+
+  port:22  port:53/udp       host has that port in the selected state
+  service:ssh                a port in the selected state runs a service starting with "ssh"
+  state:open                 state for port/service terms (default open); alone: any port in it
+  os:linux  vendor:cisco  host:printer
+                             field starts with the value (case-insensitive)
+  net:10.1.0.0/16  ip:10.1.2.3
+  fe80::1  2001:db8::/32     bare IPv6 address or network, same as ip: / net:
+  printer                    bare word: ip, vendor, os, hostname or service contains it
+
+"field:~value" matches anywhere in the field instead of at the start, and a
+leading "-" negates a term ("-port:23").
+*/
+
+enum class QueryField : uint8_t { Port, State, Service, Os, Vendor, Host, Net, Ip, Text };
+
+struct QueryTerm {
+    QueryField field = QueryField::Text;
+    bool negate = false;
+    bool substring = false;
+    std::string value;                      // lowercased
+    uint16_t port = 0;
+    Protocol protocol = Protocol::Unknown;  // Unknown matches any protocol
+    PortState state = PortState::Unknown;
+    IpAddress address;
+    int prefix = 0;                         // net: prefix length in bits
+    std::vector<uint8_t> ids;               // interned string id -> matches, filled per evaluation
+};
+
+namespace query_detail {
+
+// ASCII only: nmap's vendor, OS and service strings are plain ASCII
+inline char fold(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+inline std::string lower(std::string_view text) {
+    std::string result(text);
+    for (char& c : result) c = fold(c);
+    return result;
+}
+
+// needle is already lowercase
+inline bool icontains(std::string_view haystack, std::string_view needle, bool at_start) {
+    if (needle.size() > haystack.size()) return false;
+    const size_t last = at_start ? 0 : haystack.size() - needle.size();
+    for (size_t i = 0; i <= last; i++) {
+        if (fold(haystack[i]) != needle[0]) continue;
+        size_t j = 1;
+        while (j < needle.size() && fold(haystack[i + j]) == needle[j]) j++;
+        if (j == needle.size()) return true;
+    }
+    return false;
+}
+
+// Index of the lowest set bit; bits must not be 0
+inline unsigned lowest_bit(uint64_t bits) {
+#if defined(__cpp_lib_bitops)
+    return static_cast<unsigned>(std::countr_zero(bits));
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<unsigned>(index);
+#elif defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctzll(bits));
+#else
+    // De Bruijn multiply on the isolated bit
+    static constexpr unsigned char kIndex[64] = {
+        0,  1,  2,  53, 3,  7,  54, 27, 4,  38, 41, 8,  34, 55, 48, 28,
+        62, 5,  39, 46, 44, 42, 22, 9,  24, 35, 59, 56, 49, 18, 29, 11,
+        63, 52, 6,  26, 37, 40, 33, 47, 61, 45, 43, 21, 23, 58, 17, 10,
+        51, 25, 36, 32, 60, 20, 57, 16, 50, 31, 19, 15, 30, 14, 13, 12};
+    return kIndex[((bits & (~bits + 1)) * 0x022FDD63CC95386Dull) >> 58];
+#endif
+}
+
+inline bool is_field(const std::string &name) {
+    static const char* const kFields[] = {"port", "state", "service", "os", "vendor", "host", "net", "ip"};
+    return std::find(std::begin(kFields), std::end(kFields), name) != std::end(kFields);
+}
+
+inline uint32_t port_key(uint16_t port, Protocol protocol) {
+    return (static_cast<uint32_t>(protocol) << 16) | port;
+}
+
+inline bool in_prefix(const IpAddress &ip, const IpAddress &network, int prefix) {
+    if (ip.family != network.family) return false;
+    const int full = prefix / 8, rest = prefix % 8;
+    for (int i = 0; i < full; i++) {
+        if (ip.bytes[i] != network.bytes[i]) return false;
+    }
+    if (rest == 0) return true;
+    const uint8_t mask = static_cast<uint8_t>(0xFF << (8 - rest));
+    return (ip.bytes[full] & mask) == (network.bytes[full] & mask);
+}
+
+} // namespace query_detail
+
+class Query {
+public:
+    std::vector<QueryTerm> terms;
+    PortState port_state = PortState::Open;  // state port/service terms require
+    bool ports_constrained = false;           // any port or service term present
+
+    bool empty() const { return terms.empty(); }
+
+    // Throws std::invalid_argument with a message fit for the status bar
+    static Query parse(std::string_view text) {
+        Query query;
+        bool explicit_state = false;
+        size_t at = 0;
+        while (at < text.size()) {
+            while (at < text.size() && std::isspace(static_cast<unsigned char>(text[at]))) at++;
+            size_t end = at;
+            while (end < text.size() && !std::isspace(static_cast<unsigned char>(text[end]))) end++;
+            if (end == at) break;
+            std::string_view token = text.substr(at, end - at);
+            at = end;
+
+            QueryTerm term;
+            if (token.size() > 1 && token.front() == '-') {
+                term.negate = true;
+                token.remove_prefix(1);
+            }
+            const size_t colon = token.find(':');
+            std::string field = colon == std::string_view::npos ? std::string() : query_detail::lower(token.substr(0, colon));
+            std::string_view value = colon == std::string_view::npos ? token : token.substr(colon + 1);
+            if (colon != std::string_view::npos && !query_detail::is_field(field)) {
+                // Not a field prefix: an IPv6 address or network ("::1", "fe80::/10"), else plain text
+                const std::string_view address = token.substr(0, token.find('/'));
+                const bool parses = IpAddress::parse(std::string(address)).valid();
+                field = !parses ? "" : address.size() == token.size() ? "ip" : "net";
+                value = token;
+            }
+            if (!value.empty() && value.front() == '~') {
+                term.substring = true;
+                value.remove_prefix(1);
+            }
+            if (value.empty()) throw std::invalid_argument("empty value in \"" + std::string(token) + "\"");
+            term.value = query_detail::lower(value);
+
+            if (field.empty()) {
+                term.field = QueryField::Text;
+                term.substring = true;
+            } else if (field == "port") {
+                term.field = QueryField::Port;
+                const size_t slash = term.value.find('/');
+                const std::string number = term.value.substr(0, slash);
+                if (number.empty() || number.size() > 5 || number.find_first_not_of("0123456789") != std::string::npos
+                    || std::stoi(number) > 65535) {
+                    throw std::invalid_argument("bad port \"" + std::string(value) + "\"");
+                }
+                term.port = static_cast<uint16_t>(std::stoi(number));
+                if (slash != std::string::npos) {
+                    term.protocol = parse_protocol(term.value.substr(slash + 1));
+                    if (term.protocol == Protocol::Unknown) throw std::invalid_argument("bad protocol in \"" + std::string(value) + "\"");
+                }
+                query.ports_constrained = true;
+            } else if (field == "state") {
+                term.field = QueryField::State;
+                term.state = parse_port_state(term.value);
+                if (term.state == PortState::Unknown) throw std::invalid_argument("bad port state \"" + std::string(value) + "\"");
+                if (!term.negate) {
+                    if (explicit_state && term.state != query.port_state) throw std::invalid_argument("only one state: term is allowed");
+                    query.port_state = term.state;
+                    explicit_state = true;
+                }
+            } else if (field == "service") {
+                term.field = QueryField::Service;
+                query.ports_constrained = true;
+            } else if (field == "os") {
+                term.field = QueryField::Os;
+            } else if (field == "vendor") {
+                term.field = QueryField::Vendor;
+            } else if (field == "host") {
+                term.field = QueryField::Host;
+            } else if (field == "ip" || field == "net") {
+                term.field = field == "ip" ? QueryField::Ip : QueryField::Net;
+                const size_t slash = term.value.find('/');
+                term.address = IpAddress::parse(term.value.substr(0, slash));
+                if (!term.address.valid()) throw std::invalid_argument("bad address \"" + std::string(value) + "\"");
+                const int bits = term.address.family == 4 ? 32 : 128;
+                term.prefix = bits;
+                if (slash != std::string::npos) {
+                    const std::string length = term.value.substr(slash + 1);
+                    if (length.empty() || length.size() > 3 || length.find_first_not_of("0123456789") != std::string::npos
+                        || std::stoi(length) > bits) {
+                        throw std::invalid_argument("bad prefix length in \"" + std::string(value) + "\"");
+                    }
+                    term.prefix = std::stoi(length);
+                }
+            }
+            query.terms.push_back(std::move(term));
+        }
+        return query;
+    }
+};
+
+// Matched records as the map and host list consume them (pointers into a snapshot)
+using HostSet = std::unordered_set<const DeviceInfo*>;
+
+// Hosts matched by a query, as indexes into HostIndex::devices (ascending)
+struct QueryResult {
+    std::vector<uint32_t> hosts;
+};
+
+// Columnar copy of a store snapshot with inverted indexes on ports, services
+// and port states. Build once per snapshot; queries only read it. Each term
+// becomes a bitmap over host ids, from a posting list or a column scan, and
+// the bitmaps are ANDed together.
+class HostIndex {
+public:
+    std::shared_ptr<const StoreSnapshot> snapshot;
+    std::vector<const DeviceInfo*> devices;      // host id -> record (owned by snapshot)
+    std::vector<uint32_t> network_of;            // host id -> index into snapshot->networks
+    std::vector<IpAddress> address;
+    std::vector<uint32_t> vendor, os, hostname;  // interned string ids
+
+    void build(std::shared_ptr<const StoreSnapshot> source) {
+        *this = HostIndex();
+        snapshot = std::move(source);
+        if (!snapshot) return;
+
+        const size_t total = snapshot->device_count();
+        devices.reserve(total);
+        network_of.reserve(total);
+        address.reserve(total);
+        vendor.reserve(total);
+        os.reserve(total);
+        hostname.reserve(total);
+
+        std::vector<uint8_t> seen(nmapVisualizerGlobals::strings.size(), 0);
+        // bit per column so a string used as both vendor and hostname lands in both lists
+        auto note = [&seen](std::vector<uint32_t> &values, uint32_t id, uint8_t column) {
+            if (id >= seen.size()) seen.resize(id + 1, 0);
+            if (!(seen[id] & column)) {
+                seen[id] |= column;
+                values.push_back(id);
+            }
+        };
+        auto post = [](std::vector<uint32_t> &list, uint32_t host) {
+            if (list.empty() || list.back() != host) list.push_back(host);
+        };
+
+        for (size_t n = 0; n < snapshot->networks.size(); n++) {
+            for (const auto& device : snapshot->networks[n]->devices) {
+                const uint32_t host = static_cast<uint32_t>(devices.size());
+                devices.push_back(device.get());
+                network_of.push_back(static_cast<uint32_t>(n));
+                address.push_back(device->ipAddress);
+                vendor.push_back(device->vendor.id());
+                os.push_back(device->operatingSystem.id());
+                hostname.push_back(device->deviceType.id());
+                note(vendor_values_, device->vendor.id(), 1);
+                note(os_values_, device->operatingSystem.id(), 2);
+                note(host_values_, device->deviceType.id(), 4);
+                for (const Port& port : device->ports) {
+                    post(ports_[state_key(query_detail::port_key(port.portNumber, port.protocol), port.state)], host);
+                    post(states_[static_cast<size_t>(port.state)], host);
+                    if (!port.service.empty()) {
+                        post(services_[state_key(port.service.id(), port.state)], host);
+                        note(service_values_, port.service.id(), 8);
+                    }
+                }
+            }
+        }
+    }
+
+    size_t size() const { return devices.size(); }
+
+    QueryResult evaluate(Query &query) const {
+        const size_t words = (devices.size() + 63) / 64;
+        Bitmap matched(words, ~uint64_t(0));
+        if (devices.size() % 64) matched.back() = (uint64_t(1) << (devices.size() % 64)) - 1;
+
+        Bitmap term_bits(words);
+        for (auto& term : query.terms) {
+            std::fill(term_bits.begin(), term_bits.end(), 0);
+            fill(term, query, term_bits);
+            for (size_t w = 0; w < words; w++) matched[w] &= term.negate ? ~term_bits[w] : term_bits[w];
+        }
+
+        QueryResult result;
+        for (size_t w = 0; w < words; w++) {
+            for (uint64_t bits = matched[w]; bits; bits &= bits - 1) {
+                result.hosts.push_back(static_cast<uint32_t>(w * 64 + query_detail::lowest_bit(bits)));
+            }
+        }
+        return result;
+    }
+
+private:
+    using Bitmap = std::vector<uint64_t>;
+    static constexpr size_t kStates = static_cast<size_t>(PortState::ClosedFiltered) + 1;
+
+    std::unordered_map<uint64_t, std::vector<uint32_t>> ports_;     // (port key, state) -> hosts
+    std::unordered_map<uint64_t, std::vector<uint32_t>> services_;  // (service id, state) -> hosts
+    std::array<std::vector<uint32_t>, kStates> states_;            // state -> hosts with a port in it
+    std::vector<uint32_t> vendor_values_, os_values_, host_values_, service_values_;  // distinct ids
+
+    static uint64_t state_key(uint32_t key, PortState state) {
+        return (static_cast<uint64_t>(key) << 8) | static_cast<uint8_t>(state);
+    }
+
+    static void set(Bitmap &bits, uint32_t host) { bits[host / 64] |= uint64_t(1) << (host % 64); }
+
+    static void set_all(Bitmap &bits, const std::vector<uint32_t>* hosts) {
+        if (hosts) for (uint32_t host : *hosts) set(bits, host);
+    }
+
+    template <typename Map, typename Key>
+    static const std::vector<uint32_t>* find(const Map &map, const Key &key) {
+        auto it = map.find(key);
+        return it == map.end() ? nullptr : &it->second;
+    }
+
+    // Mark the interned ids a string term accepts; only distinct values are compared
+    static void mark(QueryTerm &term, const std::vector<uint32_t> &values) {
+        for (uint32_t id : values) {
+            if (id < term.ids.size() && query_detail::icontains(nmapVisualizerGlobals::strings.get(id), term.value, !term.substring)) {
+                term.ids[id] = 1;
+            }
+        }
+    }
+
+    void scan(const QueryTerm &term, const std::vector<uint32_t> &column, Bitmap &bits) const {
+        for (uint32_t host = 0; host < column.size(); host++) {
+            const uint32_t id = column[host];
+            if (id < term.ids.size() && term.ids[id]) set(bits, host);
+        }
+    }
+
+    void fill(QueryTerm &term, const Query &query, Bitmap &bits) const {
+        term.ids.assign(nmapVisualizerGlobals::strings.size(), 0);
+        switch (term.field) {
+            case QueryField::Port:
+                for (Protocol protocol : {Protocol::Unknown, Protocol::Tcp, Protocol::Udp, Protocol::Sctp, Protocol::Ip}) {
+                    if (term.protocol != Protocol::Unknown && protocol != term.protocol) continue;
+                    set_all(bits, find(ports_, state_key(query_detail::port_key(term.port, protocol), query.port_state)));
+                }
+                break;
+            case QueryField::Service:
+                mark(term, service_values_);
+                for (uint32_t id : service_values_) {
+                    if (term.ids[id]) set_all(bits, find(services_, state_key(id, query.port_state)));
+                }
+                break;
+            case QueryField::State:
+                // With port/service terms the state only qualifies them
+                if (query.ports_constrained && !term.negate) {
+                    std::fill(bits.begin(), bits.end(), ~uint64_t(0));
+                } else {
+                    set_all(bits, &states_[static_cast<size_t>(term.state)]);
+                }
+                break;
+            case QueryField::Os:
+                mark(term, os_values_);
+                scan(term, os, bits);
+                break;
+            case QueryField::Vendor:
+                mark(term, vendor_values_);
+                scan(term, vendor, bits);
+                break;
+            case QueryField::Host:
+                mark(term, host_values_);
+                scan(term, hostname, bits);
+                break;
+            case QueryField::Ip:
+            case QueryField::Net:
+                for (uint32_t host = 0; host < address.size(); host++) {
+                    if (query_detail::in_prefix(address[host], term.address, term.prefix)) set(bits, host);
+                }
+                break;
+            case QueryField::Text:
+                mark(term, vendor_values_);
+                mark(term, os_values_);
+                mark(term, host_values_);
+                mark(term, service_values_);
+                scan(term, vendor, bits);
+                scan(term, os, bits);
+                scan(term, hostname, bits);
+                for (uint32_t id : service_values_) {
+                    if (!term.ids[id]) continue;
+                    for (size_t state = 0; state < kStates; state++) {
+                        set_all(bits, find(services_, state_key(id, static_cast<PortState>(state))));
+                    }
+                }
+                // Only words that could be part of an address pay for formatting it
+                if (term.value.find_first_not_of("0123456789abcdef.:") == std::string::npos) {
+                    for (uint32_t host = 0; host < address.size(); host++) {
+                        if (address[host].valid() && address[host].to_string().find(term.value) != std::string::npos) set(bits, host);
+                    }
+                }
+                break;
+        }
+    }
+};
+
+#endif // QUERY_HPP
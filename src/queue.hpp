@@ -0,0 +1,61 @@
+#ifndef QUEUE_HPP
+#define QUEUE_HPP
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+// Lock-free multi-producer / single-consumer queue (Vyukov style).
+// Any thread may push(); only one thread at a time may pop().
+template <typename T>
+class MpscQueue {
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        std::optional<T> value;
+    };
+
+    std::atomic<Node*> head_;   // producers append here
+    Node* tail_;                // consumer reads from here (always a stub node)
+
+public:
+    MpscQueue() {
+        Node* stub = new Node();
+        head_.store(stub, std::memory_order_relaxed);
+        tail_ = stub;
+    }
+
+    ~MpscQueue() {
+        while (pop()) {}
+        delete tail_;
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value) {
+        Node* node = new Node();
+        node->value.emplace(std::move(value));
+        Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // Returns an empty optional when nothing is ready yet
+    std::optional<T> pop() {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) return std::nullopt;
+
+        std::optional<T> result(std::move(next->value));
+        next->value.reset();
+        tail_ = next;
+        delete tail;
+        return result;
+    }
+
+    bool empty() const {
+        return tail_->next.load(std::memory_order_acquire) == nullptr;
+    }
+};
+
+#endif // QUEUE_HPP
@@ -0,0 +1,95 @@
+#ifndef SCAN_PROFILE_HPP
+#define SCAN_PROFILE_HPP
+
+#include <string>
+#include <vector>
+
+// nmap port specification: numbers, ranges and T:/U:/S: prefixes separated by commas
+inline bool valid_port_spec(const std::string &ports) {
+    if (ports.empty() || ports.front() == '-' || ports.front() == ',') return false;
+    for (char c : ports) {
+        const bool digit = c >= '0' && c <= '9';
+        if (!digit && c != ',' && c != '-' && c != ':' && c != 'T' && c != 'U' && c != 'S') return false;
+    }
+    return true;
+}
+
+// nmap options for a scan; turned into argv entries, never into a shell string
+struct ScanProfile {
+    std::string name = "Default";
+    int timing = -1;                 // -T0 .. -T5, -1 keeps nmap's default
+    std::string ports;               // -p argument, empty (or invalid) keeps nmap's default ports
+    bool fast = false;               // -F (top 100 ports) when no port list is given
+    bool service_detection = false;  // -sV
+    bool os_detection = false;       // -O, needs root
+    int min_rate = 0;                // --min-rate packets/s, 0 leaves it unset
+    int max_rate = 0;                // --max-rate packets/s, 0 leaves it unset
+    int stats_every = 5;             // --stats-every seconds for progress reports, 0 disables
+
+    std::vector<std::string> arguments() const {
+        std::vector<std::string> args;
+        if (timing >= 0 && timing <= 5) args.push_back("-T" + std::to_string(timing));
+        if (valid_port_spec(ports)) {
+            args.push_back("-p");
+            args.push_back(ports);
+        } else if (fast) {
+            args.push_back("-F");
+        }
+        if (service_detection) args.push_back("-sV");
+        if (os_detection) args.push_back("-O");
+        append_common(args);
+        return args;
+    }
+
+    // Ping sweep only (-sn) with the same timing, rate and progress reporting
+    std::vector<std::string> discovery_arguments() const {
+        std::vector<std::string> args = {"-sn"};
+        if (timing >= 0 && timing <= 5) args.push_back("-T" + std::to_string(timing));
+        append_common(args);
+        return args;
+    }
+
+    void append_common(std::vector<std::string> &args) const {
+        if (min_rate > 0) {
+            args.push_back("--min-rate");
+            args.push_back(std::to_string(min_rate));
+        }
+        if (max_rate > 0) {
+            args.push_back("--max-rate");
+            args.push_back(std::to_string(max_rate));
+        }
+        if (stats_every > 0) {
+            args.push_back("--stats-every");
+            args.push_back(std::to_string(stats_every) + "s");
+        }
+    }
+
+    // "Quick (-T4 -F --stats-every 5s)" for the status bar
+    std::string describe() const {
+        std::string text;
+        for (const auto& arg : arguments()) text += (text.empty() ? "" : " ") + arg;
+        return name + " (" + (text.empty() ? "nmap defaults" : text) + ")";
+    }
+};
+
+// Built-in profiles offered in the Scan Options menu
+inline const std::vector<ScanProfile>& scan_profiles() {
+    static const std::vector<ScanProfile> profiles = [] {
+        std::vector<ScanProfile> list(4);
+        list[0].name = "Quick";
+        list[0].timing = 4;
+        list[0].fast = true;
+        list[2].name = "Service Detection";
+        list[2].timing = 4;
+        list[2].service_detection = true;
+        list[3].name = "Thorough";
+        list[3].timing = 4;
+        list[3].ports = "1-65535";
+        list[3].service_detection = true;
+        list[3].os_detection = true;
+        return list;
+    }();
+    return profiles;
+}
+
+#endif // SCAN_PROFILE_HPP
@@ -0,0 +1,84 @@
+// scan_session.cpp
+#include "scan_session.hpp"
+
+void ScanSession::start(const std::string &target, bool incremental, int64_t ttl_seconds) {
+    Run& run = runs_[target];
+    if (run.pending.empty()) {
+        auto snapshot = nmapVisualizerGlobals::store.snapshot();
+        auto found = snapshot->by_cidr.find(target);
+        run.baseline = found == snapshot->by_cidr.end() ? nullptr : snapshot->networks[found->second];
+        run.seen.clear();
+        run.cancelled = false;
+    }
+    if (incremental && run.baseline) {
+        run.pending.insert(scanner_.add_incremental_scan(target, target, run.baseline, ttl_seconds));
+        return;
+    }
+    for (uint64_t id : scanner_.add_sharded_scan(target, target)) run.pending.insert(id);
+}
+
+bool ScanSession::cancel(const std::string &target) {
+    auto run = runs_.find(target);
+    if (run == runs_.end()) return false;
+    for (uint64_t id : run->second.pending) scanner_.cancel(id);
+    runs_.erase(run);
+    return true;
+}
+
+ScanRunResult ScanSession::finish(const std::string &target, Run &run) {
+    ScanRunResult result;
+    result.target = target;
+    result.hosts = run.seen.size();
+    result.cancelled = run.cancelled;
+    result.baseline = run.baseline != nullptr;
+    // A cancelled run did not see every host, so "gone" would be meaningless
+    if (result.baseline && !result.cancelled) {
+        NetworkData seen = make_network(target, run.seen);
+        result.diff = diff_networks(run.baseline.get(), &seen);
+    }
+    result.diff.cidr = target;
+    return result;
+}
+
+std::vector<ScanRunResult> ScanSession::poll(const std::function<void(const NetworkData&)> &on_saved,
+                                             const std::function<void(const ScanEvent&)> &on_event) {
+    std::map<std::string, std::vector<DeviceInfo>> hosts_by_cidr;
+    std::vector<ScanEvent> done;
+    scanner_.drain_events([&](ScanEvent&& event) {
+        auto run = runs_.find(event.cidr);
+        switch (event.kind) {
+            case ScanEvent::Kind::Host:
+                if (run != runs_.end()) run->second.seen.push_back(std::make_shared<const DeviceInfo>(*event.device));
+                hosts_by_cidr[event.cidr].push_back(std::move(*event.device));
+                break;
+            case ScanEvent::Kind::Alive:
+                // Unchanged hosts keep their stored record; only the diff needs them
+                if (run != runs_.end()) run->second.seen.insert(run->second.seen.end(), event.known.begin(), event.known.end());
+                break;
+            case ScanEvent::Kind::Progress:
+                if (on_event) on_event(event);
+                break;
+            default:  // Finished or Cancelled
+                if (on_event) on_event(event);
+                done.push_back(std::move(event));
+        }
+    });
+
+    // One save per network and drain keeps the store and database writes batched
+    for (auto& [cidr, devices] : hosts_by_cidr) {
+        auto snapshot = save_devices(std::move(devices), cidr);
+        const NetworkData* network = snapshot->find(cidr);
+        if (network && on_saved) on_saved(*network);
+    }
+
+    std::vector<ScanRunResult> finished;
+    for (const auto& event : done) {
+        auto run = runs_.find(event.cidr);
+        if (run == runs_.end() || !run->second.pending.erase(event.task_id)) continue;
+        if (event.kind == ScanEvent::Kind::Cancelled) run->second.cancelled = true;
+        if (!run->second.pending.empty()) continue;
+        finished.push_back(finish(run->first, run->second));
+        runs_.erase(run);
+    }
+    return finished;
+}
@@ -0,0 +1,77 @@
+#ifndef SCAN_SESSION_HPP
+#define SCAN_SESSION_HPP
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <cstdint>
+
+#include "utils.hpp"
+#include "diff.hpp"
+
+/*
+Bookkeeping shared by every frontend that drives a ParallelScanner (the GUI,
+nmapvis_cli scan and Monitor): which tasks belong to which target, what each
+target's network looked like before the run, and which hosts the run saw.
+
+poll() drains the scanner, stores the new hosts one batch per network and
+returns the runs whose last task just finished, diffed against that
+baseline. Like the scanner's consumer side, a session is used from one
+thread only.
+*/
+
+// One target once every task of its run is done
+struct ScanRunResult {
+    std::string target;
+    size_t hosts = 0;       // hosts seen up, new and unchanged
+    bool cancelled = false;
+    bool baseline = false;  // the network was stored before the run, so the diff means something
+    NetworkDiff diff;       // only filled in for complete runs with a baseline
+};
+
+class ScanSession {
+private:
+    struct Run {
+        std::shared_ptr<const NetworkData> baseline;
+        std::unordered_set<uint64_t> pending;
+        std::vector<std::shared_ptr<const DeviceInfo>> seen;
+        bool cancelled = false;
+    };
+
+    ParallelScanner &scanner_;
+    std::map<std::string, Run> runs_;
+
+    ScanRunResult finish(const std::string &target, Run &run);
+
+public:
+    explicit ScanSession(ParallelScanner &scanner) : scanner_(scanner) {}
+
+    ScanSession(const ScanSession&) = delete;
+    ScanSession& operator=(const ScanSession&) = delete;
+
+    // Scan a target (an nmap target, also the network it is stored under).
+    // Known networks get an incremental rescan when asked for, everything
+    // else a sharded full scan. Starting a target that is still running adds
+    // its tasks to the same run
+    void start(const std::string &target, bool incremental = false, int64_t ttl_seconds = 86400);
+
+    // Cancel a target's tasks and forget its run
+    bool cancel(const std::string &target);
+
+    // Forget every run; the caller cancels the scanner's tasks
+    void clear() { runs_.clear(); }
+
+    bool running(const std::string &target) const { return runs_.count(target) != 0; }
+    bool empty() const { return runs_.empty(); }
+
+    // Drain the scanner: Progress, Finished and Cancelled events go to
+    // on_event first, new hosts are saved and each stored network is passed
+    // to on_saved. Returns the runs completed by this call
+    std::vector<ScanRunResult> poll(const std::function<void(const NetworkData&)> &on_saved = {},
+                                    const std::function<void(const ScanEvent&)> &on_event = {});
+};
+
+#endif // SCAN_SESSION_HPP
@@ -0,0 +1,121 @@
+#ifndef SPATIAL_HPP
+#define SPATIAL_HPP
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+
+// Uniform grid over 2D points for hit-testing and viewport culling.
+// Items are stored bucket-sorted by cell (CSR layout), so a rebuild is two
+// linear passes and a query only touches the cells overlapping its rectangle.
+class SpatialGrid {
+private:
+    struct Item {
+        uint32_t id;
+        float x, y;
+    };
+
+    double cell_size_ = 64.0;
+    double min_x_ = 0.0, min_y_ = 0.0;
+    int cols_ = 0, rows_ = 0;
+    std::vector<uint32_t> cell_start_;  // cols_*rows_ + 1 offsets into items_
+    std::vector<Item> items_;
+    std::vector<Item> pending_;
+
+    // Clamped before the cast: a double outside int's range does not convert
+    int cell_x(double x) const { return static_cast<int>(std::clamp((x - min_x_) / cell_size_, 0.0, double(cols_ - 1))); }
+    int cell_y(double y) const { return static_cast<int>(std::clamp((y - min_y_) / cell_size_, 0.0, double(rows_ - 1))); }
+
+public:
+    // Start a rebuild; cell_size should be about the size of what gets queried
+    void clear(double cell_size) {
+        cell_size_ = cell_size > 0.0 ? cell_size : 64.0;
+        pending_.clear();
+    }
+
+    void insert(uint32_t id, double x, double y) {
+        pending_.push_back(Item{id, static_cast<float>(x), static_cast<float>(y)});
+    }
+
+    // Bucket the inserted items; queries see nothing until this is called.
+    // Items at NaN or infinite positions cannot be placed and are dropped
+    void build() {
+        items_.clear();
+        cell_start_.clear();
+        cols_ = rows_ = 0;
+        pending_.erase(std::remove_if(pending_.begin(), pending_.end(), [](const Item& item) {
+            return !std::isfinite(item.x) || !std::isfinite(item.y);
+        }), pending_.end());
+        if (pending_.empty()) return;
+
+        double max_x = -std::numeric_limits<double>::infinity(), max_y = max_x;
+        min_x_ = min_y_ = std::numeric_limits<double>::infinity();
+        for (const auto& item : pending_) {
+            min_x_ = std::min<double>(min_x_, item.x);
+            min_y_ = std::min<double>(min_y_, item.y);
+            max_x = std::max<double>(max_x, item.x);
+            max_y = std::max<double>(max_y, item.y);
+        }
+
+        // Keep the cell count in the order of the item count for sparse layouts
+        const double max_cells = std::max<double>(16.0, pending_.size() * 4.0);
+        while (((max_x - min_x_) / cell_size_ + 1) * ((max_y - min_y_) / cell_size_ + 1) > max_cells) {
+            cell_size_ *= 2.0;
+        }
+        cols_ = static_cast<int>((max_x - min_x_) / cell_size_) + 1;
+        rows_ = static_cast<int>((max_y - min_y_) / cell_size_) + 1;
+
+        cell_start_.assign(static_cast<size_t>(cols_) * rows_ + 1, 0);
+        for (const auto& item : pending_) {
+            cell_start_[static_cast<size_t>(cell_y(item.y)) * cols_ + cell_x(item.x) + 1]++;
+        }
+        for (size_t i = 1; i < cell_start_.size(); i++) cell_start_[i] += cell_start_[i - 1];
+
+        items_.resize(pending_.size());
+        std::vector<uint32_t> fill(cell_start_.begin(), cell_start_.end() - 1);
+        for (const auto& item : pending_) {
+            items_[fill[static_cast<size_t>(cell_y(item.y)) * cols_ + cell_x(item.x)]++] = item;
+        }
+    }
+
+    size_t size() const { return items_.size(); }
+
+    // Call fn(id, x, y) for every item inside the rectangle
+    template <typename Fn>
+    void query_rect(double x0, double y0, double x1, double y1, Fn&& fn) const {
+        if (items_.empty() || !(x0 <= x1 && y0 <= y1)) return;  // also rejects NaN bounds
+        if (x1 < min_x_ || y1 < min_y_) return;
+        if (x0 > min_x_ + cols_ * cell_size_ || y0 > min_y_ + rows_ * cell_size_) return;
+
+        const int cx0 = cell_x(x0), cx1 = cell_x(x1);
+        const int cy0 = cell_y(y0), cy1 = cell_y(y1);
+        for (int cy = cy0; cy <= cy1; cy++) {
+            for (int cx = cx0; cx <= cx1; cx++) {
+                const size_t cell = static_cast<size_t>(cy) * cols_ + cx;
+                for (uint32_t i = cell_start_[cell]; i < cell_start_[cell + 1]; i++) {
+                    const Item& item = items_[i];
+                    if (item.x >= x0 && item.x <= x1 && item.y >= y0 && item.y <= y1) fn(item.id, item.x, item.y);
+                }
+            }
+        }
+    }
+
+    // Closest item within radius, or -1
+    int64_t nearest(double x, double y, double radius) const {
+        int64_t best = -1;
+        double best_d2 = radius * radius;
+        query_rect(x - radius, y - radius, x + radius, y + radius, [&](uint32_t id, double ix, double iy) {
+            const double dx = ix - x, dy = iy - y;
+            const double d2 = dx * dx + dy * dy;
+            if (d2 <= best_d2) {
+                best_d2 = d2;
+                best = id;
+            }
+        });
+        return best;
+    }
+};
+
+#endif // SPATIAL_HPP
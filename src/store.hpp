@@ -0,0 +1,137 @@
+#ifndef STORE_HPP
+#define STORE_HPP
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+#include "globals.hpp"
+#include "persistent.hpp"
+#include "trace.hpp"
+
+// One scanned network as seen by readers. Published snapshots are immutable;
+// writers copy the affected network, modify the copy and swap it in. The
+// containers are persistent, so that copy shares everything it does not touch.
+class NetworkData {
+public:
+    std::string cidr;
+    persistent::Vector<std::shared_ptr<const DeviceInfo>> devices;
+    persistent::Map<IpAddress, size_t, IpAddressHash> by_ip;     // ipAddress -> index into devices
+    persistent::Map<MacAddress, size_t, MacAddressHash> by_mac;  // macAddress -> index into devices
+
+    const DeviceInfo* find_ip(const IpAddress &ip) const {
+        const size_t* index = by_ip.find(ip);
+        return index ? devices[*index].get() : nullptr;
+    }
+
+    const DeviceInfo* find_mac(const MacAddress &mac) const {
+        const size_t* index = by_mac.find(mac);
+        return index ? devices[*index].get() : nullptr;
+    }
+};
+
+// Immutable view of every network at one point in time
+class StoreSnapshot {
+public:
+    std::vector<std::shared_ptr<const NetworkData>> networks;  // in first-seen order
+    std::unordered_map<std::string, size_t> by_cidr;           // cidr -> index into networks
+    uint64_t version = 0;
+
+    const NetworkData* find(const std::string &cidr) const {
+        auto it = by_cidr.find(cidr);
+        return it == by_cidr.end() ? nullptr : networks[it->second].get();
+    }
+
+    size_t device_count() const {
+        size_t count = 0;
+        for (const auto& network : networks) count += network->devices.size();
+        return count;
+    }
+};
+
+// Device store with upsert-on-rescan and lock-free snapshot reads: readers
+// grab the current shared_ptr and never wait for writers; writers serialize
+// among themselves and publish a new snapshot per batch.
+class NetworkStore {
+private:
+    std::shared_ptr<const StoreSnapshot> current_ = std::make_shared<StoreSnapshot>();
+    std::mutex write_mutex_;
+
+public:
+    std::shared_ptr<const StoreSnapshot> snapshot() const {
+        return std::atomic_load(&current_);
+    }
+
+    // Insert or replace devices in a network. A device replaces an existing
+    // entry with the same IP, or the same MAC when it has no usable IP.
+    std::shared_ptr<const StoreSnapshot> upsert(const std::string &cidr, std::vector<DeviceInfo> devices) {
+        trace::Scope scope("store", "upsert");
+        auto lock = trace::timed_lock(write_mutex_, "store write lock");
+        auto base = std::atomic_load(&current_);
+        auto next = std::make_shared<StoreSnapshot>(*base);
+        next->version = base->version + 1;
+
+        std::shared_ptr<NetworkData> network;
+        auto found = next->by_cidr.find(cidr);
+        if (found == next->by_cidr.end()) {
+            network = std::make_shared<NetworkData>();
+            network->cidr = cidr;
+            next->by_cidr.emplace(cidr, next->networks.size());
+            next->networks.push_back(network);
+        } else {
+            network = std::make_shared<NetworkData>(*next->networks[found->second]);
+            next->networks[found->second] = network;
+        }
+
+        // Nodes this batch creates are edited in place by the rest of the batch
+        persistent::Transaction tx;
+        for (auto& device : devices) {
+            auto shared = std::make_shared<const DeviceInfo>(std::move(device));
+            const bool has_ip = shared->ipAddress.valid();
+            const bool has_mac = shared->macAddress.valid();
+
+            const size_t* existing = has_ip ? network->by_ip.find(shared->ipAddress) : nullptr;
+            if (!existing && !has_ip && has_mac) existing = network->by_mac.find(shared->macAddress);
+
+            const size_t index = existing ? *existing : network->devices.size();
+            if (!existing) {
+                network->devices.push_back(shared, tx);
+            } else {
+                // Drop index entries of the record being replaced, unless they
+                // already point at another record (a MAC that moved to a new IP)
+                auto old = network->devices[index];
+                if (old->macAddress.valid() && old->macAddress != shared->macAddress) {
+                    const size_t* owner = network->by_mac.find(old->macAddress);
+                    if (owner && *owner == index) network->by_mac.erase(old->macAddress, tx);
+                }
+                if (old->ipAddress.valid() && old->ipAddress != shared->ipAddress) {
+                    const size_t* owner = network->by_ip.find(old->ipAddress);
+                    if (owner && *owner == index) network->by_ip.erase(old->ipAddress, tx);
+                }
+                network->devices.set(index, shared, tx);
+            }
+            if (has_ip) network->by_ip.assign(shared->ipAddress, index, tx);
+            if (has_mac) network->by_mac.assign(shared->macAddress, index, tx);
+        }
+
+        std::shared_ptr<const StoreSnapshot> published = std::move(next);
+        std::atomic_store(&current_, published);
+        return published;
+    }
+
+    void clear() {
+        auto lock = trace::timed_lock(write_mutex_, "store write lock");
+        auto next = std::make_shared<StoreSnapshot>();
+        next->version = std::atomic_load(&current_)->version + 1;
+        std::atomic_store(&current_, std::shared_ptr<const StoreSnapshot>(std::move(next)));
+    }
+};
+
+namespace nmapVisualizerGlobals {
+    extern NetworkStore store;
+}
+
+#endif // STORE_HPP
@@ -0,0 +1,202 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+Instrumentation for the scan, parse, store and render paths.
+
+While a trace is running, scoped timers, counters and lock waits are kept
+per thread and can be written out as Chrome trace JSON (chrome://tracing or
+ui.perfetto.dev). The totals in trace::stats() are kept all the time; they
+are a few relaxed atomics and feed the performance overlay.
+*/
+namespace trace {
+
+struct Event {
+    const char* name;      // string literals only: kept by pointer
+    const char* category;
+    int64_t start_us;
+    int64_t duration_us;   // complete events
+    double value;          // counter events
+    char phase;            // 'X' complete, 'C' counter
+};
+
+struct Stats {
+    std::atomic<uint64_t> hosts_parsed{0};
+    std::atomic<uint64_t> lock_waits{0};    // contended acquisitions of instrumented mutexes
+    std::atomic<uint64_t> lock_wait_us{0};  // time spent blocked on them
+    std::atomic<uint64_t> dropped_events{0};
+};
+
+// Microseconds since the first call, the time base of every event
+inline int64_t now_us() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+class Recorder {
+public:
+    static constexpr size_t kMaxEventsPerThread = size_t{1} << 20;
+
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // Starting discards the events of the previous trace
+    void start() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& buffer : buffers_) {
+            std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+            buffer->events.clear();
+        }
+        stats_.dropped_events.store(0, std::memory_order_relaxed);
+        enabled_.store(true, std::memory_order_relaxed);
+    }
+
+    void stop() { enabled_.store(false, std::memory_order_relaxed); }
+
+    void record(const Event &event) {
+        ThreadBuffer& buffer = local();
+        // only contended while a trace is being written out
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        if (buffer.events.size() >= kMaxEventsPerThread) {
+            stats_.dropped_events.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        buffer.events.push_back(event);
+    }
+
+    // Shown as the track name in the trace viewer
+    void set_thread_name(const std::string &name) {
+        ThreadBuffer& buffer = local();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        buffer.name = name;
+    }
+
+    Stats& stats() { return stats_; }
+
+    // Chrome trace event format; returns the number of events written
+    size_t write_json(const std::string &path) {
+        std::FILE* out = std::fopen(path.c_str(), "wb");
+        if (!out) throw std::runtime_error("cannot create " + path);
+        std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", out);
+        size_t written = 0;
+        auto separator = [&]() { std::fputs(written++ ? ",\n" : "", out); };
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& buffer : buffers_) {
+            std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+            if (!buffer->name.empty()) {
+                separator();
+                std::fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                             buffer->tid, escape(buffer->name).c_str());
+            }
+            for (const Event& event : buffer->events) {
+                separator();
+                if (event.phase == 'C') {
+                    std::fprintf(out, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"C\",\"ts\":%lld,\"pid\":1,\"tid\":%u,\"args\":{\"value\":%g}}",
+                                 event.name, event.category, static_cast<long long>(event.start_us), buffer->tid, event.value);
+                } else {
+                    std::fprintf(out, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":%u}",
+                                 event.name, event.category, static_cast<long long>(event.start_us),
+                                 static_cast<long long>(event.duration_us), buffer->tid);
+                }
+            }
+        }
+        std::fputs("\n]}\n", out);
+        const bool failed = std::ferror(out) != 0;
+        std::fclose(out);
+        if (failed) throw std::runtime_error("error writing " + path);
+        return written;
+    }
+
+private:
+    struct ThreadBuffer {
+        std::mutex mutex;
+        std::vector<Event> events;
+        std::string name;
+        uint32_t tid = 0;
+    };
+
+    std::atomic<bool> enabled_{false};
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;  // outlive their threads so a later export still sees them
+    Stats stats_;
+
+    ThreadBuffer& local() {
+        thread_local std::shared_ptr<ThreadBuffer> buffer;
+        if (!buffer) {
+            buffer = std::make_shared<ThreadBuffer>();
+            std::lock_guard<std::mutex> lock(mutex_);
+            buffer->tid = static_cast<uint32_t>(buffers_.size() + 1);
+            buffers_.push_back(buffer);
+        }
+        return *buffer;
+    }
+
+    static std::string escape(const std::string &text) {
+        std::string result;
+        for (char c : text) {
+            if (c == '"' || c == '\\') result += '\\';
+            if (static_cast<unsigned char>(c) >= 0x20) result += c;
+        }
+        return result;
+    }
+};
+
+inline Recorder& recorder() {
+    static Recorder instance;
+    return instance;
+}
+
+inline Stats& stats() { return recorder().stats(); }
+
+// Times its own lifetime as one slice of the trace; free when no trace runs
+class Scope {
+public:
+    Scope(const char* category, const char* name)
+        : category_(category), name_(name), start_(recorder().enabled() ? now_us() : -1) {}
+
+    ~Scope() {
+        if (start_ >= 0) recorder().record(Event{name_, category_, start_, now_us() - start_, 0.0, 'X'});
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char* category_;
+    const char* name_;
+    int64_t start_;
+};
+
+// Sampled value (queue depth, hosts/s) drawn as a counter track
+inline void counter(const char* category, const char* name, double value) {
+    if (recorder().enabled()) recorder().record(Event{name, category, now_us(), 0, value, 'C'});
+}
+
+// Lock a mutex, charging any time spent blocked to the contention totals
+// and, while tracing, to a "lock" slice named after the mutex
+template <typename Mutex>
+std::unique_lock<Mutex> timed_lock(Mutex &mutex, const char* name) {
+    std::unique_lock<Mutex> lock(mutex, std::try_to_lock);
+    if (lock.owns_lock()) return lock;
+    const int64_t start = now_us();
+    lock.lock();
+    const int64_t waited = now_us() - start;
+    stats().lock_waits.fetch_add(1, std::memory_order_relaxed);
+    stats().lock_wait_us.fetch_add(static_cast<uint64_t>(waited), std::memory_order_relaxed);
+    if (recorder().enabled()) recorder().record(Event{name, "lock", start, waited, 0.0, 'X'});
+    return lock;
+}
+
+} // namespace trace
+
+#endif // TRACE_HPP
@@ -0,0 +1,753 @@
+// utils.cpp
+#include "utils.hpp"
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <deque>
+#include <sstream>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <io.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+extern char** environ;
+#endif
+
+std::vector<std::string> nmap_arguments(const std::string &targets, const std::vector<std::string> &options) {
+    std::vector<std::string> args = {"-oX", "-"};
+    args.insert(args.end(), options.begin(), options.end());
+    std::istringstream split(targets);
+    for (std::string target; split >> target;) args.push_back(target);
+    return args;
+}
+
+namespace {
+
+#if defined(_WIN32) || defined(_WIN64)
+// CommandLineToArgvW-compatible quoting of one argument
+std::string quote_windows_argument(const std::string &arg) {
+    if (!arg.empty() && arg.find_first_of(" \t\"") == std::string::npos) return arg;
+    std::string quoted = "\"";
+    size_t backslashes = 0;
+    for (char c : arg) {
+        if (c == '\\') { backslashes++; continue; }
+        quoted.append(c == '"' ? backslashes * 2 + 1 : backslashes, '\\');
+        backslashes = 0;
+        quoted += c;
+    }
+    quoted.append(backslashes * 2, '\\');
+    return quoted + "\"";
+}
+
+NmapProcess win_start_nmap(const std::string &nmap_path, const std::vector<std::string> &args) {
+    // _popen goes through cmd.exe, so every argument is quoted individually
+    std::string cmd = "\"" + quote_windows_argument(nmap_path);
+    for (const auto& arg : args) cmd += " " + quote_windows_argument(arg);
+    cmd += " 2>nul\"";
+
+    // _popen is available on Windows; returns FILE* you can read
+    FILE* pipe = _popen(cmd.c_str(), "rb");
+    if (!pipe) {
+        throw std::runtime_error("Failed to run nmap (is it installed in the default path?)");
+    }
+    return NmapProcess{pipe, 0};
+}
+#endif
+
+#if defined(__linux__)
+NmapProcess linux_start_nmap(const std::string &nmap_path, const std::vector<std::string> &args, int niceness) {
+    // Spawned directly from an argv vector: no shell, so no quoting or injection issues
+    std::vector<char*> argv;
+    argv.reserve(args.size() + 2);
+    argv.push_back(const_cast<char*>(nmap_path.c_str()));
+    for (const auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        throw std::runtime_error("Failed to create pipe for nmap");
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawnattr_init(&attr);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    // Own process group so cancelling kills nmap and anything it spawned
+    posix_spawnattr_setpgroup(&attr, 0);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+
+    pid_t pid = 0;
+    const int error = posix_spawnp(&pid, nmap_path.c_str(), &actions, &attr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    close(fds[1]);
+    if (error != 0) {
+        close(fds[0]);
+        throw std::runtime_error("Failed to run nmap (is it installed and in PATH?): " + std::string(std::strerror(error)));
+    }
+    // posix_spawn has no nice attribute; nmap is still starting up at this point
+    if (niceness > 0) setpriority(PRIO_PGRP, static_cast<id_t>(pid), niceness);
+
+    FILE* out = fdopen(fds[0], "r");
+    if (!out) {
+        close(fds[0]);
+        kill(-pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+        throw std::runtime_error("Failed to read nmap output");
+    }
+    return NmapProcess{out, static_cast<long>(pid)};
+}
+#endif
+
+} // namespace
+
+NmapProcess start_nmap(const std::string &targets, std::string nmap_path, const std::vector<std::string> &options, int niceness) {
+    const auto args = nmap_arguments(targets, options);
+    #if defined(_WIN32) || defined(_WIN64)
+        if (nmap_path.empty()) { nmap_path = "C:\\Program Files (x86)\\Nmap\\nmap.exe"; }
+        (void)niceness;
+        return win_start_nmap(nmap_path, args);
+    #elif defined(__linux__)
+        if (nmap_path.empty()) { nmap_path = "/usr/bin/nmap"; }
+        return linux_start_nmap(nmap_path, args, niceness);
+    #else
+        throw std::runtime_error("Unsupported platform for running nmap");
+    #endif
+}
+
+int finish_nmap(NmapProcess &process) {
+    int status = 0;
+    #if defined(_WIN32) || defined(_WIN64)
+        if (process.pipe) status = _pclose(process.pipe);
+    #elif defined(__linux__)
+        if (process.pipe) fclose(process.pipe);
+        if (process.pid > 0) {
+            int wstatus = 0;
+            waitpid(static_cast<pid_t>(process.pid), &wstatus, 0);
+            status = WIFEXITED(wstatus) ? WEXITSTATUS(wstatus) : -1;
+        }
+    #endif
+    process.pipe = nullptr;
+    process.pid = 0;
+    return status;
+}
+
+void kill_nmap(const NmapProcess &process) {
+    #if defined(__linux__)
+        if (process.pid > 0) kill(-static_cast<pid_t>(process.pid), SIGTERM);
+    #else
+        (void)process; // _popen does not expose the child pid
+    #endif
+}
+
+std::shared_ptr<const StoreSnapshot> save_devices(std::vector<DeviceInfo> devices, const std::string &cidr) {
+    trace::Scope scope("store", "save_devices");
+    std::clog << "Saving " << devices.size() << " devices for network: " << cidr << std::endl;
+    // Appended to the on-disk database (if open) so results survive restarts
+    try {
+        nmapVisualizerGlobals::database.append(cidr, devices);
+    } catch (const std::exception &e) {
+        std::cerr << "Error writing scan database: " << e.what() << std::endl;
+    }
+    // Rescans update hosts in place instead of appending duplicates
+    return nmapVisualizerGlobals::store.upsert(cidr, std::move(devices));
+}
+
+std::vector<DeviceInfo> get_devices(const std::string &cidr) {
+    auto snapshot = nmapVisualizerGlobals::store.snapshot();
+    std::vector<DeviceInfo> devices;
+    if (const NetworkData* network = snapshot->find(cidr)) {
+        devices.reserve(network->devices.size());
+        for (const auto& d : network->devices) devices.push_back(*d);
+    }
+    return devices;
+}
+
+namespace {
+
+// Attribute value read in place from the expanded tree: no xmlGetProp copy.
+// nmap attributes are plain text nodes; anything else (entity references)
+// goes through xmlGetProp into scratch, which stays valid for the current host.
+std::string_view attribute(xmlNodePtr node, const char* name, std::deque<std::string> &scratch) {
+    for (xmlAttrPtr attr = node->properties; attr; attr = attr->next) {
+        if (!xmlStrEqual(attr->name, BAD_CAST name)) continue;
+        xmlNodePtr value = attr->children;
+        if (!value) return {};
+        if (value->type == XML_TEXT_NODE && !value->next && value->content) {
+            return reinterpret_cast<const char*>(value->content);
+        }
+        xmlChar* copy = xmlGetProp(node, BAD_CAST name);
+        if (!copy) return {};
+        scratch.emplace_back(reinterpret_cast<const char*>(copy));
+        xmlFree(copy);
+        return scratch.back();
+    }
+    return {};
+}
+
+bool is_element(xmlNodePtr node, const char* name) {
+    return node->type == XML_ELEMENT_NODE && xmlStrEqual(node->name, BAD_CAST name);
+}
+
+int parse_port_number(std::string_view text) {
+    int value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9' || value > 65535) return 0;
+        value = value * 10 + (c - '0');
+    }
+    return value <= 65535 ? value : 0;
+}
+
+// "name (product version) extrainfo [os:ostype]" built into a reused buffer
+void describe_service(xmlNodePtr service, std::string &out, std::deque<std::string> &scratch) {
+    const std::string_view name = attribute(service, "name", scratch);
+    const std::string_view product = attribute(service, "product", scratch);
+    const std::string_view version = attribute(service, "version", scratch);
+    const std::string_view extrainfo = attribute(service, "extrainfo", scratch);
+    const std::string_view ostype = attribute(service, "ostype", scratch);
+
+    out.assign(name);
+    if (!product.empty()) {
+        if (!out.empty()) out += " (";
+        out += product;
+        if (!version.empty()) {
+            out += ' ';
+            out += version;
+        }
+        if (!name.empty()) out += ')';
+    }
+    if (!extrainfo.empty()) {
+        out += ' ';
+        out += extrainfo;
+    }
+    if (!ostype.empty()) {
+        out += " [os:";
+        out += ostype;
+        out += ']';
+    }
+}
+
+} // namespace
+
+DeviceInfo parse_host_node(xmlNodePtr hostNode) {
+    // Reused across hosts on this thread
+    thread_local std::string service;
+    thread_local std::deque<std::string> scratch;
+    scratch.clear();
+
+    IpAddress ipAddress;
+    MacAddress macAddress;
+    InternedString vendor;
+    InternedString deviceType;
+    InternedString operatingSystem;
+    std::vector<Port> ports;
+
+    // nmap stamps each host with when its scan ended; fall back to now
+    int64_t lastScanned = 0;
+    const std::string_view endtime = attribute(hostNode, "endtime", scratch);
+    if (!endtime.empty()) lastScanned = std::strtoll(endtime.data(), nullptr, 10);
+    if (lastScanned <= 0) lastScanned = static_cast<int64_t>(std::time(nullptr));
+
+    // Attribute views point into the expanded tree (NUL-terminated), which
+    // outlives this function's use of them
+    for (xmlNodePtr child = hostNode->children; child; child = child->next) {
+        if (child->type != XML_ELEMENT_NODE) continue;
+
+        if (is_element(child, "address")) {
+            const std::string_view addrType = attribute(child, "addrtype", scratch);
+            const std::string_view addr = attribute(child, "addr", scratch);
+            if (addr.empty()) continue;
+            if (addrType == "ipv4" || addrType == "ipv6") {
+                ipAddress = IpAddress::parse(addr.data());
+            } else if (addrType == "mac") {
+                macAddress = MacAddress::parse(addr.data());
+                const std::string_view vend = attribute(child, "vendor", scratch);
+                if (!vend.empty()) vendor = InternedString(vend);
+            }
+        } else if (is_element(child, "hostnames")) {
+            for (xmlNodePtr hn = child->children; hn; hn = hn->next) {
+                if (!is_element(hn, "hostname")) continue;
+                const std::string_view name = attribute(hn, "name", scratch);
+                if (!name.empty()) {
+                    deviceType = InternedString(name);
+                    break; // use first hostname
+                }
+            }
+        } else if (is_element(child, "ports")) {
+            ports.reserve(xmlChildElementCount(child));
+            for (xmlNodePtr portNode = child->children; portNode; portNode = portNode->next) {
+                if (!is_element(portNode, "port")) continue;
+
+                const int portNumber = parse_port_number(attribute(portNode, "portid", scratch));
+                const Protocol protocol = parse_protocol(attribute(portNode, "protocol", scratch));
+                PortState state = PortState::Unknown;
+                service.clear();
+
+                for (xmlNodePtr pchild = portNode->children; pchild; pchild = pchild->next) {
+                    if (is_element(pchild, "state")) {
+                        state = parse_port_state(attribute(pchild, "state", scratch));
+                    } else if (is_element(pchild, "service")) {
+                        describe_service(pchild, service, scratch);
+                    }
+                }
+
+                ports.emplace_back(portNumber, protocol, state, InternedString(std::string_view(service)));
+            }
+        } else if (is_element(child, "os")) {
+            for (xmlNodePtr osChild = child->children; osChild; osChild = osChild->next) {
+                if (!is_element(osChild, "osmatch")) continue;
+                const std::string_view name = attribute(osChild, "name", scratch);
+                if (!name.empty()) {
+                    operatingSystem = InternedString(name);
+                    break;
+                }
+            }
+        }
+    }
+
+    // ip/mac stay invalid binary addresses when unknown
+    static const InternedString unknown("Unknown");
+    if (vendor.empty())           vendor = unknown;
+    if (deviceType.empty())       deviceType = unknown;
+    if (operatingSystem.empty())  operatingSystem = unknown;
+
+    DeviceInfo device(ipAddress, macAddress, vendor, deviceType, std::move(ports), operatingSystem);
+    device.lastScanned = lastScanned;
+    trace::stats().hosts_parsed.fetch_add(1, std::memory_order_relaxed);
+    return device;
+}
+
+std::string format_duration(int64_t seconds) {
+    if (seconds < 0) seconds = 0;
+    char text[32];
+    if (seconds >= 3600) {
+        std::snprintf(text, sizeof(text), "%lldh%02lldm", static_cast<long long>(seconds / 3600), static_cast<long long>(seconds / 60 % 60));
+    } else if (seconds >= 60) {
+        std::snprintf(text, sizeof(text), "%lldm%02llds", static_cast<long long>(seconds / 60), static_cast<long long>(seconds % 60));
+    } else {
+        std::snprintf(text, sizeof(text), "%llds", static_cast<long long>(seconds));
+    }
+    return text;
+}
+
+namespace {
+
+std::string reader_attribute(xmlTextReaderPtr reader, const char* name) {
+    xmlChar* value = xmlTextReaderGetAttribute(reader, BAD_CAST name);
+    if (!value) return {};
+    std::string result(reinterpret_cast<const char*>(value));
+    xmlFree(value);
+    return result;
+}
+
+} // namespace
+
+size_t parse_nmap_reader(xmlTextReaderPtr reader, const std::function<void(DeviceInfo&&)> &on_device,
+                         const std::function<void(const ScanProgress&)> &on_progress, std::string* scan_args) {
+    trace::Scope scope("parse", "parse_nmap_reader");
+    size_t count = 0;
+    ScanProgress progress;
+    int ret = xmlTextReaderRead(reader);
+    while (ret == 1) {
+        if (scan_args && xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT && xmlTextReaderDepth(reader) == 0
+            && xmlStrEqual(xmlTextReaderConstLocalName(reader), BAD_CAST "nmaprun")) {
+            *scan_args = reader_attribute(reader, "args");
+        }
+        if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT || xmlTextReaderDepth(reader) != 1) {
+            ret = xmlTextReaderRead(reader);
+            continue;
+        }
+        const xmlChar* name = xmlTextReaderConstLocalName(reader);
+        if (xmlStrEqual(name, BAD_CAST "host")) {
+            xmlNodePtr hostNode = xmlTextReaderExpand(reader);
+            if (!hostNode) throw std::runtime_error("Failed to expand <host> element");
+            on_device(parse_host_node(hostNode));
+            count++;
+            ret = xmlTextReaderNext(reader);
+            continue;
+        }
+        if (on_progress) {
+            // Discovery reports each live host as a <hosthint> before the port scan
+            if (xmlStrEqual(name, BAD_CAST "hosthint")) {
+                progress.hints++;
+            } else if (xmlStrEqual(name, BAD_CAST "taskbegin") || xmlStrEqual(name, BAD_CAST "taskprogress")) {
+                progress.task = reader_attribute(reader, "task");
+                progress.percent = std::strtod(reader_attribute(reader, "percent").c_str(), nullptr);
+                progress.remaining = std::strtoll(reader_attribute(reader, "remaining").c_str(), nullptr, 10);
+                progress.etc = std::strtoll(reader_attribute(reader, "etc").c_str(), nullptr, 10);
+                progress.hosts_up = std::max(progress.hints, count);
+                on_progress(progress);
+            }
+        }
+        ret = xmlTextReaderRead(reader);
+    }
+    if (ret < 0) throw std::runtime_error("Malformed nmap XML");
+    return count;
+}
+
+namespace {
+
+// libxml2 asks for about 4 KiB per callback; one large read() serves many of them
+struct NmapPipeBuffer {
+    FILE* pipe = nullptr;
+    std::vector<char>* chunk = nullptr;
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+// xmlInputReadCallback over a NmapPipeBuffer; returns whatever is available
+// instead of waiting for a full buffer so hosts show up while nmap runs
+int nmap_pipe_read(void* context, char* buffer, int len) {
+    auto* in = static_cast<NmapPipeBuffer*>(context);
+    if (in->begin == in->end) {
+        std::vector<char>& chunk = *in->chunk;
+        #if defined(_WIN32) || defined(_WIN64)
+            int n = _read(_fileno(in->pipe), chunk.data(), static_cast<unsigned int>(chunk.size()));
+        #else
+            // a signal landing on this thread (e.g. SIGCHLD) interrupts the read, not the stream
+            ssize_t n;
+            do {
+                n = read(fileno(in->pipe), chunk.data(), chunk.size());
+            } while (n < 0 && errno == EINTR);
+        #endif
+        if (n <= 0) return n < 0 ? -1 : 0;
+        in->begin = 0;
+        in->end = static_cast<size_t>(n);
+    }
+    const size_t count = std::min(static_cast<size_t>(len), in->end - in->begin);
+    std::memcpy(buffer, in->chunk->data() + in->begin, count);
+    in->begin += count;
+    return static_cast<int>(count);
+}
+
+// Inputs are handed to libxml2 through read callbacks, at most len bytes at a
+// time, so sizes above INT_MAX never pass through its int-sized parameters
+struct MemoryInput {
+    const char* data = nullptr;
+    size_t size = 0;
+    size_t at = 0;
+};
+
+int memory_read(void* context, char* buffer, int len) {
+    auto* in = static_cast<MemoryInput*>(context);
+    const size_t count = std::min(static_cast<size_t>(len), in->size - in->at);
+    std::memcpy(buffer, in->data + in->at, count);
+    in->at += count;
+    return static_cast<int>(count);
+}
+
+struct FileInput {
+    std::FILE* file = nullptr;
+    uint64_t bytes = 0;
+};
+
+int file_read(void* context, char* buffer, int len) {
+    auto* in = static_cast<FileInput*>(context);
+    const size_t n = std::fread(buffer, 1, static_cast<size_t>(len), in->file);
+    if (n == 0 && std::ferror(in->file)) return -1;
+    in->bytes += n;
+    return static_cast<int>(n);
+}
+
+} // namespace
+
+size_t parse_nmap_xml_stream(FILE* pipe, const std::function<void(DeviceInfo&&)> &on_device,
+                             const std::function<void(const ScanProgress&)> &on_progress) {
+    // Reused by every scan on this thread
+    thread_local std::vector<char> chunk(64 * 1024);
+    NmapPipeBuffer in{pipe, &chunk, 0, 0};
+    size_t count = 0;
+    xmlTextReaderPtr reader = xmlReaderForIO(nmap_pipe_read, nullptr, &in, nullptr, nullptr, XML_PARSE_NONET);
+    if (!reader) {
+        std::cerr << "Error parsing Nmap XML: failed to create reader" << std::endl;
+        return 0;
+    }
+    try {
+        count = parse_nmap_reader(reader, on_device, on_progress);
+    } catch (const std::exception &e) {
+        std::cerr << "Error parsing Nmap XML: " << e.what() << std::endl;
+    }
+    xmlFreeTextReader(reader);
+    return count;
+}
+
+std::vector<DeviceInfo> parse_nmap_xml(const std::string &xmlData) {
+    std::vector<DeviceInfo> devices;
+    MemoryInput in{xmlData.data(), xmlData.size(), 0};
+    xmlTextReaderPtr reader = xmlReaderForIO(memory_read, nullptr, &in, nullptr, nullptr, XML_PARSE_NONET);
+    if (!reader) {
+        std::cerr << "Error parsing Nmap XML: failed to create reader" << std::endl;
+        return devices;
+    }
+    try {
+        parse_nmap_reader(reader, [&devices](DeviceInfo &&d) { devices.push_back(std::move(d)); });
+    } catch (const std::exception &e) {
+        std::cerr << "Error parsing Nmap XML: " << e.what() << std::endl;
+    }
+    xmlFreeTextReader(reader);
+    return devices;
+}
+
+size_t scan_nmap_streaming(const std::string &targets, const std::function<void(DeviceInfo&&)> &on_device, std::string nmap_path) {
+    NmapProcess process = start_nmap(targets, nmap_path);
+    size_t count = parse_nmap_xml_stream(process.pipe, on_device);
+    finish_nmap(process);
+    return count;
+}
+
+size_t parse_nmap_file(const std::string &path, const std::function<void(DeviceInfo&&)> &on_device, uint64_t* bytes_read,
+                       std::string* scan_args) {
+    // Streamed through the reader, so memory stays flat whatever the file size
+    FileInput in{std::fopen(path.c_str(), "rb"), 0};
+    if (!in.file) throw std::runtime_error("cannot open " + path);
+    xmlTextReaderPtr reader = xmlReaderForIO(file_read, nullptr, &in, path.c_str(), nullptr, XML_PARSE_NONET);
+    if (!reader) {
+        std::fclose(in.file);
+        throw std::runtime_error("failed to create reader for " + path);
+    }
+    size_t count = 0;
+    try {
+        count = parse_nmap_reader(reader, on_device, nullptr, scan_args);
+    } catch (...) {
+        xmlFreeTextReader(reader);
+        const bool failed = std::ferror(in.file) != 0;
+        std::fclose(in.file);
+        if (failed) throw std::runtime_error("cannot read " + path);
+        throw;
+    }
+    xmlFreeTextReader(reader);
+    const bool failed = std::ferror(in.file) != 0;
+    std::fclose(in.file);
+    if (failed) throw std::runtime_error("cannot read " + path);
+    if (bytes_read) *bytes_read = in.bytes;
+    return count;
+}
+
+std::vector<std::string> collect_xml_files(const std::vector<std::string> &paths) {
+    std::vector<std::string> files;
+    for (const auto& path : paths) {
+        std::error_code ec;
+        if (std::filesystem::is_directory(path, ec)) {
+            std::vector<std::string> found;
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(path, ec)) {
+                if (entry.is_regular_file(ec) && entry.path().extension() == ".xml") found.push_back(entry.path().string());
+            }
+            std::sort(found.begin(), found.end());
+            files.insert(files.end(), found.begin(), found.end());
+        } else {
+            files.push_back(path);
+        }
+    }
+    return files;
+}
+
+namespace {
+
+// Picks the network an imported host is saved under
+class ImportNetworks {
+public:
+    explicit ImportNetworks(const StoreSnapshot &snapshot) {
+        for (const auto& network : snapshot.networks) {
+            if (auto cidr = parse_ipv4_cidr(network->cidr)) {
+                stored_.emplace(std::make_pair(cidr->prefix, cidr->base), network->cidr);
+            } else {
+                other_.push_back(network.get());  // hostnames, IPv6 and ranges: matched by address only
+            }
+        }
+    }
+
+    // The stored network holding the address (the narrowest block containing
+    // it), else the narrowest target on the file's command line containing
+    // it, else the /24 or /64 around it
+    std::string network_for(const DeviceInfo &device, const std::vector<Ipv4Cidr> &targets, const std::vector<std::string> &names) const {
+        if (device.ipAddress.family == 4) {
+            const uint32_t ip = device.ipAddress.v4();
+            for (int prefix = 32; prefix >= 0; prefix--) {
+                const uint32_t mask = prefix == 0 ? 0 : 0xFFFFFFFFu << (32 - prefix);
+                auto it = stored_.find(std::make_pair(prefix, ip & mask));
+                if (it != stored_.end()) return it->second;
+            }
+        }
+        if (device.ipAddress.valid()) {
+            for (const NetworkData* network : other_) {
+                if (network->by_ip.find(device.ipAddress)) return network->cidr;
+            }
+        }
+        if (device.ipAddress.family == 4) {
+            const uint32_t ip = device.ipAddress.v4();
+            size_t best = targets.size();
+            for (size_t i = 0; i < targets.size(); i++) {
+                const uint32_t mask = targets[i].prefix == 0 ? 0 : 0xFFFFFFFFu << (32 - targets[i].prefix);
+                if ((ip & mask) == targets[i].base && (best == targets.size() || targets[i].prefix > targets[best].prefix)) best = i;
+            }
+            if (best < targets.size()) return names[best];
+        }
+        return cluster_key(device, ClusterMode::Subnet);
+    }
+
+private:
+    std::map<std::pair<int, uint32_t>, std::string> stored_;  // (prefix, base) -> cidr
+    std::vector<const NetworkData*> other_;
+};
+
+// IPv4 networks named on an nmap command line, as typed
+void scan_targets(const std::string &args, std::vector<Ipv4Cidr> &targets, std::vector<std::string> &names) {
+    std::istringstream words(args);
+    std::string word;
+    words >> word;  // the nmap binary
+    while (words >> word) {
+        if (auto cidr = parse_ipv4_cidr(word)) {
+            targets.push_back(*cidr);
+            names.push_back(word);
+        }
+    }
+}
+
+} // namespace
+
+ImportStats import_nmap_files(const std::vector<std::string> &paths, size_t jobs) {
+    ImportStats stats;
+    stats.files = paths.size();
+    auto start = std::chrono::steady_clock::now();
+
+    if (jobs == 0) jobs = std::max(1u, std::thread::hardware_concurrency());
+    jobs = std::min(jobs, std::max<size_t>(paths.size(), 1));
+
+    // libxml2 must be initialized once before readers are used from several threads
+    xmlInitParser();
+
+    std::vector<std::vector<DeviceInfo>> results(paths.size());
+    std::vector<std::string> args(paths.size());
+    std::atomic<size_t> next{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<size_t> failed{0};
+
+    auto worker = [&]() {
+        for (size_t i = next.fetch_add(1); i < paths.size(); i = next.fetch_add(1)) {
+            trace::Scope scope("import", "import file");
+            try {
+                uint64_t file_bytes = 0;
+                parse_nmap_file(paths[i], [&results, i](DeviceInfo &&d) { results[i].push_back(std::move(d)); }, &file_bytes, &args[i]);
+                bytes += file_bytes;
+            } catch (const std::exception &e) {
+                std::cerr << "Error importing " << paths[i] << ": " << e.what() << std::endl;
+                results[i].clear();
+                failed++;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < jobs; t++) {
+        threads.emplace_back([&worker]() {
+            trace::recorder().set_thread_name("import worker");
+            worker();
+        });
+    }
+    worker();
+    for (auto& thread : threads) thread.join();
+
+    // One save per network keeps the merge linear in the number of hosts
+    const ImportNetworks networks(*nmapVisualizerGlobals::store.snapshot());
+    std::map<std::string, std::vector<DeviceInfo>> by_network;
+    for (size_t i = 0; i < results.size(); i++) {
+        std::vector<Ipv4Cidr> targets;
+        std::vector<std::string> names;
+        scan_targets(args[i], targets, names);
+        stats.hosts += results[i].size();
+        for (auto& device : results[i]) {
+            by_network[networks.network_for(device, targets, names)].push_back(std::move(device));
+        }
+    }
+    for (auto& [cidr, devices] : by_network) {
+        save_devices(std::move(devices), cidr);
+    }
+
+    stats.bytes = bytes;
+    stats.failed = failed;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+std::optional<Ipv4Cidr> parse_ipv4_cidr(const std::string &text) {
+    // Digits only: no signs, spaces or trailing characters, unlike sscanf
+    const char* at = text.data();
+    const char* const end = text.data() + text.size();
+    auto number = [&](unsigned max, char separator, unsigned &value) {
+        auto [next, error] = std::from_chars(at, end, value);
+        if (error != std::errc() || value > max) return false;
+        at = next;
+        if (separator == 0) return true;
+        if (at == end || *at != separator) return false;
+        at++;
+        return true;
+    };
+
+    unsigned int a, b, c, d, prefix = 32;
+    if (!number(255, '.', a) || !number(255, '.', b) || !number(255, '.', c) || !number(255, 0, d)) return std::nullopt;
+    if (at != end && (*at++ != '/' || !number(32, 0, prefix))) return std::nullopt;
+    if (at != end) return std::nullopt;
+
+    uint32_t mask = prefix == 0 ? 0 : 0xFFFFFFFFu << (32 - prefix);
+    return Ipv4Cidr{((a << 24) | (b << 16) | (c << 8) | d) & mask, static_cast<int>(prefix)};
+}
+
+std::string format_ipv4(uint32_t address) {
+    return std::to_string(address >> 24) + "." + std::to_string((address >> 16) & 0xFF) + "."
+         + std::to_string((address >> 8) & 0xFF) + "." + std::to_string(address & 0xFF);
+}
+
+std::vector<std::string> shard_cidr(const std::string &target, int shard_prefix, size_t max_shards) {
+    auto cidr = parse_ipv4_cidr(target);
+    if (!cidr || shard_prefix <= 0 || cidr->prefix >= shard_prefix) return {target};
+
+    shard_prefix = std::min(shard_prefix, 32);
+    while (shard_prefix > cidr->prefix && (size_t{1} << (shard_prefix - cidr->prefix)) > max_shards) {
+        shard_prefix--;
+    }
+
+    std::vector<std::string> shards;
+    uint64_t count = uint64_t{1} << (shard_prefix - cidr->prefix);
+    uint64_t step = uint64_t{1} << (32 - shard_prefix);
+    shards.reserve(count);
+    for (uint64_t i = 0; i < count; i++) {
+        shards.push_back(format_ipv4(static_cast<uint32_t>(cidr->base + i * step)) + "/" + std::to_string(shard_prefix));
+    }
+    return shards;
+}
+
+RescanPlan plan_rescan(const std::vector<DeviceInfo> &alive, const NetworkData* prior, int64_t ttl_seconds, int64_t now) {
+    RescanPlan plan;
+    std::unordered_set<IpAddress, IpAddressHash> planned;
+    for (const auto& host : alive) {
+        if (!host.ipAddress.valid() || !planned.insert(host.ipAddress).second) continue;
+        const DeviceInfo* known = nullptr;
+        std::shared_ptr<const DeviceInfo> record;
+        if (prior) {
+            const size_t* index = prior->by_ip.find(host.ipAddress);
+            if (index) {
+                record = prior->devices[*index];
+                known = record.get();
+            }
+        }
+        if (!known) {
+            plan.added++;
+        } else if (host.macAddress.valid() && host.macAddress != known->macAddress) {
+            plan.changed++;
+        } else if (known->lastScanned <= 0 || now - known->lastScanned > ttl_seconds) {
+            plan.stale++;
+        } else {
+            plan.unchanged.push_back(std::move(record));
+            continue;
+        }
+        plan.rescan.push_back(host.ipAddress.to_string());
+    }
+    return plan;
+}
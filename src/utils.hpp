@@ -7,306 +7,598 @@
 #include <string>
 #include <stdexcept>
 #include <libxml/parser.h>
+#include <libxml/xmlreader.h>
+#include <functional>
 #include <future>
 #include <thread>
 #include <vector>
 #include <algorithm>
 #include <mutex>
+#include <atomic>
+#include <optional>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <map>
 
 #include "globals.hpp"
+#include "store.hpp"
+#include "database.hpp"
+#include "queue.hpp"
+#include "cluster.hpp"
+#include "trace.hpp"
+#include "scan_profile.hpp"
 
-#if defined(_WIN32) || defined(_WIN64)
-std::string win_run_nmap_xml(const std::string &targets, const std::string &nmap_path) {
-    // Note: " -oX - " -> XML to stdout
-    std::string cmd = "\"" + nmap_path + "\" -oX - " + targets + " 2>nul";
-    std::array<char, 4096> buffer;
-    std::string result;
-
-    // _popen is available on Windows; returns FILE* you can read
-    FILE* pipe = _popen(cmd.c_str(), "r");
-    if (!pipe) {
-        throw std::runtime_error("Failed to run nmap (is it installed in the default path?)");
+// Handle to a running nmap child: its XML stdout and process id (0 if unknown)
+struct NmapProcess {
+    FILE* pipe = nullptr;
+    long pid = 0;
+};
+
+// argv after the executable: XML to stdout, profile options, then one entry per target
+std::vector<std::string> nmap_arguments(const std::string &targets, const std::vector<std::string> &options);
+
+// options are extra nmap arguments placed before the targets (e.g. ScanProfile::arguments());
+// targets is a whitespace-separated list. A positive niceness lowers the CPU
+// priority of nmap and its children (POSIX only)
+NmapProcess start_nmap(const std::string &targets, std::string nmap_path = "", const std::vector<std::string> &options = {},
+                       int niceness = 0);
+
+// Close the pipe and reap the child, returns the exit status
+int finish_nmap(NmapProcess &process);
+
+// Ask a running nmap to stop; the reader then sees EOF and the scan unwinds
+void kill_nmap(const NmapProcess &process);
+
+std::shared_ptr<const StoreSnapshot> save_devices(std::vector<DeviceInfo> devices, const std::string &cidr = "default");
+
+std::vector<DeviceInfo> get_devices(const std::string &cidr = "default");
+
+// Build a DeviceInfo from a single (expanded) <host> element
+DeviceInfo parse_host_node(xmlNodePtr hostNode);
+
+// "1h05m", "4m10s", "12s"
+std::string format_duration(int64_t seconds);
+
+// Latest nmap --stats-every report of one scan
+struct ScanProgress {
+    std::string task;       // current nmap phase, e.g. "SYN Stealth Scan"
+    double percent = 0.0;   // of the current phase
+    int64_t remaining = 0;  // seconds, 0 if nmap has no estimate yet
+    int64_t etc = 0;        // estimated completion, unix seconds
+    size_t hosts_up = 0;
+    size_t hints = 0;       // <hosthint> count so far
+};
+
+// Walk an nmap XML stream with the xmlTextReader API. Each <host> subtree is
+// expanded on its own and handed to on_device as soon as its </host> closes;
+// the reader frees the subtree when it moves on, so peak memory is bounded by
+// one host instead of the whole scan. Returns the number of hosts emitted.
+// on_progress (optional) sees the <taskbegin>/<taskprogress> lines that
+// --stats-every interleaves with the hosts.
+size_t parse_nmap_reader(xmlTextReaderPtr reader, const std::function<void(DeviceInfo&&)> &on_device,
+                         const std::function<void(const ScanProgress&)> &on_progress = nullptr,
+                         std::string* scan_args = nullptr);
+
+// Incrementally parse nmap XML from an open pipe (closing is left to the caller)
+size_t parse_nmap_xml_stream(FILE* pipe, const std::function<void(DeviceInfo&&)> &on_device,
+                             const std::function<void(const ScanProgress&)> &on_progress = nullptr);
+
+std::vector<DeviceInfo> parse_nmap_xml(const std::string &xmlData);
+
+// Run nmap and stream each discovered host to on_device while the scan is running
+size_t scan_nmap_streaming(const std::string &targets, const std::function<void(DeviceInfo&&)> &on_device, std::string nmap_path = "");
+
+// Parse a saved nmap -oX file, streamed through the reader in small reads so
+// memory does not grow with the file; throws on unreadable or malformed input.
+// Returns the number of hosts; scan_args receives the <nmaprun args> command line.
+size_t parse_nmap_file(const std::string &path, const std::function<void(DeviceInfo&&)> &on_device, uint64_t* bytes_read = nullptr,
+                       std::string* scan_args = nullptr);
+
+// Expand directories (recursively) into the .xml files they contain
+std::vector<std::string> collect_xml_files(const std::vector<std::string> &paths);
+
+struct ImportStats {
+    size_t files = 0;
+    size_t failed = 0;
+    uint64_t bytes = 0;
+    size_t hosts = 0;
+    double seconds = 0.0;
+
+    double mb_per_second() const { return seconds > 0 ? bytes / 1e6 / seconds : 0.0; }
+    double hosts_per_second() const { return seconds > 0 ? hosts / seconds : 0.0; }
+};
+
+// Import saved scans: files are parsed in parallel on `jobs` threads (0 = one
+// per core), then merged in file order, so a host in a later file replaces the
+// same host from an earlier one. Each host joins the stored network that
+// already holds its address, else the narrowest target of its file's nmap
+// command line containing it, else its /24 (or /64); networks are saved like
+// scan results, i.e. into the store and the database.
+ImportStats import_nmap_files(const std::vector<std::string> &paths, size_t jobs = 0);
+
+// IPv4 network block parsed from "a.b.c.d/nn"
+struct Ipv4Cidr {
+    uint32_t base = 0;  // host byte order, masked to the prefix
+    int prefix = 32;
+};
+
+std::optional<Ipv4Cidr> parse_ipv4_cidr(const std::string &text);
+
+std::string format_ipv4(uint32_t address);
+
+// Split an IPv4 block into /shard_prefix sub-blocks. Anything that is not a
+// plain IPv4 CIDR (hostnames, ranges, IPv6) or is already small enough is
+// returned unchanged. At most max_shards blocks are produced; the shard size
+// grows instead when the block is too large for that.
+std::vector<std::string> shard_cidr(const std::string &target, int shard_prefix, size_t max_shards = 4096);
+
+// Parallel nmap scanning - a fixed pool of workers drains a priority queue of targets
+struct ScanTask {
+    uint64_t id = 0;
+    std::string target;
+    std::string cidr;
+    int priority = 0;       // higher runs first
+    uint64_t sequence = 0;  // FIFO among equal priorities
+    std::vector<std::string> options;  // nmap arguments before the targets
+    uint64_t job = 0;       // owning incremental scan, 0 for plain tasks
+    bool discovery = false; // ping sweep of an incremental scan; hosts go to the job
+
+    bool operator<(const ScanTask &other) const {
+        if (priority != other.priority) return priority < other.priority;
+        return sequence > other.sequence;
+    }
+};
+
+// Delta pushed by scan workers; drained on the UI thread
+struct ScanEvent {
+    enum class Kind { Host, Alive, Progress, Finished, Cancelled };
+
+    Kind kind;
+    uint64_t task_id;
+    std::string target;
+    std::string cidr;
+    std::optional<DeviceInfo> device;   // set for Kind::Host
+    std::vector<std::shared_ptr<const DeviceInfo>> known;  // Kind::Alive: stored hosts still up and unchanged
+    ScanProgress progress;                                  // Kind::Progress
+};
+
+// What an incremental rescan has to probe after host discovery
+struct RescanPlan {
+    std::vector<std::string> rescan;                            // addresses to scan fully
+    std::vector<std::shared_ptr<const DeviceInfo>> unchanged;   // stored records of hosts still up
+    size_t added = 0, changed = 0, stale = 0;
+};
+
+// A live host is re-probed when it is new, its MAC changed, or its last full
+// scan is older than ttl_seconds; everything else keeps its stored record
+RescanPlan plan_rescan(const std::vector<DeviceInfo> &alive, const NetworkData* prior, int64_t ttl_seconds, int64_t now);
+
+// Snapshot of the scanner counters for the status label
+struct ScannerStats {
+    size_t queued = 0;
+    size_t running = 0;
+    size_t completed = 0;
+    size_t cancelled = 0;
+    size_t hosts = 0;
+    double hosts_per_second = 0.0;
+    size_t events_pending = 0;  // published but not yet drained by the consumer
+};
+
+class ParallelScanner {
+private:
+    struct RunningScan {
+        NmapProcess process;
+        bool cancelled = false;
+    };
+
+    // Incremental rescan: ping discovery first, then full scans of the hosts that need it
+    struct IncrementalJob {
+        std::string target;
+        std::string cidr;
+        std::shared_ptr<const NetworkData> prior;
+        int64_t ttl_seconds = 0;
+        int priority = 0;
+        std::vector<std::string> options;    // for the full scans
+        bool discovering = true;
+        bool cancelled = false;
+        std::unordered_set<uint64_t> tasks;  // tasks of the current phase still outstanding
+        std::vector<DeviceInfo> alive;       // discovery results, never published
+    };
+
+    MpscQueue<ScanEvent> events_;
+    std::atomic<size_t> events_pending_{0};  // pushed but not yet drained
+    std::function<void()> notify_;
+    std::atomic<bool> notify_pending_{false};
+
+    std::priority_queue<ScanTask> pending_;
+    std::unordered_set<uint64_t> queued_ids_;          // every task in pending_, cancelled or not
+    std::unordered_set<uint64_t> cancelled_pending_;
+    std::unordered_map<uint64_t, RunningScan> running_;
+    std::unordered_map<uint64_t, IncrementalJob> jobs_;
+    std::mutex tasks_mutex_;
+    std::condition_variable tasks_cv_;
+    std::condition_variable idle_cv_;
+    bool stopping_ = false;
+    uint64_t next_id_ = 1;
+    uint64_t next_sequence_ = 0;
+    std::string nmap_path_;
+    ScanProfile profile_;
+    std::atomic<int> shard_prefix_{24};
+    std::atomic<int> niceness_{0};
+
+    size_t completed_ = 0;
+    size_t cancelled_ = 0;
+    std::atomic<size_t> hosts_{0};
+    std::chrono::steady_clock::time_point busy_since_;
+
+    std::vector<std::thread> workers_;
+
+    void publish(ScanEvent &&event) {
+        events_pending_.fetch_add(1, std::memory_order_relaxed);
+        events_.push(std::move(event));
+        // Wake the consumer once per batch rather than once per host
+        if (notify_ && !notify_pending_.exchange(true, std::memory_order_acq_rel)) {
+            notify_();
+        }
     }
-    while (fgets(buffer.data(), static_cast<int>(buffer.size()), pipe) != nullptr) {
-        result += buffer.data();
+
+    // Caller holds tasks_mutex_
+    size_t queued_locked() const {
+        return pending_.size() - cancelled_pending_.size();
     }
-    _pclose(pipe);
-    return result;
-}
-#endif
-
-#if defined(__linux__)
-std::string linux_run_nmap_xml(const std::string &targets, const std::string &nmap_path) {
-    // Note: " -oX - " -> XML to stdout
-    std::string cmd = nmap_path + " -oX - " + targets + " 2>/dev/null";
-    std::array<char, 4096> buffer;
-    std::string result;
-
-    FILE* pipe = popen(cmd.c_str(), "r");
-    if (!pipe) {
-        throw std::runtime_error("Failed to run nmap (is it installed and in PATH?)");
+
+    // Caller holds tasks_mutex_; restart the counters when the scanner was idle
+    void reset_stats_if_idle_locked() {
+        if (queued_locked() == 0 && running_.empty() && jobs_.empty()) {
+            busy_since_ = std::chrono::steady_clock::now();
+            hosts_.store(0, std::memory_order_relaxed);
+            completed_ = 0;
+            cancelled_ = 0;
+        }
     }
-    while (fgets(buffer.data(), static_cast<int>(buffer.size()), pipe) != nullptr) {
-        result += buffer.data();
+
+    // Caller holds tasks_mutex_
+    uint64_t push_locked(const std::string &target, const std::string &cidr, int priority,
+                         std::vector<std::string> options, uint64_t job = 0, bool discovery = false) {
+        const uint64_t id = next_id_++;
+        pending_.push(ScanTask{id, target, cidr, priority, next_sequence_++, std::move(options), job, discovery});
+        queued_ids_.insert(id);
+        return id;
     }
-    pclose(pipe);
-    return result;
-}
-#endif
-
-std::string run_nmap(const std::string &targets, std::string nmap_path = "") {
-    // Cross-platform nmap runner (synchronous) — return result directly
-    #if defined(_WIN32) || defined(_WIN64)
-        if (nmap_path.empty()) { nmap_path = "C:\\Program Files (x86)\\Nmap\\nmap.exe"; }
-        return win_run_nmap_xml(targets, nmap_path);
-    #elif defined(__linux__)
-        if (nmap_path.empty()) { nmap_path = "/usr/bin/nmap"; }
-        return linux_run_nmap_xml(targets, nmap_path);
-    #else
-        throw std::runtime_error("Unsupported platform for running nmap");
-    #endif
-}
-
-void save_devices(const std::vector<DeviceInfo> &devices, const std::string &cidr = "default") {
-    std::cout << "Saving " << devices.size() << " devices for network: " << cidr << std::endl;
-    std::lock_guard<std::mutex> lock(nmapVisualizerGlobals::networks_mutex);
-    nmapVisualizerGlobals::networks.push_back(Network(cidr, devices));
-}
-
-std::vector<DeviceInfo> get_devices(const std::string &cidr = "default") {
-    std::lock_guard<std::mutex> lock(nmapVisualizerGlobals::networks_mutex);
-    for (const auto& network : nmapVisualizerGlobals::networks) {
-        if (network.cidr == cidr) {
-            return network.devices;
+
+    // Caller holds tasks_mutex_
+    bool cancel_locked(uint64_t id) {
+        auto it = running_.find(id);
+        if (it != running_.end()) {
+            it->second.cancelled = true;
+            kill_nmap(it->second.process);
+            return true;
         }
+        // Pending entries are skipped lazily when a worker pops them
+        if (!queued_ids_.count(id)) return false;
+        return cancelled_pending_.insert(id).second;
     }
-    return {};
-}
-
-std::vector<DeviceInfo> parse_nmap_xml(const std::string &xmlData) {
-    std::vector<DeviceInfo> devices;
-    try {
-        xmlDocPtr doc = xmlParseMemory(xmlData.c_str(), xmlData.size());
-        if (!doc) throw std::runtime_error("Failed to parse XML");
-
-        xmlNodePtr root = xmlDocGetRootElement(doc);
-        for (xmlNodePtr hostNode = root->children; hostNode; hostNode = hostNode->next) {
-            if (hostNode->type == XML_ELEMENT_NODE && xmlStrcmp(hostNode->name, BAD_CAST "host") == 0) {
-            std::string ipAddress;
-            std::string macAddress;
-            std::string vendor;
-            std::string deviceType;
-            std::vector<Port> ports;
-            std::string operatingSystem;
-
-            // Use libxml2 (xml2) APIs to walk the hostNode children and fill fields
-            for (xmlNodePtr child = hostNode->children; child; child = child->next) {
-                if (child->type != XML_ELEMENT_NODE) continue;
-
-                if (xmlStrcmp(child->name, BAD_CAST "address") == 0) {
-                    xmlChar* addrType = xmlGetProp(child, BAD_CAST "addrtype");
-                    xmlChar* addr     = xmlGetProp(child, BAD_CAST "addr");
-                    xmlChar* vend     = xmlGetProp(child, BAD_CAST "vendor");
-
-                    if (addrType) {
-                        const std::string at(reinterpret_cast<const char*>(addrType));
-                        if ((at == "ipv4" || at == "ipv6") && addr) {
-                            ipAddress = reinterpret_cast<const char*>(addr);
-                        } else if (at == "mac" && addr) {
-                            macAddress = reinterpret_cast<const char*>(addr);
-                            if (vend) vendor = reinterpret_cast<const char*>(vend);
-                        }
-                    }
 
-                    if (addrType) xmlFree(addrType);
-                    if (addr)     xmlFree(addr);
-                    if (vend)     xmlFree(vend);
-                } else if (xmlStrcmp(child->name, BAD_CAST "hostnames") == 0) {
-                    for (xmlNodePtr hn = child->children; hn; hn = hn->next) {
-                        if (hn->type != XML_ELEMENT_NODE) continue;
-                        if (xmlStrcmp(hn->name, BAD_CAST "hostname") == 0) {
-                            xmlChar* nameAttr = xmlGetProp(hn, BAD_CAST "name");
-                            if (nameAttr) {
-                                deviceType = reinterpret_cast<const char*>(nameAttr);
-                                xmlFree(nameAttr);
-                                break; // use first hostname
-                            }
-                        }
-                    }
-                } else if (xmlStrcmp(child->name, BAD_CAST "ports") == 0) {
-                    for (xmlNodePtr portNode = child->children; portNode; portNode = portNode->next) {
-                        if (portNode->type != XML_ELEMENT_NODE) continue;
-                        if (xmlStrcmp(portNode->name, BAD_CAST "port") != 0) continue;
-
-                        int portNumber = 0;
-                        xmlChar* portid = xmlGetProp(portNode, BAD_CAST "portid");
-                        xmlChar* proto  = xmlGetProp(portNode, BAD_CAST "protocol");
-                        if (portid) {
-                            try { portNumber = std::stoi(reinterpret_cast<const char*>(portid)); } catch (...) { portNumber = 0; }
-                            xmlFree(portid);
-                        }
-                        std::string protocol = proto ? reinterpret_cast<const char*>(proto) : std::string();
-                        if (proto) xmlFree(proto);
-
-                        std::string state;
-                        std::string service;
-
-                        for (xmlNodePtr pchild = portNode->children; pchild; pchild = pchild->next) {
-                            if (pchild->type != XML_ELEMENT_NODE) continue;
-                            if (xmlStrcmp(pchild->name, BAD_CAST "state") == 0) {
-                                xmlChar* stateAttr = xmlGetProp(pchild, BAD_CAST "state");
-                                if (stateAttr) { state = reinterpret_cast<const char*>(stateAttr); xmlFree(stateAttr); }
-                            } else if (xmlStrcmp(pchild->name, BAD_CAST "service") == 0) {
-                                xmlChar* sname     = xmlGetProp(pchild, BAD_CAST "name");
-                                xmlChar* sproduct  = xmlGetProp(pchild, BAD_CAST "product");
-                                xmlChar* sversion  = xmlGetProp(pchild, BAD_CAST "version");
-                                xmlChar* sextrainfo= xmlGetProp(pchild, BAD_CAST "extrainfo");
-                                xmlChar* sostype   = xmlGetProp(pchild, BAD_CAST "ostype");
-
-                                if (sname) {
-                                    service = reinterpret_cast<const char*>(sname);
-                                }
-                                if (sproduct && service.empty() == false) {
-                                    service += " (" + std::string(reinterpret_cast<const char*>(sproduct));
-                                    if (sversion) service += " " + std::string(reinterpret_cast<const char*>(sversion));
-                                    service += ")";
-                                } else if (sproduct && service.empty()) {
-                                    service = reinterpret_cast<const char*>(sproduct);
-                                    if (sversion) service += " " + std::string(reinterpret_cast<const char*>(sversion));
-                                }
-                                if (sextrainfo) service += " " + std::string(reinterpret_cast<const char*>(sextrainfo));
-                                if (sostype) service += " [os:" + std::string(reinterpret_cast<const char*>(sostype)) + "]";
-
-                                if (sname)      xmlFree(sname);
-                                if (sproduct)   xmlFree(sproduct);
-                                if (sversion)   xmlFree(sversion);
-                                if (sextrainfo) xmlFree(sextrainfo);
-                                if (sostype)    xmlFree(sostype);
-                            }
-                        }
-
-                        ports.emplace_back(portNumber, protocol, state, service);
-                    }
-                } else if (xmlStrcmp(child->name, BAD_CAST "os") == 0) {
-                    for (xmlNodePtr osChild = child->children; osChild; osChild = osChild->next) {
-                        if (osChild->type != XML_ELEMENT_NODE) continue;
-                        if (xmlStrcmp(osChild->name, BAD_CAST "osmatch") == 0) {
-                            xmlChar* nameAttr = xmlGetProp(osChild, BAD_CAST "name");
-                            if (nameAttr) {
-                                operatingSystem = reinterpret_cast<const char*>(nameAttr);
-                                xmlFree(nameAttr);
-                                break;
-                            }
-                        }
+    // Report a finished task, or advance its incremental job
+    void task_done(const ScanTask &task, bool was_cancelled) {
+        if (task.job == 0) {
+            publish(ScanEvent{was_cancelled ? ScanEvent::Kind::Cancelled : ScanEvent::Kind::Finished,
+                              task.id, task.target, task.cidr, std::nullopt, {}, {}});
+            return;
+        }
+
+        std::vector<ScanEvent> events;
+        size_t queued = 0;
+        {
+            auto lock = trace::timed_lock(tasks_mutex_, "scanner queue lock");
+            auto it = jobs_.find(task.job);
+            if (it == jobs_.end()) return;
+            IncrementalJob& job = it->second;
+            job.tasks.erase(task.id);
+            if (was_cancelled) job.cancelled = true;
+            if (!job.tasks.empty()) return;
+
+            if (job.discovering && !job.cancelled) {
+                job.discovering = false;
+                RescanPlan plan = plan_rescan(job.alive, job.prior.get(), job.ttl_seconds,
+                                              static_cast<int64_t>(std::time(nullptr)));
+                job.alive.clear();
+                if (!plan.unchanged.empty()) {
+                    hosts_.fetch_add(plan.unchanged.size(), std::memory_order_relaxed);
+                    events.push_back(ScanEvent{ScanEvent::Kind::Alive, task.job, job.target, job.cidr, std::nullopt,
+                                               std::move(plan.unchanged), {}});
+                }
+                // Batch addresses so each nmap process amortizes its startup
+                constexpr size_t kHostsPerTask = 64;
+                for (size_t i = 0; i < plan.rescan.size(); i += kHostsPerTask) {
+                    std::string targets;
+                    for (size_t j = i; j < std::min(plan.rescan.size(), i + kHostsPerTask); j++) {
+                        if (!targets.empty()) targets += ' ';
+                        targets += plan.rescan[j];
                     }
+                    job.tasks.insert(push_locked(targets, job.cidr, job.priority, job.options, task.job));
+                    queued++;
                 }
             }
-
-            if (ipAddress.empty())        ipAddress = "Unknown";
-            if (macAddress.empty())       macAddress = "Unknown";
-            if (vendor.empty())           vendor = "Unknown";
-            if (deviceType.empty())       deviceType = "Unknown";
-            if (operatingSystem.empty())  operatingSystem = "Unknown";
-
-            devices.emplace_back(ipAddress, macAddress, vendor, deviceType, ports, operatingSystem);
-        }
+            if (job.tasks.empty()) {
+                events.push_back(ScanEvent{job.cancelled ? ScanEvent::Kind::Cancelled : ScanEvent::Kind::Finished,
+                                           task.job, job.target, job.cidr, std::nullopt, {}, {}});
+                jobs_.erase(it);
+            }
         }
-        xmlFreeDoc(doc);
-    } catch (const std::exception e) {
-        std::cerr << "Error parsing Nmap XML: " << e.what() << std::endl;
+        for (size_t i = 0; i < queued; i++) tasks_cv_.notify_one();
+        for (auto& event : events) publish(std::move(event));
     }
-    return devices;
-}
 
-// Parallel nmap scanning - scan multiple targets concurrently
-struct ScanTask {
-    std::string target;
-    std::string cidr;
-    std::future<void> future;
-    bool completed = false;
-};
+    void worker_loop() {
+        trace::recorder().set_thread_name("scan worker");
+        for (;;) {
+            ScanTask task;
+            bool skip = false;
+            {
+                auto lock = trace::timed_lock(tasks_mutex_, "scanner queue lock");
+                tasks_cv_.wait(lock, [this]() { return stopping_ || !pending_.empty(); });
+                if (stopping_) return;
 
-class ParallelScanner {
-private:
-    std::vector<ScanTask> tasks_;
-    std::mutex tasks_mutex_;
-    
-public:
-    // Add a scan task (non-blocking)
-    void add_scan(const std::string& target, const std::string& cidr = "") {
-        std::string actual_cidr = cidr.empty() ? target : cidr;
-        
-        auto future = std::async(std::launch::async, [target, actual_cidr]() {
-            try {
-                std::cout << "Starting parallel scan for: " << target << std::endl;
-                std::string nmapOutput = run_nmap(target, "");
-                auto devices = parse_nmap_xml(nmapOutput);
-                
-                if (!devices.empty()) {
-                    save_devices(devices, actual_cidr);
-                    std::cout << "Completed scan for: " << target << " (" << devices.size() << " devices found)" << std::endl;
+                task = pending_.top();
+                pending_.pop();
+                queued_ids_.erase(task.id);
+                trace::counter("scan", "queued tasks", static_cast<double>(pending_.size()));
+                if (cancelled_pending_.erase(task.id)) {
+                    cancelled_++;
+                    skip = true;
                 } else {
-                    std::cout << "Scan completed for: " << target << " (no devices found)" << std::endl;
+                    running_[task.id] = RunningScan{};
                 }
-            } catch (const std::exception& e) {
-                std::cerr << "Error scanning " << target << ": " << e.what() << std::endl;
             }
-        });
-        
-        std::lock_guard<std::mutex> lock(tasks_mutex_);
-        tasks_.push_back(ScanTask{target, actual_cidr, std::move(future), false});
+
+            if (skip) {
+                task_done(task, true);
+            } else {
+                run_task(task);
+            }
+            idle_cv_.notify_all();
+        }
     }
-    
-    // Check if any scans have completed (non-blocking)
-    bool check_progress() {
-        std::lock_guard<std::mutex> lock(tasks_mutex_);
-        bool any_completed = false;
-        
-        for (auto& task : tasks_) {
-            if (!task.completed && task.future.valid()) {
-                auto status = task.future.wait_for(std::chrono::milliseconds(0));
-                if (status == std::future_status::ready) {
-                    task.future.get(); // collect the result
-                    task.completed = true;
-                    any_completed = true;
+
+    void run_task(const ScanTask &task) {
+        trace::Scope scope("scan", task.discovery ? "nmap discovery" : "nmap scan");
+        size_t found = 0;
+        try {
+            std::clog << "Starting parallel scan for: " << task.target << std::endl;
+            NmapProcess process = start_nmap(task.target, nmap_path_, task.options, niceness_.load(std::memory_order_relaxed));
+            {
+                std::lock_guard<std::mutex> lock(tasks_mutex_);
+                auto& running = running_[task.id];
+                running.process = process;
+                if (running.cancelled) kill_nmap(process);
+            }
+            const uint64_t reported_id = task.job ? task.job : task.id;
+            auto on_progress = [this, &task, reported_id](const ScanProgress &progress) {
+                publish(ScanEvent{ScanEvent::Kind::Progress, reported_id, task.target, task.cidr, std::nullopt, {}, progress});
+            };
+            found = parse_nmap_xml_stream(process.pipe, [this, &task, reported_id](DeviceInfo &&d) {
+                if (task.discovery) {
+                    std::lock_guard<std::mutex> lock(tasks_mutex_);
+                    auto it = jobs_.find(task.job);
+                    if (it != jobs_.end()) it->second.alive.push_back(std::move(d));
+                    return;
                 }
+                hosts_.fetch_add(1, std::memory_order_relaxed);
+                publish(ScanEvent{ScanEvent::Kind::Host, reported_id, task.target, task.cidr, std::move(d), {}, {}});
+            }, on_progress);
+            {
+                std::lock_guard<std::mutex> lock(tasks_mutex_);
+                running_[task.id].process = NmapProcess{};
             }
+            finish_nmap(process);
+            std::clog << "Scan completed for: " << task.target << " (" << found << " devices found)" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error scanning " << task.target << ": " << e.what() << std::endl;
+        }
+
+        bool was_cancelled = false;
+        {
+            std::lock_guard<std::mutex> lock(tasks_mutex_);
+            was_cancelled = running_[task.id].cancelled;
+            running_.erase(task.id);
+            if (was_cancelled) cancelled_++; else completed_++;
         }
-        
-        return any_completed;
+        task_done(task, was_cancelled);
     }
-    
-    // Wait for all scans to complete
-    void wait_all() {
-        std::lock_guard<std::mutex> lock(tasks_mutex_);
-        for (auto& task : tasks_) {
-            if (task.future.valid()) {
-                task.future.wait();
+
+public:
+    // worker_count of 0 means one worker per hardware thread
+    explicit ParallelScanner(size_t worker_count = 0) {
+        if (worker_count == 0) worker_count = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t i = 0; i < worker_count; i++) {
+            workers_.emplace_back(&ParallelScanner::worker_loop, this);
+        }
+    }
+
+    ~ParallelScanner() {
+        {
+            std::lock_guard<std::mutex> lock(tasks_mutex_);
+            stopping_ = true;
+            for (auto& [id, job] : jobs_) job.cancelled = true;
+            for (auto& [id, running] : running_) {
+                running.cancelled = true;
+                kill_nmap(running.process);
             }
         }
+        tasks_cv_.notify_all();
+        for (auto& worker : workers_) worker.join();
+
+        // Tasks nobody will run still end with a Cancelled event, like a cancel()
+        for (;;) {
+            ScanTask task;
+            {
+                std::lock_guard<std::mutex> lock(tasks_mutex_);
+                if (pending_.empty()) break;
+                task = pending_.top();
+                pending_.pop();
+                queued_ids_.erase(task.id);
+                cancelled_pending_.erase(task.id);
+                cancelled_++;
+            }
+            task_done(task, true);
+        }
     }
-    
-    // Get number of active scans
-    int active_count() {
+
+    ParallelScanner(const ParallelScanner&) = delete;
+    ParallelScanner& operator=(const ParallelScanner&) = delete;
+
+    // Called from worker threads whenever new events are queued (e.g. Glib::Dispatcher::emit)
+    void set_notify(std::function<void()> notify) {
+        notify_ = std::move(notify);
+    }
+
+    // Empty path uses the platform default
+    void set_nmap_path(const std::string &nmap_path) {
         std::lock_guard<std::mutex> lock(tasks_mutex_);
-        int count = 0;
-        for (const auto& task : tasks_) {
-            if (!task.completed) count++;
+        nmap_path_ = nmap_path;
+    }
+
+    // Options for scans queued from now on; queued tasks keep theirs
+    void set_profile(const ScanProfile &profile) {
+        std::lock_guard<std::mutex> lock(tasks_mutex_);
+        profile_ = profile;
+    }
+
+    ScanProfile profile() {
+        std::lock_guard<std::mutex> lock(tasks_mutex_);
+        return profile_;
+    }
+
+    size_t worker_count() const { return workers_.size(); }
+
+    // Drain all queued events on the consumer thread, returns how many were handled
+    size_t drain_events(const std::function<void(ScanEvent&&)> &handle) {
+        notify_pending_.store(false, std::memory_order_release);
+        trace::Scope scope("ui", "drain_events");
+        size_t count = 0;
+        while (auto event = events_.pop()) {
+            events_pending_.fetch_sub(1, std::memory_order_relaxed);
+            handle(std::move(*event));
+            count++;
         }
+        trace::counter("scan", "drained events", static_cast<double>(count));
         return count;
     }
-    
-    // Clear completed tasks
-    void clear_completed() {
-        std::lock_guard<std::mutex> lock(tasks_mutex_);
-        auto it = tasks_.begin();
-        while (it != tasks_.end()) {
-            if (it->completed) {
-                it = tasks_.erase(it);
-            } else {
-                ++it;
+
+    // Queue a scan task (non-blocking), returns its id for cancel()
+    uint64_t add_scan(const std::string& target, const std::string& cidr = "", int priority = 0) {
+        uint64_t id;
+        {
+            auto lock = trace::timed_lock(tasks_mutex_, "scanner queue lock");
+            reset_stats_if_idle_locked();
+            id = push_locked(target, cidr.empty() ? target : cidr, priority, profile_.arguments());
+        }
+        tasks_cv_.notify_one();
+        return id;
+    }
+
+    // Split large IPv4 blocks into /shard_prefix pieces scanned concurrently;
+    // every shard reports hosts under the original cidr. Returns all task ids
+    std::vector<uint64_t> add_sharded_scan(const std::string& target, const std::string& cidr = "", int priority = 0) {
+        const std::string network = cidr.empty() ? target : cidr;
+        std::vector<uint64_t> ids;
+        for (const auto& shard : shard_cidr(target, shard_prefix_.load(std::memory_order_relaxed))) {
+            ids.push_back(add_scan(shard, network, priority));
+        }
+        return ids;
+    }
+
+    // Rescan a known network cheaply: sharded ping discovery, then full scans
+    // only of hosts that are new, changed MAC, or were last scanned more than
+    // ttl_seconds ago. Hosts still up and otherwise unchanged come back as one
+    // Kind::Alive event carrying their stored records. Returns a single id that
+    // Finished/Cancelled events and cancel() use for the whole job
+    uint64_t add_incremental_scan(const std::string& target, const std::string& cidr,
+                                  std::shared_ptr<const NetworkData> prior, int64_t ttl_seconds, int priority = 0) {
+        const std::string network = cidr.empty() ? target : cidr;
+        const auto shards = shard_cidr(target, shard_prefix_.load(std::memory_order_relaxed));
+        uint64_t job_id;
+        {
+            auto lock = trace::timed_lock(tasks_mutex_, "scanner queue lock");
+            reset_stats_if_idle_locked();
+            job_id = next_id_++;
+            IncrementalJob& job = jobs_[job_id];
+            job.target = target;
+            job.cidr = network;
+            job.prior = std::move(prior);
+            job.ttl_seconds = ttl_seconds;
+            job.priority = priority;
+            job.options = profile_.arguments();
+            for (const auto& shard : shards) {
+                job.tasks.insert(push_locked(shard, network, priority, profile_.discovery_arguments(), job_id, true));
             }
         }
+        tasks_cv_.notify_all();
+        return job_id;
+    }
+
+    // Nice level of nmap processes started from now on, 0 leaves them at ours
+    void set_niceness(int niceness) { niceness_.store(niceness, std::memory_order_relaxed); }
+
+    // 0 disables sharding
+    void set_shard_prefix(int prefix) { shard_prefix_.store(prefix, std::memory_order_relaxed); }
+    int shard_prefix() const { return shard_prefix_.load(std::memory_order_relaxed); }
+
+    // Cancel a queued or running task (or every task of an incremental scan);
+    // a running nmap is killed. Returns false if unknown
+    bool cancel(uint64_t id) {
+        auto lock = trace::timed_lock(tasks_mutex_, "scanner queue lock");
+        auto job = jobs_.find(id);
+        if (job != jobs_.end()) {
+            job->second.cancelled = true;
+            for (uint64_t task : job->second.tasks) cancel_locked(task);
+            return true;
+        }
+        return cancel_locked(id);
+    }
+
+    void cancel_all() {
+        auto lock = trace::timed_lock(tasks_mutex_, "scanner queue lock");
+        for (auto& [id, job] : jobs_) job.cancelled = true;
+        cancelled_pending_ = queued_ids_;
+        for (auto& [id, running] : running_) {
+            running.cancelled = true;
+            kill_nmap(running.process);
+        }
+    }
+
+    // Block until the queue is empty and no scan is running
+    void wait_all() {
+        std::unique_lock<std::mutex> lock(tasks_mutex_);
+        idle_cv_.wait(lock, [this]() { return pending_.empty() && running_.empty() && jobs_.empty(); });
+    }
+
+    // Get number of queued plus running scans
+    int active_count() {
+        std::lock_guard<std::mutex> lock(tasks_mutex_);
+        return static_cast<int>(queued_locked() + running_.size());
+    }
+
+    ScannerStats stats() {
+        std::lock_guard<std::mutex> lock(tasks_mutex_);
+        ScannerStats s;
+        s.queued = queued_locked();
+        s.running = running_.size();
+        s.completed = completed_;
+        s.cancelled = cancelled_;
+        s.hosts = hosts_.load(std::memory_order_relaxed);
+        s.events_pending = events_pending_.load(std::memory_order_relaxed);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - busy_since_).count();
+        if (elapsed > 0.0) s.hosts_per_second = s.hosts / elapsed;
+        return s;
     }
 };
 
@@ -0,0 +1,53 @@
+// check.hpp
+// Minimal assertions for the unit tests. A failed CHECK prints where and what
+// and the test keeps going; main() returns check::report() so ctest sees the
+// failure.
+#ifndef CHECK_HPP
+#define CHECK_HPP
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace check {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline void fail(const char* file, int line, const std::string &what) {
+    std::cerr << file << ":" << line << ": check failed: " << what << std::endl;
+    failures()++;
+}
+
+inline int report() {
+    if (failures()) std::cerr << failures() << " check(s) failed" << std::endl;
+    return failures() ? 1 : 0;
+}
+
+} // namespace check
+
+#define CHECK(condition) \
+    do { if (!(condition)) check::fail(__FILE__, __LINE__, #condition); } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    do { \
+        const auto& check_actual_ = (actual); \
+        const auto& check_expected_ = (expected); \
+        if (!(check_actual_ == check_expected_)) { \
+            std::ostringstream check_message_; \
+            check_message_ << #actual << " == " << #expected << " (got " << check_actual_ << ", expected " << check_expected_ << ")"; \
+            check::fail(__FILE__, __LINE__, check_message_.str()); \
+        } \
+    } while (0)
+
+// Expression must throw the given exception type
+#define CHECK_THROWS(expression, exception) \
+    do { \
+        bool check_thrown_ = false; \
+        try { (void)(expression); } catch (const exception&) { check_thrown_ = true; } \
+        if (!check_thrown_) check::fail(__FILE__, __LINE__, #expression " throws " #exception); \
+    } while (0)
+
+#endif // CHECK_HPP
@@ -0,0 +1,105 @@
+// test_cidr.cpp
+// parse_ipv4_cidr and shard_cidr, including the /0 and /32 edges and input
+// that is not an IPv4 network.
+#include "../src/utils.hpp"
+#include "check.hpp"
+
+namespace {
+
+void test_parse_valid() {
+    auto cidr = parse_ipv4_cidr("10.1.2.3/16");
+    CHECK(cidr.has_value());
+    if (cidr) {
+        CHECK_EQ(format_ipv4(cidr->base), "10.1.0.0");  // masked to the prefix
+        CHECK_EQ(cidr->prefix, 16);
+    }
+
+    cidr = parse_ipv4_cidr("192.168.1.7");
+    CHECK(cidr.has_value());
+    if (cidr) {
+        CHECK_EQ(format_ipv4(cidr->base), "192.168.1.7");
+        CHECK_EQ(cidr->prefix, 32);
+    }
+
+    cidr = parse_ipv4_cidr("0.0.0.0/0");
+    CHECK(cidr.has_value());
+    if (cidr) {
+        CHECK_EQ(cidr->base, 0u);
+        CHECK_EQ(cidr->prefix, 0);
+    }
+
+    cidr = parse_ipv4_cidr("255.255.255.255/0");
+    CHECK(cidr.has_value() && cidr->base == 0);
+
+    cidr = parse_ipv4_cidr("255.255.255.255/32");
+    CHECK(cidr.has_value() && cidr->base == 0xFFFFFFFFu && cidr->prefix == 32);
+}
+
+void test_parse_invalid() {
+    for (const char* text : {"", "10.0.0", "10.0.0.256", "256.0.0.0/8", "10.0.0.0/33", "10.0.0.0/-1",
+                             "10.0.0.0/", "10.0.0.0/24x", "10.0.0.1x", "10.0.0.1 ", " 10.0.0.1", "+10.0.0.1",
+                             "10.-1.0.0", "10..0.0", "scanme.nmap.org", "fe80::/10", "10.0.0.0/24/8"}) {
+        if (parse_ipv4_cidr(text)) check::fail(__FILE__, __LINE__, std::string("rejects \"") + text + "\"");
+    }
+}
+
+void test_shard() {
+    // /16 into /24s, in address order
+    auto shards = shard_cidr("10.0.0.0/16", 24);
+    CHECK_EQ(shards.size(), 256u);
+    if (shards.size() == 256) {
+        CHECK_EQ(shards.front(), "10.0.0.0/24");
+        CHECK_EQ(shards[1], "10.0.1.0/24");
+        CHECK_EQ(shards.back(), "10.0.255.0/24");
+    }
+
+    // the base is masked before splitting
+    shards = shard_cidr("10.0.0.77/24", 25);
+    CHECK_EQ(shards.size(), 2u);
+    if (shards.size() == 2) {
+        CHECK_EQ(shards[0], "10.0.0.0/25");
+        CHECK_EQ(shards[1], "10.0.0.128/25");
+    }
+
+    // /32 targets, and blocks already no larger than a shard, stay whole
+    shards = shard_cidr("10.0.0.1/32", 24);
+    CHECK(shards.size() == 1 && shards[0] == "10.0.0.1/32");
+    shards = shard_cidr("10.0.0.0/24", 24);
+    CHECK(shards.size() == 1 && shards[0] == "10.0.0.0/24");
+    shards = shard_cidr("10.0.0.0/28", 24);
+    CHECK(shards.size() == 1 && shards[0] == "10.0.0.0/28");
+
+    // /32 shards of a small block
+    shards = shard_cidr("10.0.0.0/30", 32);
+    CHECK_EQ(shards.size(), 4u);
+    if (shards.size() == 4) CHECK_EQ(shards[3], "10.0.0.3/32");
+    // shard prefixes past 32 are clamped
+    CHECK_EQ(shard_cidr("10.0.0.0/30", 40).size(), 4u);
+
+    // /0 is capped at max_shards by using larger shards
+    shards = shard_cidr("0.0.0.0/0", 24);
+    CHECK_EQ(shards.size(), 4096u);
+    if (shards.size() == 4096) {
+        CHECK_EQ(shards.front(), "0.0.0.0/12");
+        CHECK_EQ(shards.back(), "255.240.0.0/12");
+    }
+    shards = shard_cidr("10.0.0.0/8", 24, 16);
+    CHECK_EQ(shards.size(), 16u);
+    if (shards.size() == 16) CHECK_EQ(shards.back(), "10.240.0.0/12");
+
+    // sharding disabled, and targets that are not IPv4 networks, pass through
+    for (const auto& [target, prefix] : {std::pair<std::string, int>{"10.0.0.0/16", 0}, {"10.0.0.0/16", -4},
+                                         {"scanme.nmap.org", 24}, {"fe80::/64", 24}, {"10.0.0.0/33", 24}}) {
+        shards = shard_cidr(target, prefix);
+        if (shards.size() != 1 || shards[0] != target) check::fail(__FILE__, __LINE__, "passes \"" + target + "\" through");
+    }
+}
+
+} // namespace
+
+int main() {
+    test_parse_valid();
+    test_parse_invalid();
+    test_shard();
+    return check::report();
+}
@@ -0,0 +1,343 @@
+// test_database.cpp
+// Scan database round trip, the version 1 -> 2 upgrade on open, recovery
+// from a file whose last segment was cut short, compaction on load, and
+// corrupt segments and records.
+#include <filesystem>
+#include <fstream>
+
+#include "../src/database.hpp"
+#include "check.hpp"
+
+namespace {
+
+std::string temp_path(const std::string &name) {
+    const auto path = std::filesystem::temp_directory_path() / ("nmapvis_test_" + name + ".nvdb");
+    std::filesystem::remove(path);
+    return path.string();
+}
+
+DeviceInfo make_device(const std::string &ip, const std::string &mac, const std::string &vendor, int64_t last_scanned) {
+    DeviceInfo device(ip, mac, vendor, "host-" + ip, {Port(22, "tcp", "open", "ssh"), Port(53, "udp", "closed", "")}, "Linux");
+    device.lastScanned = last_scanned;
+    return device;
+}
+
+template <typename T>
+void put(std::vector<uint8_t> &out, const T &value) {
+    const size_t at = out.size();
+    out.resize(at + sizeof(T));
+    std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+void put_segment(std::vector<uint8_t> &out, uint32_t kind, uint32_t count, std::vector<uint8_t> payload) {
+    payload.resize(scandb::padded(payload.size()), 0);
+    put(out, scandb::SegmentHeader{kind, count, payload.size()});
+    out.insert(out.end(), payload.begin(), payload.end());
+}
+
+// A version 1 file: 40-byte host records without last_scanned
+void write_v1_file(const std::string &path) {
+    std::vector<uint8_t> file;
+    scandb::FileHeader header{};
+    std::memcpy(header.magic, scandb::kMagic, sizeof(header.magic));
+    header.version = 1;
+    put(file, header);
+
+    const std::vector<std::string> strings = {"10.0.0.0/24", "Acme", "printer", "Linux", "ssh"};  // ids 1..5
+    std::vector<uint8_t> payload;
+    for (const auto& s : strings) put(payload, static_cast<uint32_t>(s.size()));
+    for (const auto& s : strings) payload.insert(payload.end(), s.begin(), s.end());
+    put_segment(file, scandb::Strings, static_cast<uint32_t>(strings.size()), payload);
+
+    payload.clear();
+    put(payload, uint32_t{1});  // cidr
+    put(payload, uint32_t{2});  // ports in the segment
+    for (uint8_t last : {1, 2}) {
+        scandb::HostRecord host{};
+        host.ip[0] = 10;
+        host.ip[3] = last;
+        host.family = 4;
+        host.mac[5] = last;
+        host.has_mac = 1;
+        host.vendor = 2;
+        host.device_type = 3;
+        host.os = 4;
+        host.port_count = 1;
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&host);
+        payload.insert(payload.end(), bytes, bytes + scandb::kHostRecordV1Size);
+    }
+    put(payload, scandb::PortRecord{22, static_cast<uint8_t>(Protocol::Tcp), static_cast<uint8_t>(PortState::Open), 5});
+    put(payload, scandb::PortRecord{631, static_cast<uint8_t>(Protocol::Tcp), static_cast<uint8_t>(PortState::Open), 0});
+    put_segment(file, scandb::Hosts, 2, payload);
+
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+}
+
+uint32_t file_version(const std::string &path) {
+    scandb::FileHeader header{};
+    std::ifstream(path, std::ios::binary).read(reinterpret_cast<char*>(&header), sizeof(header));
+    return header.version;
+}
+
+void test_round_trip() {
+    const std::string path = temp_path("round_trip");
+    {
+        ScanDatabase database;
+        database.open(path);
+        database.append("10.0.0.0/24", {make_device("10.0.0.1", "02:00:00:00:00:01", "Acme, Inc.", 1700000000),
+                                        make_device("10.0.0.2", "", "", 0)});
+        // a rescan of 10.0.0.1 replaces it on load
+        database.append("10.0.0.0/24", {make_device("10.0.0.1", "02:00:00:00:00:01", "Other", 1700000100)});
+    }
+    NetworkStore store;
+    CHECK_EQ(ScanDatabase::load_file(path, store), 3u);
+    const NetworkData* network = store.snapshot()->find("10.0.0.0/24");
+    CHECK(network != nullptr);
+    if (network) {
+        CHECK_EQ(network->devices.size(), 2u);
+        const DeviceInfo* host = network->find_ip(IpAddress::parse("10.0.0.1"));
+        CHECK(host != nullptr);
+        if (host) {
+            CHECK_EQ(host->vendor.str(), "Other");
+            CHECK_EQ(host->lastScanned, 1700000100);
+            CHECK(host->macAddress == MacAddress::parse("02:00:00:00:00:01"));
+            CHECK_EQ(host->ports.size(), 2u);
+            if (host->ports.size() == 2) {
+                CHECK_EQ(host->ports[1].portNumber, 53);
+                CHECK(host->ports[1].protocol == Protocol::Udp);
+                CHECK(host->ports[1].state == PortState::Closed);
+                CHECK(host->ports[1].service.empty());
+            }
+        }
+        host = network->find_ip(IpAddress::parse("10.0.0.2"));
+        CHECK(host != nullptr && !host->macAddress.valid());
+    }
+    std::filesystem::remove(path);
+}
+
+void test_upgrade_v1() {
+    const std::string path = temp_path("upgrade_v1");
+    write_v1_file(path);
+
+    // version 1 files load as they are
+    NetworkStore before;
+    CHECK_EQ(ScanDatabase::load_file(path, before), 2u);
+
+    {
+        ScanDatabase database;
+        database.open(path);
+        CHECK(database.is_open());
+        CHECK_EQ(file_version(path), scandb::kVersion);
+        database.append("10.0.0.0/24", {make_device("10.0.0.3", "", "Acme", 1700000000)});
+    }
+
+    NetworkStore store;
+    CHECK_EQ(ScanDatabase::load_file(path, store), 3u);
+    const NetworkData* network = store.snapshot()->find("10.0.0.0/24");
+    CHECK(network != nullptr);
+    if (network) {
+        CHECK_EQ(network->devices.size(), 3u);
+        const DeviceInfo* host = network->find_ip(IpAddress::parse("10.0.0.2"));
+        CHECK(host != nullptr);
+        if (host) {
+            CHECK_EQ(host->vendor.str(), "Acme");
+            CHECK_EQ(host->deviceType.str(), "printer");
+            CHECK_EQ(host->operatingSystem.str(), "Linux");
+            CHECK_EQ(host->lastScanned, 0);  // not recorded by version 1
+            CHECK(host->macAddress == MacAddress::parse("00:00:00:00:00:02"));
+            CHECK_EQ(host->ports.size(), 1u);
+            if (!host->ports.empty()) CHECK_EQ(host->ports[0].portNumber, 631);
+        }
+        host = network->find_ip(IpAddress::parse("10.0.0.1"));
+        CHECK(host != nullptr && host->ports.size() == 1 && host->ports[0].service.str() == "ssh");
+        host = network->find_ip(IpAddress::parse("10.0.0.3"));
+        CHECK(host != nullptr && host->lastScanned == 1700000000);
+    }
+    std::filesystem::remove(path);
+}
+
+void test_truncated_tail() {
+    const std::string path = temp_path("truncated_tail");
+    uintmax_t first_batch_end = 0;
+    {
+        ScanDatabase database;
+        database.open(path);
+        database.append("10.0.0.0/24", {make_device("10.0.0.1", "", "Acme", 1), make_device("10.0.0.2", "", "Acme", 2)});
+        first_batch_end = std::filesystem::file_size(path);
+        // new strings, then the hosts that use them
+        database.append("10.0.1.0/24", {make_device("10.0.1.1", "", "Initech", 3)});
+    }
+    const uintmax_t full = std::filesystem::file_size(path);
+    std::filesystem::resize_file(path, full - 5);
+
+    // the cut Hosts segment is skipped on load and dropped on open
+    NetworkStore partial;
+    CHECK_EQ(ScanDatabase::load_file(path, partial), 2u);
+    CHECK(partial.snapshot()->find("10.0.1.0/24") == nullptr);
+    {
+        ScanDatabase database;
+        database.open(path);
+        const uintmax_t recovered = std::filesystem::file_size(path);
+        CHECK(recovered >= first_batch_end && recovered < full - 5);
+        CHECK_EQ(recovered % 8, 0u);
+        database.append("10.0.1.0/24", {make_device("10.0.1.1", "", "Initech", 3)});
+    }
+    NetworkStore store;
+    CHECK_EQ(ScanDatabase::load_file(path, store), 3u);
+    const NetworkData* network = store.snapshot()->find("10.0.1.0/24");
+    CHECK(network != nullptr);
+    if (network) {
+        const DeviceInfo* host = network->find_ip(IpAddress::parse("10.0.1.1"));
+        CHECK(host != nullptr && host->vendor.str() == "Initech" && host->ports.size() == 2);
+    }
+
+    // a tail shorter than a segment header goes too
+    std::filesystem::resize_file(path, first_batch_end + 3);
+    {
+        ScanDatabase database;
+        database.open(path);
+        CHECK_EQ(std::filesystem::file_size(path), first_batch_end);
+    }
+    std::filesystem::remove(path);
+}
+
+void write_file(const std::string &path, const std::vector<uint8_t> &file) {
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+}
+
+std::vector<uint8_t> v2_header() {
+    std::vector<uint8_t> file;
+    scandb::FileHeader header{};
+    std::memcpy(header.magic, scandb::kMagic, sizeof(header.magic));
+    header.version = scandb::kVersion;
+    put(file, header);
+    return file;
+}
+
+std::vector<uint8_t> strings_payload(const std::vector<std::string> &strings) {
+    std::vector<uint8_t> payload;
+    for (const auto& s : strings) put(payload, static_cast<uint32_t>(s.size()));
+    for (const auto& s : strings) payload.insert(payload.end(), s.begin(), s.end());
+    return payload;
+}
+
+scandb::HostRecord v2_host(uint8_t last, uint8_t family, uint32_t port_count) {
+    scandb::HostRecord host{};
+    host.ip[0] = 10;
+    host.ip[3] = last;
+    host.family = family;
+    host.port_count = port_count;
+    return host;
+}
+
+void test_load_compacting() {
+    const std::string path = temp_path("load_compacting");
+    ScanDatabase database;
+    database.open(path);
+    database.append("10.0.0.0/24", {make_device("10.0.0.1", "", "Acme", 1), make_device("10.0.0.2", "", "Acme", 1)});
+    database.append("10.0.0.0/24", {make_device("10.0.0.1", "", "Acme", 2)});
+
+    // three records for two hosts: kept as they are
+    NetworkStore first;
+    CHECK_EQ(database.load_compacting(first), 3u);
+    CHECK_EQ(ScanDatabase::load_file(path, first), 3u);
+
+    // rescans now outweigh the hosts, so the file is rewritten from the load
+    database.append("10.0.0.0/24", {make_device("10.0.0.1", "", "Acme", 3)});
+    database.append("10.0.0.0/24", {make_device("10.0.0.1", "", "Other", 4)});
+    NetworkStore second;
+    CHECK_EQ(database.load_compacting(second), 5u);
+    CHECK_EQ(second.snapshot()->device_count(), 2u);
+
+    NetworkStore store;
+    CHECK_EQ(ScanDatabase::load_file(path, store), 2u);
+    const NetworkData* network = store.snapshot()->find("10.0.0.0/24");
+    const DeviceInfo* host = network ? network->find_ip(IpAddress::parse("10.0.0.1")) : nullptr;
+    CHECK(host != nullptr && host->vendor.str() == "Other" && host->lastScanned == 4);
+
+    // still open for appending
+    database.append("10.0.0.0/24", {make_device("10.0.0.3", "", "Acme", 5)});
+    NetworkStore after;
+    CHECK_EQ(ScanDatabase::load_file(path, after), 3u);
+    database.close();
+    std::filesystem::remove(path);
+}
+
+void test_corrupt_string_lengths() {
+    const std::string path = temp_path("corrupt_strings");
+    std::vector<uint8_t> file = v2_header();
+    put_segment(file, scandb::Strings, 1, strings_payload({"10.0.0.0/24"}));
+    const size_t good_end = file.size();
+    // a length far past the end of its segment
+    std::vector<uint8_t> payload = strings_payload({"abc"});
+    const uint32_t huge = 0x7FFFFFF0;
+    std::memcpy(payload.data(), &huge, sizeof(huge));
+    put_segment(file, scandb::Strings, 1, payload);
+    payload.clear();
+    put(payload, uint32_t{1});
+    put(payload, uint32_t{0});
+    put(payload, v2_host(1, 4, 0));
+    put_segment(file, scandb::Hosts, 1, payload);
+    write_file(path, file);
+
+    // nothing past the bad segment is read, and open() cuts it off
+    NetworkStore store;
+    CHECK_EQ(ScanDatabase::load_file(path, store), 0u);
+    {
+        ScanDatabase database;
+        database.open(path);
+        CHECK_EQ(std::filesystem::file_size(path), good_end);
+    }
+    std::filesystem::remove(path);
+}
+
+void test_bad_records_skipped() {
+    const std::string path = temp_path("bad_records");
+    std::vector<uint8_t> file = v2_header();
+    put_segment(file, scandb::Strings, 2, strings_payload({"10.0.0.0/24", "ssh"}));
+    std::vector<uint8_t> payload;
+    put(payload, uint32_t{1});
+    put(payload, uint32_t{3});
+    put(payload, v2_host(1, 4, 1));  // port with an unknown protocol
+    put(payload, v2_host(2, 9, 0));  // unknown address family
+    put(payload, v2_host(3, 4, 2));
+    put(payload, scandb::PortRecord{22, 99, static_cast<uint8_t>(PortState::Open), 2});
+    put(payload, scandb::PortRecord{22, static_cast<uint8_t>(Protocol::Tcp), static_cast<uint8_t>(PortState::Open), 2});
+    put(payload, scandb::PortRecord{23, static_cast<uint8_t>(Protocol::Tcp), static_cast<uint8_t>(PortState::Closed), 0});
+    put_segment(file, scandb::Hosts, 3, payload);
+    write_file(path, file);
+
+    NetworkStore store;
+    CHECK_EQ(ScanDatabase::load_file(path, store), 1u);
+    const NetworkData* network = store.snapshot()->find("10.0.0.0/24");
+    CHECK(network != nullptr && network->devices.size() == 1);
+    if (network && network->devices.size() == 1) {
+        const DeviceInfo& host = *network->devices[0];
+        CHECK(host.ipAddress == IpAddress::parse("10.0.0.3"));
+        CHECK(host.ports.size() == 2 && host.ports[0].service.str() == "ssh" && host.ports[1].state == PortState::Closed);
+    }
+    std::filesystem::remove(path);
+}
+
+void test_not_a_database() {
+    const std::string path = temp_path("not_a_database");
+    std::ofstream(path) << "definitely not a scan database";
+    ScanDatabase database;
+    CHECK_THROWS(database.open(path), std::runtime_error);
+    NetworkStore store;
+    CHECK_THROWS(ScanDatabase::load_file(path, store), std::runtime_error);
+    std::filesystem::remove(path);
+}
+
+} // namespace
+
+int main() {
+    test_round_trip();
+    test_upgrade_v1();
+    test_truncated_tail();
+    test_load_compacting();
+    test_corrupt_string_lengths();
+    test_bad_records_skipped();
+    test_not_a_database();
+    return check::report();
+}
@@ -0,0 +1,123 @@
+// test_diff.cpp
+// diff_networks on rescans where a MAC address moves to another IP, both
+// through the store and against a scan run indexed with make_network.
+#include "../src/diff.hpp"
+#include "check.hpp"
+
+namespace {
+
+DeviceInfo make_device(const std::string &ip, const std::string &mac, std::vector<Port> ports = {}) {
+    return DeviceInfo(ip, mac, "Acme", "", std::move(ports), "Linux");
+}
+
+const HostDiff* find_host(const NetworkDiff &diff, HostChange kind, const std::string &ip) {
+    for (const auto& host : diff.hosts) {
+        const auto& device = host.after ? host.after : host.before;
+        if (host.kind == kind && device->ipAddress == IpAddress::parse(ip)) return &host;
+    }
+    return nullptr;
+}
+
+void test_mac_moves_in_store() {
+    NetworkStore store;
+    auto before = store.upsert("10.0.0.0/24", {make_device("10.0.0.1", "02:00:00:00:00:01"),
+                                               make_device("10.0.0.2", "02:00:00:00:00:02")});
+    // DHCP handed the first host a new address
+    auto after = store.upsert("10.0.0.0/24", {make_device("10.0.0.3", "02:00:00:00:00:01")});
+
+    const NetworkData* old_network = before->find("10.0.0.0/24");
+    const NetworkData* new_network = after->find("10.0.0.0/24");
+    CHECK(old_network && new_network);
+    if (!old_network || !new_network) return;
+
+    // the store keeps the old record; the MAC now leads to the new one
+    CHECK_EQ(new_network->devices.size(), 3u);
+    const DeviceInfo* owner = new_network->find_mac(MacAddress::parse("02:00:00:00:00:01"));
+    CHECK(owner != nullptr && owner->ipAddress == IpAddress::parse("10.0.0.3"));
+    CHECK(new_network->find_ip(IpAddress::parse("10.0.0.1")) != nullptr);
+
+    NetworkDiff diff = diff_networks(old_network, new_network);
+    CHECK_EQ(diff.added, 1u);
+    CHECK_EQ(diff.removed, 0u);
+    CHECK_EQ(diff.changed, 0u);
+    CHECK(find_host(diff, HostChange::Added, "10.0.0.3") != nullptr);
+
+    // rescanning the old address without a MAC keeps the moved MAC where it is
+    after = store.upsert("10.0.0.0/24", {make_device("10.0.0.1", "")});
+    new_network = after->find("10.0.0.0/24");
+    owner = new_network->find_mac(MacAddress::parse("02:00:00:00:00:01"));
+    CHECK(owner != nullptr && owner->ipAddress == IpAddress::parse("10.0.0.3"));
+}
+
+void test_mac_moves_in_scan_run() {
+    NetworkStore store;
+    auto snapshot = store.upsert("10.0.0.0/24", {make_device("10.0.0.1", "02:00:00:00:00:01"),
+                                                 make_device("10.0.0.2", "02:00:00:00:00:02")});
+    const NetworkData* baseline = snapshot->find("10.0.0.0/24");
+    CHECK(baseline != nullptr);
+    if (!baseline) return;
+
+    // the run sees the MAC at 10.0.0.3 and no host at 10.0.0.1
+    const std::vector<std::shared_ptr<const DeviceInfo>> seen = {
+        std::make_shared<const DeviceInfo>(make_device("10.0.0.3", "02:00:00:00:00:01")),
+        std::make_shared<const DeviceInfo>(make_device("10.0.0.2", "02:00:00:00:00:02")),
+    };
+    NetworkData run = make_network("10.0.0.0/24", seen);
+    NetworkDiff diff = diff_networks(baseline, &run);
+    CHECK_EQ(diff.cidr, "10.0.0.0/24");
+    CHECK_EQ(diff.added, 1u);
+    CHECK_EQ(diff.removed, 1u);
+    CHECK_EQ(diff.changed, 0u);  // an equal record for 10.0.0.2 is not a change
+    CHECK(find_host(diff, HostChange::Removed, "10.0.0.1") != nullptr);
+    CHECK(find_host(diff, HostChange::Added, "10.0.0.3") != nullptr);
+}
+
+void test_macs_swap() {
+    NetworkStore store;
+    auto before = store.upsert("10.0.0.0/24", {make_device("10.0.0.1", "02:00:00:00:00:01", {Port(22, "tcp", "open", "ssh")}),
+                                               make_device("10.0.0.2", "02:00:00:00:00:02")});
+    auto after = store.upsert("10.0.0.0/24", {make_device("10.0.0.1", "02:00:00:00:00:02"),
+                                              make_device("10.0.0.2", "02:00:00:00:00:01")});
+    const NetworkData* old_network = before->find("10.0.0.0/24");
+    const NetworkData* new_network = after->find("10.0.0.0/24");
+    CHECK(old_network && new_network);
+    if (!old_network || !new_network) return;
+
+    NetworkDiff diff = diff_networks(old_network, new_network);
+    CHECK_EQ(diff.changed, 2u);
+    CHECK_EQ(diff.added + diff.removed, 0u);
+    const HostDiff* first = find_host(diff, HostChange::Changed, "10.0.0.1");
+    CHECK(first != nullptr);
+    if (first) {
+        CHECK(first->mac_changed);
+        CHECK_EQ(first->ports.size(), 1u);  // 22/tcp no longer listed
+        CHECK(first->ports.size() == 1 && first->ports[0].closed());
+    }
+    CHECK_EQ(diff.ports_closed, 1u);
+
+    // each MAC leads to its new address
+    CHECK(new_network->find_mac(MacAddress::parse("02:00:00:00:00:01"))->ipAddress == IpAddress::parse("10.0.0.2"));
+    CHECK(new_network->find_mac(MacAddress::parse("02:00:00:00:00:02"))->ipAddress == IpAddress::parse("10.0.0.1"));
+}
+
+void test_null_sides() {
+    NetworkStore store;
+    auto snapshot = store.upsert("10.0.0.0/24", {make_device("10.0.0.1", ""), make_device("", "02:00:00:00:00:09")});
+    const NetworkData* network = snapshot->find("10.0.0.0/24");
+    CHECK(network != nullptr);
+    if (!network) return;
+    CHECK_EQ(diff_networks(nullptr, network).added, 2u);
+    CHECK_EQ(diff_networks(network, nullptr).removed, 2u);
+    CHECK(diff_networks(network, network).empty());
+    CHECK(diff_networks(nullptr, nullptr).empty());
+}
+
+} // namespace
+
+int main() {
+    test_mac_moves_in_store();
+    test_mac_moves_in_scan_run();
+    test_macs_swap();
+    test_null_sides();
+    return check::report();
+}
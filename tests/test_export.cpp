@@ -0,0 +1,68 @@
+// test_export.cpp
+// CSV export: header, column order and RFC 4180 quoting of fields holding
+// commas, quotes and line breaks.
+#include "../src/export.hpp"
+#include "check.hpp"
+
+namespace {
+
+std::string export_csv(const StoreSnapshot &snapshot, size_t jobs) {
+    std::FILE* out = std::tmpfile();
+    CHECK(out != nullptr);
+    if (!out) return {};
+    export_snapshot(snapshot, ExportFormat::Csv, out, jobs);
+    std::string text(static_cast<size_t>(std::ftell(out)), '\0');
+    std::rewind(out);
+    text.resize(std::fread(text.data(), 1, text.size(), out));
+    std::fclose(out);
+    return text;
+}
+
+void test_quoting() {
+    NetworkStore store;
+    DeviceInfo quoted("10.0.0.1", "02:00:00:00:00:01", "Acme, Inc.", "the \"big\" printer",
+                      {Port(22, "tcp", "open", "ssh"), Port(80, "tcp", "open", "http,proxy"), Port(23, "tcp", "closed", "telnet")},
+                      "Linux\n2.6");
+    quoted.lastScanned = 1700000000;
+    DeviceInfo plain("10.0.0.2", "", "", "", {}, "");
+    store.upsert("10.0.0.0/24", {quoted, plain});
+
+    const std::string expected =
+        "network,ip,mac,vendor,hostname,os,last_scanned,open_ports\n"
+        "10.0.0.0/24,10.0.0.1,02:00:00:00:00:01,\"Acme, Inc.\",\"the \"\"big\"\" printer\",\"Linux\n2.6\",1700000000,"
+        "\"22/tcp(ssh);80/tcp(http,proxy)\"\n"
+        "10.0.0.0/24,10.0.0.2,,,,,0,\n";
+    CHECK_EQ(export_csv(*store.snapshot(), 1), expected);
+}
+
+void test_carriage_return_and_ipv6() {
+    NetworkStore store;
+    store.upsert("2001:db8::/64", {DeviceInfo("2001:db8::1", "", "Acme\r", "", {}, "")});
+    const std::string expected =
+        "network,ip,mac,vendor,hostname,os,last_scanned,open_ports\n"
+        "2001:db8::/64,2001:db8::1,,\"Acme\r\",,,0,\n";
+    CHECK_EQ(export_csv(*store.snapshot(), 1), expected);
+}
+
+// Rows come out in store order whatever the number of formatting threads
+void test_parallel_order() {
+    NetworkStore store;
+    std::vector<DeviceInfo> devices;
+    for (int i = 0; i < 5000; i++) {
+        devices.emplace_back("10.0." + std::to_string(i / 256) + "." + std::to_string(i % 256), "", "Vendor, " + std::to_string(i),
+                             "", std::vector<Port>{}, "");
+    }
+    store.upsert("10.0.0.0/16", std::move(devices));
+    const std::string serial = export_csv(*store.snapshot(), 1);
+    CHECK_EQ(export_csv(*store.snapshot(), 4), serial);
+    CHECK_EQ(std::count(serial.begin(), serial.end(), '\n'), 5001);
+}
+
+} // namespace
+
+int main() {
+    test_quoting();
+    test_carriage_return_and_ipv6();
+    test_parallel_order();
+    return check::report();
+}
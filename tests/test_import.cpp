@@ -0,0 +1,63 @@
+// test_import.cpp
+// import_nmap_files: which network imported hosts are saved under, given the
+// networks already stored and the targets on each file's nmap command line.
+#include <filesystem>
+#include <fstream>
+
+#include "../src/utils.hpp"
+#include "check.hpp"
+
+namespace {
+
+std::string write_scan(const std::string &name, const std::string &args, const std::vector<std::string> &ips) {
+    const auto path = std::filesystem::temp_directory_path() / ("nmapvis_test_" + name + ".xml");
+    std::ofstream out(path);
+    out << "<?xml version=\"1.0\"?>\n<nmaprun scanner=\"nmap\" args=\"" << args << "\">\n";
+    for (const auto& ip : ips) {
+        out << "<host><status state=\"up\"/><address addr=\"" << ip << "\" addrtype=\"ipv4\"/></host>\n";
+    }
+    out << "</nmaprun>\n";
+    return path.string();
+}
+
+bool holds(const std::string &cidr, const std::string &ip) {
+    const NetworkData* network = nmapVisualizerGlobals::store.snapshot()->find(cidr);
+    return network && network->find_ip(IpAddress::parse(ip));
+}
+
+void test_networks() {
+    nmapVisualizerGlobals::store.clear();
+    nmapVisualizerGlobals::store.upsert("10.0.0.0/16", {DeviceInfo("10.0.5.1", "", "", "", {}, "")});
+    nmapVisualizerGlobals::store.upsert("10.0.7.0/24", {DeviceInfo("10.0.7.1", "", "", "", {}, "")});
+
+    const std::vector<std::string> paths = {
+        // stored networks win over the command line; the narrowest one holds the host
+        write_scan("stored", "nmap -sV -oX out.xml 10.0.0.0/8", {"10.0.7.9", "10.0.9.9"}),
+        // the narrowest target containing each host
+        write_scan("targets", "nmap -p 22 --exclude 192.168.1.1 192.168.0.0/16 192.168.1.0/25 172.16.0.5", {"192.168.1.5", "192.168.1.200", "172.16.0.5"}),
+        // nothing to go by: the /24
+        write_scan("fallback", "nmap scanme.example", {"172.20.3.4"}),
+    };
+    ImportStats stats = import_nmap_files(paths, 2);
+    CHECK_EQ(stats.hosts, 6u);
+    CHECK_EQ(stats.failed, 0u);
+
+    CHECK(holds("10.0.7.0/24", "10.0.7.9"));
+    CHECK(holds("10.0.0.0/16", "10.0.9.9"));
+    CHECK(holds("192.168.1.0/25", "192.168.1.5"));
+    CHECK(holds("192.168.0.0/16", "192.168.1.200"));
+    CHECK(holds("172.16.0.5", "172.16.0.5"));
+    CHECK(holds("172.20.3.0/24", "172.20.3.4"));
+    // no host is saved twice
+    CHECK_EQ(nmapVisualizerGlobals::store.snapshot()->device_count(), 8u);
+    CHECK(nmapVisualizerGlobals::store.snapshot()->find("10.0.0.0/8") == nullptr);
+
+    for (const auto& path : paths) std::filesystem::remove(path);
+}
+
+} // namespace
+
+int main() {
+    test_networks();
+    return check::report();
+}
@@ -0,0 +1,125 @@
+// test_query.cpp
+// Query::parse: every field, negation and substring flags, bare IPv6 terms,
+// and the errors the filter bar reports.
+#include "../src/query.hpp"
+#include "check.hpp"
+
+namespace {
+
+QueryTerm only_term(const std::string &text) {
+    Query query = Query::parse(text);
+    CHECK_EQ(query.terms.size(), 1u);
+    return query.terms.empty() ? QueryTerm{} : query.terms.front();
+}
+
+void test_fields() {
+    QueryTerm term = only_term("port:22");
+    CHECK(term.field == QueryField::Port);
+    CHECK_EQ(term.port, 22);
+    CHECK(term.protocol == Protocol::Unknown);
+
+    term = only_term("PORT:53/UDP");
+    CHECK(term.field == QueryField::Port);
+    CHECK_EQ(term.port, 53);
+    CHECK(term.protocol == Protocol::Udp);
+
+    term = only_term("port:65535");
+    CHECK_EQ(term.port, 65535);
+
+    term = only_term("service:SSH");
+    CHECK(term.field == QueryField::Service);
+    CHECK_EQ(term.value, "ssh");
+    CHECK(!term.substring);
+
+    term = only_term("os:~Linux");
+    CHECK(term.field == QueryField::Os);
+    CHECK(term.substring);
+    CHECK_EQ(term.value, "linux");
+
+    CHECK(only_term("vendor:cisco").field == QueryField::Vendor);
+    CHECK(only_term("host:printer").field == QueryField::Host);
+
+    term = only_term("printer");
+    CHECK(term.field == QueryField::Text);
+    CHECK(term.substring);
+
+    term = only_term("-port:23");
+    CHECK(term.negate);
+    CHECK_EQ(term.port, 23);
+
+    // a lone "-" is a word, not a negation
+    term = only_term("-");
+    CHECK(term.field == QueryField::Text);
+    CHECK(!term.negate);
+}
+
+void test_addresses() {
+    QueryTerm term = only_term("ip:10.1.2.3");
+    CHECK(term.field == QueryField::Ip);
+    CHECK_EQ(term.prefix, 32);
+    CHECK(term.address == IpAddress::parse("10.1.2.3"));
+
+    term = only_term("net:10.1.0.0/16");
+    CHECK(term.field == QueryField::Net);
+    CHECK_EQ(term.prefix, 16);
+
+    term = only_term("net:0.0.0.0/0");
+    CHECK_EQ(term.prefix, 0);
+
+    // bare IPv6 addresses and networks need no field prefix
+    term = only_term("fe80::1");
+    CHECK(term.field == QueryField::Ip);
+    CHECK_EQ(term.prefix, 128);
+    CHECK(term.address == IpAddress::parse("fe80::1"));
+
+    term = only_term("2001:db8::/32");
+    CHECK(term.field == QueryField::Net);
+    CHECK_EQ(term.prefix, 32);
+
+    term = only_term("-::1");
+    CHECK(term.field == QueryField::Ip);
+    CHECK(term.negate);
+
+    // an unknown field that is no address is plain text
+    term = only_term("foo:bar");
+    CHECK(term.field == QueryField::Text);
+    CHECK_EQ(term.value, "foo:bar");
+}
+
+void test_state() {
+    Query query = Query::parse("port:22 state:closed");
+    CHECK(query.port_state == PortState::Closed);
+    CHECK(query.ports_constrained);
+
+    query = Query::parse("os:linux");
+    CHECK(query.port_state == PortState::Open);
+    CHECK(!query.ports_constrained);
+
+    // a negated state does not change the state port terms require
+    query = Query::parse("state:open -state:filtered");
+    CHECK(query.port_state == PortState::Open);
+
+    query = Query::parse("  port:22\t service:http  ");
+    CHECK_EQ(query.terms.size(), 2u);
+
+    CHECK(Query::parse("").empty());
+    CHECK(Query::parse("   ").empty());
+}
+
+void test_errors() {
+    for (const char* text : {"port:", "port:abc", "port:70000", "port:123456", "port:22/xyz", "port:-1",
+                             "state:bogus", "state:open state:closed", "ip:nope", "ip:10.0.0.300",
+                             "net:10.0.0.0/33", "net:10.0.0.0/", "net:10.0.0.0/x", "net:fe80::/129", "os:", "os:~"}) {
+        CHECK_THROWS(Query::parse(text), std::invalid_argument);
+    }
+}
+
+} // namespace
+
+int main() {
+    test_fields();
+    test_addresses();
+    test_state();
+    test_errors();
+    return check::report();
+}